@@ -0,0 +1,27 @@
+#ifndef ACCELWINDOW_H_
+#define ACCELWINDOW_H_
+
+#include "stm32f4xx.h"
+
+#define ACCEL_WINDOW_CYCLES     10      // controller cycles, one Hall sensor step is 0.25m/s^2 over 0.2s at 100 steps/m
+#define ACCEL_WINDOW_SIZE       (2 * ACCEL_WINDOW_CYCLES + 1)
+
+/** \brief The Hall sensor positions of the last cycles and the acceleration the wheel is compared with
+ *
+ * Within one cycle a single Hall sensor step is already 25m/s^2 at 100 steps/m, so the acceleration of the
+ * wheel is taken from the positions of a window of cycles instead.
+ */
+typedef struct
+{
+    int32_t pos[ACCEL_WINDOW_SIZE];     // Hall sensor position at the end of the cycle
+    float accel[ACCEL_WINDOW_SIZE];     // m/s^2 reference acceleration during the cycle
+    uint8_t position;                   // where the next cycle goes
+    uint8_t count;                      // cycles in the window so far
+} accelwindow_t;
+
+void resetAccelWindow(accelwindow_t * window);
+void addAccelWindow(accelwindow_t * window, int32_t pos, float accel);
+float getWindowSpeed(const accelwindow_t * window, float steps_per_meter);
+int8_t getWindowAcceleration(const accelwindow_t * window, float steps_per_meter, float * wheel, float * reference);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef AUTOTUNE_H_
+#define AUTOTUNE_H_
+
+#include "stm32f4xx.h"
+
+#define AUTOTUNE_HYSTERESIS         2       // Hall sensor steps around the hold position the relay does not switch within
+#define AUTOTUNE_SETTLE_PERIODS     2       // oscillation periods ignored until the oscillation is stable
+#define AUTOTUNE_MEASURE_PERIODS    4       // oscillation periods the ultimate gain and period are averaged over
+#define AUTOTUNE_MAX_CYCLES         1500    // controller cycles, 30s, the experiment is aborted when it did not finish by then
+#define AUTOTUNE_MAX_AMPLITUDE      500     // us, the largest relay amplitude allowed
+#define AUTOTUNE_RULES              4
+
+/** \brief The result of the relay experiment
+ */
+typedef struct
+{
+    uint8_t valid;
+    int16_t amplitude;              // relay amplitude in controller output units
+    double ku;                      // ultimate gain, controller output per Hall sensor step
+    double tu;                      // ultimate period in seconds
+    double oscillation;             // Hall sensor steps, half the peak to peak amplitude of the oscillation
+} autotuneresult_t;
+
+void startAutoTune(int16_t amplitude, int32_t hold, int32_t min_pos, int32_t max_pos, double brake);
+uint8_t isAutoTuneActive(void);
+int16_t autoTuneCycle(int32_t pos, int32_t speed, uint8_t abort);
+int8_t stepAutoTune(uint32_t * progress);
+const autotuneresult_t * getAutoTuneResult(void);
+void getAutoTuneGains(uint8_t rule, double * p, double * i, double * d);
+char * getAutoTuneRuleLabel(uint8_t rule);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef BOOTTIME_H_
+#define BOOTTIME_H_
+
+#include "stm32f4xx.h"
+
+/** \brief The stages of the boot sequence in the order they are executed
+ *
+ * The ESC output is started right after the clock, so the ESC gets a valid neutral signal as early as possible.
+ * USB comes last, as its enumeration by the host is interrupt driven and takes long anyway.
+ */
+typedef enum {
+    BOOT_STAGE_MAIN = 0,        // main() entered, clock configured
+    BOOT_STAGE_ESC_OUTPUT,      // ESC pwm output running with neutral pulse width
+    BOOT_STAGE_PERIPHERALS,     // encoder, rtc, spi, uarts
+    BOOT_STAGE_SETTINGS,        // settings loaded from the eeprom
+    BOOT_STAGE_RC_INPUT,        // receiver input running
+    BOOT_STAGE_CONTROLLER,      // controller initialized
+    BOOT_STAGE_USB,             // usb device started
+    BOOT_STAGE_IMU,             // MPU6000 reset and configured
+    BOOT_STAGE_FIRST_CYCLE,     // first controllercycle() finished, first ESC value derived from the RC input
+    BOOT_STAGE_COUNT
+} BOOT_STAGE_t;
+
+void initBootTime(void);
+void setBootStage(BOOT_STAGE_t stage);
+uint32_t getBootStageTime(BOOT_STAGE_t stage);
+char * getBootStageLabel(BOOT_STAGE_t stage);
+
+#endif
@@ -11,6 +11,7 @@
 #define SERVO_MIN          900
 #define SERVO_MAX         2100
 #define NEUTRAL_RANGE     20.0f
+#define ESC_FULL_SCALE     667  // us beyond the ESC neutral range at full stick, 800*10/12 with SBus and 400*10/6 with SumPPM
 
 #define SERVO_ESC    0
 #define SERVO_PITCH  1
@@ -23,4 +24,14 @@
 #define RC_INPUT_PITCH	2
 #define RC_INPUT_AUX	3
 
+/*
+ * Interrupt priorities, the lower the number the more urgent. Everything slow is done in the tasks
+ * of the scheduler, the interrupts do the time critical part only.
+ */
+#define NVIC_PRIORITY_ENCODER       0   // position triggers and brown-out, must be served within microseconds
+#define NVIC_PRIORITY_RC_INPUT      1   // SBus uart and Sum-PPM capture, a late interrupt means a lost byte or a wrong pulse width
+#define NVIC_PRIORITY_SYSTICK       2
+#define NVIC_PRIORITY_SERIAL        3   // uart2/uart3, the IMU and their DMA streams
+#define NVIC_PRIORITY_USB           4
+
 #endif /* CONFIG_H_ */
@@ -5,6 +5,10 @@
 
 #define APP_TX_BUF_SIZE 512
 
+#define Ta  0.02            // cycle time of the controller in seconds
+#define POTI_HYSTERESIS 4   // the max speed and max accel potis have to move by more than that before the limits change
+#define BRAKE_SPEED_FILTER 0.9f // low pass of the speed the brake distance is calculated with, per controller cycle
+
 void setServoNeutralRange(uint16_t forward, uint16_t reverse);
 void initController(void);
 void controllercycle(void);
@@ -19,9 +23,12 @@ int16_t getStick(void);
 
 void resetThrottle(void);
 void resetPosTarget(void);
+void resetPosition(void);
 
 uint16_t getProgrammingSwitch(void);
 uint16_t getEndPointSwitch(void);
+uint16_t getZoneSwitch(void);
+uint16_t getYawStick(void);
 uint16_t getMaxAccelPoti(void);
 uint16_t getMaxSpeedPoti(void);
 
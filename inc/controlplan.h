@@ -0,0 +1,80 @@
+#ifndef CONTROLPLAN_H_
+#define CONTROLPLAN_H_
+
+#include "stm32f4xx.h"
+#include "shaper.h"
+#include "esctable.h"
+#include "zones.h"
+#include "stickcurve.h"
+#include "tracking.h"
+#include "servo.h"
+#include "gainschedule.h"
+
+/** \brief Limits of the ramp filter for one safemode
+ *
+ * max_speed is already multiplied by 10 as the stick values are in 0.1us units within the controller.
+ */
+typedef struct
+{
+    int16_t max_accel;
+    int16_t max_speed;
+} rampfilter_limits_t;
+
+/** \brief Everything the controllercycle() needs from the activesettings, precalculated
+ *
+ * The activesettings are what the user configured, the control plan is what the controller works with.
+ * Whenever a setting is changed, compileControlPlan() derives all values the control loop needs,
+ * e.g. the PID gains are already multiplied with the cycle time, the endpoints are sorted and the
+ * integer division of the ESC scaling is turned into a multiplication.
+ *
+ * The plan is never modified once published. A new plan is compiled into the second buffer and then
+ * made the active one with a single write, hence the control loop either sees the old or the new plan,
+ * never a half applied settings change.
+ */
+typedef struct
+{
+    uint8_t mode;
+    int8_t esc_direction;
+
+    int16_t stick_neutral_pos;
+    int16_t stick_neutral_range;
+    int16_t poti_threshold;                 // stick_neutral_pos + stick_neutral_range, a poti value above that is valid
+
+    rampfilter_limits_t limits[2];          // index 0 for OPERATIONAL, index 1 for all other safemodes
+    int16_t stick_curve_range;
+    float stick_curve_scale;                // STICKCURVE_LUT_SIZE / stick_curve_range
+    int16_t stick_curve[2][STICKCURVE_LUT_SIZE + 1]; // same index as the limits, in 0.1us units
+    uint8_t zone_count;
+    speedzone_t zones[SPEEDZONE_MAX];       // max_speed already multiplied by 10
+
+    double pos_start;                       // pos_start <= pos_end always
+    double pos_end;
+    double max_position_error;
+    double stick_speed_factor;
+
+    gainplan_t gains;                       // the PID gains by target speed and direction, Ta already included
+    uint8_t feedforward_active;
+
+    int16_t esc_neutral_pos;
+    int16_t esc_pos_offset;                 // esc_neutral_pos + esc_neutral_range
+    int16_t esc_neg_offset;                 // esc_neutral_pos - esc_neutral_range
+    int16_t esc_scale;
+    uint32_t esc_scale_reciprocal;          // ceil(2^32/esc_scale), 0 if esc_scale <= 1
+    uint8_t esc_table_active;
+    int16_t esc_table_range;
+    float esc_table_scale;                  // (ESC_TABLE_POINTS - 1) / esc_table_range
+    int16_t esc_table[2][ESC_TABLE_POINTS];
+
+    shaperplan_t shaper;
+    trackingplan_t tracking;
+    servooutput_t servo_outputs[SERVO_CHANNELS];
+} controlplan_t;
+
+void compileControlPlan(void);
+void requestControlPlan(void);
+void updateControlPlan(void);
+const controlplan_t * getControlPlan(void);
+int16_t scaleESCOutput(const controlplan_t * plan, int16_t value);
+uint16_t getESCPulse(const controlplan_t * plan, int16_t value);
+
+#endif
@@ -7,9 +7,16 @@
 
 #define EEPROM_SECTOR_FOR_SETTINGS 0
 
+#define EEPROM_WRITE_DONE       0
+#define EEPROM_WRITE_BUSY       1
+#define EEPROM_WRITE_FAILED     -1
+
 
 uint8_t eeprom_init(void);
 uint32_t eeprom_write_sector_safe(uint8_t *write, uint16_t size, uint16_t sector);
+uint32_t eeprom_write_sector_start(uint8_t *write, uint16_t size, uint16_t sector);
+int8_t eeprom_write_sector_step(void);
+uint8_t eeprom_write_sector_progress(void);
 void eeprom_append_unverified(uint8_t *write, uint32_t size, uint16_t start_sector);
 void eeprom_read_from_address(uint8_t *read, uint32_t size, uint32_t address);
 void eeprom_read_sector(uint8_t *read, uint32_t size, uint16_t start_sector);
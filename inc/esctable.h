@@ -0,0 +1,21 @@
+#ifndef ESCTABLE_H_
+#define ESCTABLE_H_
+
+#include "stm32f4xx.h"
+
+#define ESC_TABLE_POINTS        9       // points per direction, the first is where the ESC starts to move
+#define ESC_TABLE_FORWARD       0
+#define ESC_TABLE_REVERSE       1
+
+#define ESC_CAL_STEPS           16      // pulse widths measured per direction
+#define ESC_CAL_SETTLE_CYCLES   25      // controller cycles to wait after changing the pulse width, 0.5s
+#define ESC_CAL_MEASURE_CYCLES  25      // controller cycles the speed is measured over, 0.5s
+#define ESC_CAL_PAUSE_CYCLES    100     // controller cycles in neutral before the reverse direction, 2s
+#define ESC_CAL_MAX_RANGE       1000    // us, the largest pulse width offset from neutral to calibrate with
+
+void startESCCalibration(int16_t range, int32_t min_pos, int32_t max_pos, double brake);
+uint8_t isESCCalibrationActive(void);
+uint16_t escCalibrationCycle(int32_t pos, int32_t speed, uint8_t abort);
+int8_t stepESCCalibration(uint32_t * progress);
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef FEEDFORWARD_H_
+#define FEEDFORWARD_H_
+
+#include "stm32f4xx.h"
+
+#define FEEDFORWARD_BINS        32      // bins per direction between the end points
+#define FEEDFORWARD_FORWARD     0       // the target position increases
+#define FEEDFORWARD_REVERSE     1
+#define FEEDFORWARD_LEARN_RATE  0.02f   // part of the P and D output moved into the bin every cycle
+#define FEEDFORWARD_MAX_STEP    2.0f    // ESC value units 0.1us, the most a bin changes per cycle
+#define FEEDFORWARD_LIMIT       2000.0f // ESC value units 0.1us, the most thrust the map adds
+
+void clearFeedForward(void);
+float getFeedForward(double pos_start, double pos_end, double pos, uint8_t direction);
+void learnFeedForward(double pos_start, double pos_end, double pos, uint8_t direction, double pid);
+const float * getFeedForwardMap(uint8_t direction);
+
+#endif
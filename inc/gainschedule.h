@@ -0,0 +1,43 @@
+#ifndef GAINSCHEDULE_H_
+#define GAINSCHEDULE_H_
+
+#include "stm32f4xx.h"
+
+#define GAINSCHEDULE_POINTS     6       // breakpoints per direction
+#define GAINSCHEDULE_LUT_SIZE   16      // sections the speed range of a direction is compiled into
+#define GAINSCHEDULE_BLEND      0.1f    // fraction the gains move towards the scheduled ones per cycle, about 0.2s
+
+/** \brief The PID gains at one target speed, between two breakpoints they are interpolated
+ */
+typedef struct
+{
+    int32_t speed;              // Hall sensor steps per second of the target position
+    float p;
+    float i;
+    float d;
+} gainpoint_t;
+
+/** \brief The gains as the PID loop uses them, Ta already included
+ */
+typedef struct
+{
+    float kp;
+    float ki_ta;                // I * Ta
+    float kd_ta;                // D / Ta
+} pidgains_t;
+
+/** \brief The gain schedule of both directions, compiled into a lookup table over the speed
+ */
+typedef struct
+{
+    float scale[2];             // GAINSCHEDULE_LUT_SIZE / the speed of the last breakpoint
+    pidgains_t lut[2][GAINSCHEDULE_LUT_SIZE + 1];
+} gainplan_t;
+
+int8_t addGainPoint(uint8_t direction, int32_t speed, float p, float i, float d);
+void clearGainSchedule(uint8_t direction);
+void compileGainSchedule(gainplan_t * plan, double p, double i, double d);
+void getScheduledGains(const gainplan_t * plan, uint8_t direction, float speed, pidgains_t * gains);
+void blendGains(pidgains_t * current, const pidgains_t * target);
+
+#endif
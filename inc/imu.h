@@ -0,0 +1,65 @@
+#ifndef IMU_H_
+#define IMU_H_
+
+#include "stm32f4xx.h"
+
+/*
+ * MPU6000 registers
+ */
+#define MPU6000_SMPLRT_DIV      0x19
+#define MPU6000_CONFIG          0x1A
+#define MPU6000_GYRO_CONFIG     0x1B
+#define MPU6000_ACCEL_CONFIG    0x1C
+#define MPU6000_FIFO_EN         0x23
+#define MPU6000_INT_STATUS      0x3A
+#define MPU6000_USER_CTRL       0x6A
+#define MPU6000_PWR_MGMT_1      0x6B
+#define MPU6000_SIGNAL_PATH_RESET 0x68
+#define MPU6000_FIFO_COUNTH     0x72
+#define MPU6000_FIFO_R_W        0x74
+#define MPU6000_WHOAMI          0x75
+
+#define MPU6000_WHOAMI_ID       0x68
+#define MPU6000_READ            0x80
+#define MPU6000_FIFO_SIZE       1024
+
+#define IMU_SAMPLE_RATE         1000    // Hz, the MPU6000 writes that many samples into its FIFO
+#define IMU_SAMPLE_SIZE         12      // bytes per FIFO sample, accel xyz and gyro xyz as big-endian int16
+#define IMU_READ_PERIOD         10      // ms, the FIFO is read as one DMA burst that often
+#define IMU_MAX_BURST           32      // samples read with one burst at most
+#define IMU_ACCEL_SCALE         (9.81f / 4096.0f)                   // m/s^2 per LSB at +-8g
+#define IMU_GYRO_SCALE          (3.14159265f / 180.0f / 16.4f)      // rad/s per LSB at +-2000deg/s
+
+#define IMU_ANGLE_FILTER        0.998f  // complementary filter weight of the gyro, about 0.5s time constant at 1kHz
+#define IMU_POS_GAIN            0.2f    // how much of the encoder position error is corrected every controller cycle
+#define IMU_VEL_GAIN            0.05f   // same for the velocity
+#define IMU_SLIP_FILTER         0.8f    // low pass of the slip value, per controller cycle
+
+/** \brief The fused state of the IMU and the Hall sensor
+ *
+ * The board is assumed to be mounted with its x axis along the rope, pointing to increasing Hall sensor
+ * positions, and the z axis up. Positions are in Hall sensor steps, all else in SI units.
+ */
+typedef struct
+{
+    uint8_t present;            // 1 if the MPU6000 answered with the correct id
+    uint32_t samples;           // number of samples processed
+    uint32_t overflows;         // how often the FIFO overflowed and samples got lost
+    float accel[3];             // m/s^2 as measured, including gravity
+    float gyro[3];              // rad/s
+    float pitch;                // rad, slope of the carriage along the rope, positive is nose up
+    float roll;                 // rad, sideways tilt, the swing of the camera
+    float roll_rate;            // rad/s
+    float accel_rope;           // m/s^2 acceleration along the rope without gravity
+    float position;             // Hall sensor steps, fused
+    float velocity;             // Hall sensor steps per second, fused
+    float slip;                 // m/s^2 the wheel accelerates more than the carriage, positive in the direction of motion
+} imustate_t;
+
+void initIMU(void);
+void imuTask(void);
+void fuseIMU(int32_t pos);
+void resyncIMU(void);
+const imustate_t * getIMUState(void);
+
+#endif
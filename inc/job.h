@@ -0,0 +1,39 @@
+#ifndef JOB_H_
+#define JOB_H_
+
+#include "stm32f4xx.h"
+#include "serial_print.h"
+
+#define JOB_PERIOD          2       // ms, a running job gets a step this often at most
+#define JOB_TX_RESERVE      512     // bytes, a step is started only with that much space in the USB transmit buffer
+
+#define JOB_RUNNING         1
+#define JOB_DONE            0
+#define JOB_FAILED          -1
+
+typedef struct job_s job_t;
+
+/** \brief One step of a long running job
+ *
+ * A step must not print more than JOB_TX_RESERVE bytes and must not wait for anything. It updates
+ * position to signal the progress and returns JOB_RUNNING as long as there is more to do.
+ */
+typedef int8_t (*jobstep_t)(job_t * job);
+
+struct job_s
+{
+    char * name;
+    jobstep_t step;
+    Endpoints endpoint;
+    uint32_t position;          // progress, in units of total
+    uint32_t total;
+    uint8_t cancelable;         // 0 if the job must not be stopped half way, e.g. an eeprom write, a step may clear it
+    uint8_t active;
+};
+
+int8_t startJob(char * name, jobstep_t step, uint32_t total, uint8_t cancelable, Endpoints endpoint);
+int8_t cancelJob(void);
+const job_t * getJob(void);
+void jobTask(void);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include "stm32f4xx.h"
+
+#define LATENCY_HISTOGRAM_SIZE      128     // 0..15us exact, above 8 buckets per power of two, the last bucket everything above 245ms
+#define LATENCY_SUB_BUCKETS         8
+
+/** \brief The points in time a stick movement passes on its way to the ESC
+ */
+typedef enum {
+    LATENCY_FRAME = 0,              // the receiver interrupt completed a frame
+    LATENCY_SNAPSHOT,               // the frame got decoded into the servo values
+    LATENCY_CYCLE_START,            // controllercycle() started
+    LATENCY_CYCLE_END               // controllercycle() finished
+} LATENCYSTAMP_t;
+
+/** \brief The latency between two of the stamps, the output is the ESC compare register being written
+ * and the edge the start of the PWM period that outputs it
+ */
+typedef enum {
+    LATENCY_DECODE = 0,             // frame -> snapshot
+    LATENCY_WAIT,                   // snapshot -> cycle start
+    LATENCY_CONTROL,                // cycle start -> output
+    LATENCY_PWM,                    // output -> edge
+    LATENCY_CYCLE,                  // cycle start -> cycle end, for every cycle
+    LATENCY_TOTAL,                  // frame -> edge
+    LATENCY_SEGMENT_COUNT
+} LATENCYSEGMENT_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;                   // us
+    uint32_t max;                   // us
+    uint64_t sum;                   // us
+    uint32_t histogram[LATENCY_HISTOGRAM_SIZE];
+} latencystats_t;
+
+void traceLatency(LATENCYSTAMP_t stamp);
+void traceLatencyOutput(uint32_t edgecycles);
+void resetLatency(void);
+void getLatencyStats(LATENCYSEGMENT_t segment, latencystats_t * copy);
+uint32_t getLatencyPercentile(const latencystats_t * stats, uint16_t permille);
+uint32_t getLatencyBucketStart(uint8_t bucket);
+char * getLatencySegmentLabel(LATENCYSEGMENT_t segment);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef LINKQUALITY_H_
+#define LINKQUALITY_H_
+
+#include "stm32f4xx.h"
+
+#define LINKQUALITY_HISTOGRAM_SIZE  32      // bucket i counts the frame intervals of i..i+1 x 1024us, the last bucket everything above
+#define LINKQUALITY_TIMEOUT         3000    // ms, getDuty() treats the RC signal as lost after that
+
+#define LINKQUALITY_FLAG_SIGNALLOSS (1 << 0)
+#define LINKQUALITY_FLAG_FAILSAFE   (1 << 1)
+
+/** \brief Statistics of the RC link, updated with every frame the receiver sends
+ *
+ * The nominal interval is learned from the frames, a gap of more than 1.5 times of it counts as lost frames.
+ */
+typedef struct
+{
+    uint32_t frames;
+    uint32_t signalloss_frames;     // frames the receiver flagged with signal loss, it repeats the last values
+    uint32_t failsafe_frames;
+    uint32_t failsafe_episodes;
+    uint32_t failsafe_longest;      // ms
+    uint32_t lost_frames;
+    uint32_t lost_runs;             // gaps of one or more lost frames
+    uint32_t longest_run;           // frames
+    uint32_t longest_gap;           // us
+    uint32_t timeouts;              // gaps longer than LINKQUALITY_TIMEOUT
+    uint32_t nominal_interval;      // us
+    uint32_t histogram[LINKQUALITY_HISTOGRAM_SIZE];
+} linkstats_t;
+
+void recordReceiverFrame(uint8_t flags);
+void resetLinkStats(void);
+void getLinkStats(linkstats_t * copy);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef PLANT_H_
+#define PLANT_H_
+
+/*
+ * The plant model does not depend on the HAL or any register, so it can be compiled for a host as well.
+ */
+#include "stdint.h"
+
+#define PLANT_GRAVITY   9.81f
+
+/** \brief The physical properties of the cablecam, the rope and the ESC/motor combination
+ *
+ * The rope is modelled with a slope changing linearly along the rope, which is roughly what a sagging
+ * rope looks like: downhill at the start, flat in the middle, uphill towards the end.
+ */
+typedef struct
+{
+    float mass;                 // kg of the cablecam including the camera
+    float slope;                // rope slope at position 0 in rad, positive is uphill in the direction of increasing positions
+    float slope_gradient;       // change of the slope per meter, positive for a sagging rope
+    float friction;             // N of rolling friction, acts against the motion and keeps the cablecam standing below that force
+    float drag;                 // N per m/s, air and bearing drag
+    float max_thrust;           // N the motor pulls with at full ESC output
+    float brake;                // N of drag brake the ESC applies when the signal is within its neutral range
+    float esc_lag;              // s, time constant of the thrust following the ESC signal
+    int16_t esc_neutral_pos;    // us, the pulse width the ESC considers neutral
+    int16_t esc_neutral_range;  // us, +- around neutral the ESC does not drive
+    int16_t esc_full_range;     // us, +- around neutral for full thrust
+    float steps_per_meter;      // Hall sensor steps per meter of rope
+} plantparams_t;
+
+/** \brief The current state of the simulated cablecam
+ */
+typedef struct
+{
+    float position;             // m
+    float speed;                // m/s
+    float thrust;               // N, the motor force after the ESC lag
+    int32_t counter;            // the position in Hall sensor steps, what the encoder would show
+} plantstate_t;
+
+void initPlantParams(plantparams_t * params);
+void resetPlant(plantstate_t * state, const plantparams_t * params, int32_t counter);
+void stepPlant(plantstate_t * state, const plantparams_t * params, int16_t esc, float dt);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef POSBACKUP_H_
+#define POSBACKUP_H_
+
+#include "stm32f4xx_hal.h"
+
+#define POSBACKUP_MAGIC             0xCAB1E001
+#define POSBACKUP_MAX_RESUME_SPEED  0       // the cablecam has to be stopped at the checkpoint, else the position is uncertain
+
+void initPosBackup(void);
+uint8_t restorePosBackup(void);
+void checkpointPos(int32_t pos, int32_t speed);
+
+#endif
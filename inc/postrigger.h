@@ -0,0 +1,36 @@
+#ifndef POSTRIGGER_H_
+#define POSTRIGGER_H_
+
+#include "stm32f4xx.h"
+
+#define POSTRIGGER_MAX_COUNT        32
+#define POSTRIGGER_MAX_PULSE_WIDTH  20000   // us, the pulse has to end within one period of TIM3
+
+#define POSTRIGGER_DIR_BOTH         0
+#define POSTRIGGER_DIR_FORWARD      1       // fires when the encoder value increases to the position
+#define POSTRIGGER_DIR_REVERSE      -1      // fires when the encoder value decreases to the position
+
+/** \brief A single position trigger
+ *
+ * When the encoder value reaches position while moving in direction, a pulse of pulse_width us is
+ * generated on the output.
+ */
+typedef struct
+{
+    int32_t position;
+    int8_t direction;
+    uint16_t pulse_width;
+    uint8_t output;
+} postrigger_t;
+
+void initPosTriggers(void);
+int8_t addPosTrigger(int32_t position, int8_t direction, uint16_t pulse_width, uint8_t output);
+void clearPosTriggers(void);
+uint8_t getPosTriggerCount(void);
+const postrigger_t * getPosTrigger(uint8_t index);
+uint32_t getPosTriggerFiredCount(void);
+uint32_t getPosTriggerSkippedCount(void);
+
+void POSTRIGGER_IRQHandler(void);
+
+#endif
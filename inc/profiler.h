@@ -0,0 +1,55 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include "stm32f4xx.h"
+
+/*
+ * The profiler is compiled in only when the symbol PROFILER is defined, which is the case for the Debug target.
+ * In the Release target all probes are empty macros and the $P command does not exist.
+ *
+ * It uses the DWT cycle counter, which is started by initBootTime().
+ */
+
+#define PROFILER_HISTOGRAM_SIZE     24      // bucket i counts the durations of 2^i..2^(i+1)-1 cycles, the last bucket everything above
+#define PROFILER_MAX_NESTING        8
+
+typedef enum {
+    PROBE_CONTROLLERCYCLE = 0,
+    PROBE_SERIALCOM,
+    PROBE_SBUS_IRQ,
+    PROBE_PPM_IRQ,
+    PROBE_USB_IRQ,
+    PROBE_POSTRIGGER_IRQ,
+    PROBE_COUNT
+} PROBE_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;                   // total cycles including the time spent in interrupts that preempted the probe
+    uint64_t sum_exclusive;         // cycles spent in the probe itself
+    uint32_t preempted;             // number of times other probes interrupted this one
+    uint32_t histogram[PROFILER_HISTOGRAM_SIZE];
+} probestats_t;
+
+#ifdef PROFILER
+
+#define PROFILER_ENTER()        profilerEnter()
+#define PROFILER_EXIT(probe)    profilerExit(probe)
+
+void profilerEnter(void);
+void profilerExit(PROBE_t probe);
+void resetProfiler(void);
+void getProbeStats(PROBE_t probe, probestats_t * copy);
+char * getProbeLabel(PROBE_t probe);
+
+#else
+
+#define PROFILER_ENTER()
+#define PROFILER_EXIT(probe)
+
+#endif
+
+#endif
@@ -3,25 +3,54 @@
 
 #include "serial_print.h"
 #include "controller.h"
+#include "esctable.h"
+#include "zones.h"
+#include "stickcurve.h"
+#include "servo.h"
+#include "gainschedule.h"
 
 #define PROTOCOL_P                '1'   // 1 float arguments for Kp
 #define PROTOCOL_I                '2'   // 1 float arguments for Ki
 #define PROTOCOL_D                '3'   // 1 float arguments for Kd
+#define PROTOCOL_AUTOTUNE         'A'   // 0, 1 or 2 int arguments, relay amplitude in us, the tuning rule to apply
 #define PROTOCOL_MAX_ACCEL        'a'   // 1 float argument
+#define PROTOCOL_BOOT_TIME        'b'   // no argument
+#define PROTOCOL_SERVO_OUTPUT     'O'   // 0, 1, 4 or 5 arguments, protocol or channel, min, max, failsafe mode, failsafe value
 #define PROTOCOL_PID       		  'c'	// PIDs set 3 floats
+#define PROTOCOL_LATENCY          'D'   // optional 1 int argument, 1 to reset the statistics after printing
+#define PROTOCOL_ESC_TABLE        'e'   // optional 1 int argument, 0 or 1 to stop or start using the ESC table
+#define PROTOCOL_ESC_CALIBRATION  'E'   // 1 int argument, the pulse width range to calibrate the ESC table with
 #define PROTOCOL_SPEED_FACTOR     'f'	// Define Speed Factor, the conversion from RC Stick value to Speed based on Hall Encoder, used in positional mode only
+#define PROTOCOL_FEEDFORWARD      'F'   // optional 1 int argument, 0/1 to stop/start using the feed forward map, 2 to clear it
 #define PROTOCOL_MAX_ERROR_DIST   'g'   // 1 float argument
+#define PROTOCOL_GAIN_SCHEDULE    'G'   // 0, 1 or 5 arguments, direction to clear or direction, speed, P, I, D of a breakpoint
 #define PROTOCOL_HELP		      'h'	// help
+#define PROTOCOL_SIMULATION       'H'   // optional 1 int argument to start/stop or 6 float arguments for the plant parameters
 #define PROTOCOL_INPUT_CHANNELS   'i'   // 3-5 int arguments for speed, command switch, end point button, max acceleration poti, may speed poti
 #define PROTOCOL_INPUT_SOURCE     'I'   // 1 int arguments for the input, SumPPM or SBus
+#define PROTOCOL_JOB              'j'   // optional 1 int argument, 0 to cancel the running job
+#define PROTOCOL_TRACTION         'k'   // optional 1 float argument, the slip threshold in m/s^2
+#define PROTOCOL_TRACTION_CLEAR   'K'   // no argument, clear the slip log and the degraded position flag
+#define PROTOCOL_TASKS            'l'   // no argument, print task statistics
+#define PROTOCOL_LINK_QUALITY     'L'   // optional 1 int argument, 1 to reset the statistics after printing
 #define PROTOCOL_MODE             'm'
 #define PROTOCOL_NEUTRAL          'n'	// 2 int neutral microseconds, +-range microseconds
 #define PROTOCOL_ESC_NEUTRAL      'N'	// 2 int neutral microseconds, +-range microseconds
 #define PROTOCOL_POS              'p'
+#define PROTOCOL_SETPOINT_STREAM  'q'   // optional 1-2 int arguments, 0/1 to stop/start the setpoint stream, playout delay in ms
+#define PROTOCOL_PROFILER         'P'   // optional 1 int argument, 1 to reset the statistics after printing
 #define PROTOCOL_ROTATION_DIR     'r'   // 1 int argument
+#define PROTOCOL_SHAPER           's'   // 1-3 arguments, shaper type, swing frequency, damping
 #define PROTOCOL_SETTINGS         'S'   // no argument
+#define PROTOCOL_POS_TRIGGER      't'   // 3-4 int arguments position, direction, pulse width, output
+#define PROTOCOL_POS_TRIGGER_CLEAR 'T'  // no argument
+#define PROTOCOL_IMU              'u'   // optional 1 float argument, hall sensor steps per meter
 #define PROTOCOL_EEPROM_WRITE     'w'   // no argument
 #define PROTOCOL_MAX_SPEED        'v'   // 1 float argument
+#define PROTOCOL_SWING_IDENT      'x'   // no argument, identify the swing frequency
+#define PROTOCOL_STICK_CURVE      'y'   // 0, 1, 2-3 or 9 arguments, stick range or mode, curve type, expo or breakpoints
+#define PROTOCOL_TRACKING         'Y'   // 0, 1, 2 or 4 arguments, off/on or target position, distance, us per degree, degrees per second
+#define PROTOCOL_SPEED_ZONES      'Z'   // 1 or 3 arguments, 0 to clear or position, max speed, max accel of a breakpoint
 #define PROTOCOL_D_CYCLES         'z'   // Hidden command to print the debug information about the values for each cycle
 
 #define MODE_ABSOLUTE_POSITION	0
@@ -106,6 +135,30 @@ typedef struct
     int16_t esc_scale;
     uint8_t rc_channel_max_accel;
     uint8_t rc_channel_max_speed;
+    double hall_steps_per_meter;
+    uint8_t shaper_type;
+    double shaper_frequency;
+    double shaper_damping;
+    uint8_t esc_table_active;
+    int16_t esc_table_range;
+    int16_t esc_table[2][ESC_TABLE_POINTS];
+    uint8_t feedforward_active;
+    double traction_slip_threshold;
+    uint8_t zone_count;
+    speedzone_t zones[SPEEDZONE_MAX];
+    uint8_t rc_channel_zone;
+    stickcurve_t stick_curve[2];
+    int16_t stick_curve_range;
+    uint8_t tracking_active;
+    int32_t tracking_target;
+    double tracking_distance;
+    double tracking_us_per_degree;
+    double tracking_max_rate;
+    uint8_t rc_channel_yaw;
+    uint8_t servo_protocol;
+    servooutput_t servo_outputs[SERVO_CHANNELS];
+    uint8_t gain_count[2];
+    gainpoint_t gain_schedule[2][GAINSCHEDULE_POINTS];
 } settings_t;
 
 
@@ -116,7 +169,8 @@ typedef struct
     double distance_to_stop;
     double speed;
     uint16_t esc;
-    uint32_t tick;
+    uint32_t tick;                  // us, wraps around, see timebase.h
+    uint16_t rc_age;                // ms since the last valid RC frame
 } cyclemonitor_t;
 
 
@@ -131,18 +185,23 @@ extern settings_t activesettings;
 typedef struct
 {
     char boottext_eeprom[81];
+    char boottext_position[81];
     SAFE_MODE_t safemode;
     CONTROLLER_MONITOR_t monitor;
     cyclemonitor_t cyclemonitor[CYCLEMONITOR_SAMPLE_COUNT];
     int16_t cyclemonitor_position;
+    uint8_t position_degraded;      // 1 once the wheel slipped, the Hall sensor position might be off since
 } controllerstatus_t;
 
 extern controllerstatus_t controllerstatus;
 
 void initProtocol(void);
-void serialCom(Endpoints endpoint);
+void setDefaultSettings(void);
+void setDefaultServoOutputs(void);
+void setDefaultESCOutputLimits(void);
+void serialCom(char * line, Endpoints endpoint);
 void printHelp(Endpoints endpoint);
-void printActiveSettings(Endpoints endpoint);
+void requestSettingsSave(Endpoints endpoint);
 
 char * getSafeModeLabel();
 char * getCurrentModeLabel(uint8_t mode);
@@ -7,6 +7,7 @@
 
 #define SBUS_MAX_CHANNEL 16
 #define SBUS_FRAME_SIZE 25
+#define SBUS_TIMEOUT 3000000        // us without a valid frame until the RC signal counts as lost
 
 struct sbusFrame_s {
     uint8_t syncByte;
@@ -42,8 +43,9 @@ typedef struct {
 } servo_t;
 
 typedef struct {
-	uint32_t sbusFrameStartTime;
-	uint32_t sbusLastValidFrame;
+	uint32_t sbusLastByteTime;          // us
+	uint32_t sbusLastValidFrame;        // us
+	uint8_t timeout;                    // no valid frame for SBUS_TIMEOUT, latched until the next one
 	uint32_t counter_sbus_frames;
 	uint32_t counter_sbus_errors;
 	uint32_t counter_sbus_valid_data;
@@ -65,6 +67,7 @@ extern sbusData_t sbusdata;
 
 void SBUS_IRQHandler(UART_HandleTypeDef *huart);
 void printSBUSChannels(Endpoints endpoint);
+void processSBUSFrame(void);
 int16_t getDuty(uint8_t channel);
 uint8_t* getSBUSFrameAddress(void);
 void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim);
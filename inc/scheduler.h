@@ -0,0 +1,49 @@
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include "stm32f4xx.h"
+
+#define SCHEDULER_LOAD_WINDOW   1000    // ms, the cpu load of the tasks is calculated over this time
+#define SCHEDULER_STACK_PAINT   16384   // bytes below the stack pointer at boot that are monitored for the stack usage
+
+/** \brief The tasks, ordered by priority
+ *
+ * Whenever the scheduler looks for the next task to run, it takes the ready task with the lowest number.
+ * The tasks are run to completion, hence a task must never wait for anything. A task taking long delays
+ * all other tasks, even the control task.
+ */
+typedef enum {
+    TASK_CONTROL = 0,       // hard real-time, the 50Hz controller cycle
+    TASK_RECEIVER,          // decoding of the received RC frames
+    TASK_IMU,               // reading the IMU FIFO and processing its samples
+    TASK_COMMAND,           // protocol command handling
+    TASK_TELEMETRY,         // USB output and LEDs
+    TASK_JOB,               // long running commands like eeprom writes and dumps, executed in small steps
+    TASK_COUNT
+} TASK_t;
+
+typedef void (*taskfunction_t)(void);
+
+typedef struct
+{
+    char * name;
+    taskfunction_t function;
+    uint32_t period;            // us, 0 if the task is run only when signalled
+    uint32_t nextrun;
+    uint32_t due;               // the time the periodic run was due
+    uint8_t waiting;            // the periodic run is due but did not start yet
+    uint32_t maxlate;           // us the start of a periodic run was late at most
+    uint32_t runs;
+    uint32_t maxcycles;
+    uint32_t windowcycles;      // cycles used within the current load window
+    uint16_t load;              // cpu load of the last load window in 0.1%
+} task_t;
+
+void initScheduler(void);
+void addTask(TASK_t id, char * name, taskfunction_t function, uint32_t period);
+void signalTask(TASK_t id);
+void runScheduler(void);
+const task_t * getTask(TASK_t id);
+uint32_t getStackUsage(void);
+
+#endif
@@ -8,6 +8,7 @@ typedef enum
 {
   EndPoint_UART3                   = 0x00,
   EndPoint_USB,
+  EndPoint_UART2,
   EndPoint_All,
 } Endpoints;
 
@@ -24,4 +25,5 @@ void PrintlnSerial_string(char * v, Endpoints endpoint);
 void PrintlnSerial_long(int32_t v, Endpoints endpoint);
 void PrintlnSerial_double(double v, Endpoints endpoint);
 void PrintlnSerial(Endpoints endpoint);
+uint32_t getTxFree(Endpoints endpoint);
 #endif
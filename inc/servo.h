@@ -0,0 +1,36 @@
+#ifndef SERVO_H_
+#define SERVO_H_
+
+#include "stm32f4xx.h"
+
+#define SERVO_CHANNELS              4       // SERVO_ESC, SERVO_PITCH, SERVO_YAW and SERVO_AUX of config.h
+
+#define SERVO_PROTOCOL_PWM50        0       // 50Hz, the standard servo signal
+#define SERVO_PROTOCOL_PWM400       1       // 400Hz for ESCs and digital servos supporting it
+#define SERVO_PROTOCOL_ONESHOT125   2       // 125..250us pulses at 2kHz
+
+#define SERVO_FAILSAFE_NONE         0       // the output continues as calculated, e.g. the controller ramps the ESC down itself
+#define SERVO_FAILSAFE_HOLD         1       // the output keeps the last value
+#define SERVO_FAILSAFE_VALUE        2       // the output jumps to the failsafe value
+#define SERVO_FAILSAFE_OFF          3       // no pulses at all
+
+/** \brief The configuration of one servo output
+ */
+typedef struct
+{
+    uint16_t min;                   // pulse width limits in us
+    uint16_t max;
+    uint8_t failsafe_mode;          // SERVO_FAILSAFE_xxx, used when the RC signal is lost
+    uint16_t failsafe;              // pulse width for SERVO_FAILSAFE_VALUE
+} servooutput_t;
+
+void setServoProtocol(uint8_t protocol);
+uint8_t getServoProtocol(void);
+char * getServoProtocolLabel(uint8_t protocol);
+void setServoOutput(uint8_t channel, uint16_t pulse);
+void commitServoOutputs(const servooutput_t * outputs, uint8_t signalloss);
+uint16_t getServoOutput(uint8_t channel);
+uint8_t hasServoPin(uint8_t channel);
+uint32_t getServoUpdateDelay(void);
+
+#endif
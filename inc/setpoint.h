@@ -0,0 +1,52 @@
+#ifndef SETPOINT_H_
+#define SETPOINT_H_
+
+#include "stm32f4xx.h"
+
+#define SETPOINT_SYNC               0xA5    // never part of a text command
+#define SETPOINT_FRAME_SIZE         12      // sync, uint32 timestamp ms, int32 position, int16 velocity steps/s, xor checksum
+#define SETPOINT_BUFFER_SIZE        32      // frames, 160ms at 200Hz
+#define SETPOINT_DEFAULT_DELAY      30      // ms the playout lags behind the sender
+#define SETPOINT_MAX_DELAY          150     // ms
+#define SETPOINT_MAX_EXTRAPOLATION  100     // ms, on an underrun the last setpoint is extrapolated that long, then held
+#define SETPOINT_OFFSET_WINDOW      256     // frames, the clock offset and the jitter are estimated over that many frames
+#define SETPOINT_RESYNC_TIMEOUT     20      // ms after a frame byte, bytes until the next sync are taken as the rest of a broken frame
+
+/** \brief One setpoint as sent by the motion control system, in its own time base
+ */
+typedef struct
+{
+    uint32_t timestamp;             // ms
+    int32_t pos;                    // Hall sensor position
+    int16_t velocity;               // Hall sensor steps per second
+} setpoint_t;
+
+/** \brief The state of the frame decoder of one endpoint
+ */
+typedef struct
+{
+    uint8_t buffer[SETPOINT_FRAME_SIZE];
+    uint8_t length;
+    uint8_t skip;                   // bytes still dropped while waiting for the next sync, after a broken frame
+    uint32_t tick;                  // HAL_GetTick() of the last frame byte
+} setpointdecoder_t;
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t checksum_errors;
+    uint32_t late;                  // frames out of order or arriving after their playout time
+    uint32_t overflows;             // frames dropped as the buffer was full
+    uint32_t underruns;             // times the playout ran past the newest setpoint
+    int32_t jitter;                 // ms, the spread of the transit times over the last window
+    uint8_t level;                  // frames buffered ahead of the playout position
+} setpointstats_t;
+
+void enableSetpointStream(uint8_t enable, uint16_t delay);
+uint8_t isSetpointStreamActive(void);
+uint16_t getSetpointDelay(void);
+uint8_t decodeSetpointByte(setpointdecoder_t * decoder, uint8_t c, uint8_t line_empty);
+int8_t getStreamSetpoint(uint32_t now, double * pos);
+const setpointstats_t * getSetpointStats(void);
+
+#endif
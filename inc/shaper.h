@@ -0,0 +1,46 @@
+#ifndef SHAPER_H_
+#define SHAPER_H_
+
+#include "stm32f4xx.h"
+#include "job.h"
+
+#define SHAPER_OFF              0
+#define SHAPER_ZV               1       // two impulses, exact at the set frequency only
+#define SHAPER_ZVD              2       // three impulses, robust against a frequency error of about +-20%
+#define SHAPER_EI               3       // three impulses, robust against +-30% but shaping the command slightly more
+
+#define SHAPER_MAX_IMPULSES     3
+#define SHAPER_RING_SIZE        128     // controller cycles of stick history, must be a power of two
+#define SHAPER_MIN_FREQUENCY    0.4     // Hz, the longest impulse delay of one swing period has to fit into the ring
+#define SHAPER_MAX_FREQUENCY    5.0     // Hz, 10 controller cycles per swing period
+#define SHAPER_EI_TOLERANCE     0.05f   // residual swing the EI shaper accepts at the set frequency
+
+#define SHAPER_IDENT_SAMPLES    256     // controller cycles recorded for the identification, 5.12s
+#define SHAPER_IDENT_MIN_LAG    10      // cycles, the swing period at SHAPER_MAX_FREQUENCY
+#define SHAPER_IDENT_MAX_LAG    126     // cycles, the swing period at SHAPER_MIN_FREQUENCY plus one for the peak interpolation
+#define SHAPER_IDENT_LAGS_PER_STEP 8    // autocorrelation values calculated per job step
+#define SHAPER_IDENT_MIN_CORRELATION 0.3f   // a swing is found only if the signal is that periodic
+
+/** \brief The impulses the stick signal is convolved with, compiled from the settings
+ *
+ * The delays are in controller cycles, split into the integer part used as ring index and the fraction
+ * the two neighbouring ring values are interpolated with.
+ */
+typedef struct
+{
+    uint8_t count;                          // 0 if the shaper is off
+    float amplitude[SHAPER_MAX_IMPULSES];   // sum of all is 1
+    uint8_t delay[SHAPER_MAX_IMPULSES];
+    float fraction[SHAPER_MAX_IMPULSES];
+    float lag;                              // cycles, the mean delay the shaper adds to the stick signal
+} shaperplan_t;
+
+void compileShaper(shaperplan_t * shaper, uint8_t type, double frequency, double damping);
+int16_t shapeStick(const shaperplan_t * shaper, int16_t value);
+void resetShaper(int16_t value);
+void recordSwing(float sample);
+void startSwingIdentification(void);
+int8_t stepSwingIdentification(uint32_t * progress, float * frequency);
+char * getShaperLabel(uint8_t type);
+
+#endif
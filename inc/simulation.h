@@ -0,0 +1,14 @@
+#ifndef SIMULATION_H_
+#define SIMULATION_H_
+
+#include "stm32f4xx.h"
+#include "plant.h"
+
+void initSimulation(void);
+int8_t setSimulation(uint8_t enable);
+uint8_t isSimulationActive(void);
+void simulationCycle(void);
+plantparams_t * getSimulationParams(void);
+const plantstate_t * getSimulationState(void);
+
+#endif
@@ -100,8 +100,10 @@ void sFLASH_LowLevel_Init(void);
   * @brief  High layer functions
   */
 void sFLASH_EraseSector(uint32_t SectorAddr);
+void sFLASH_StartEraseSector(uint32_t SectorAddr);
 void sFLASH_EraseBulk(void);
 void sFLASH_WritePage(uint8_t* pBuffer, uint32_t WriteAddr, uint16_t NumByteToWrite);
+void sFLASH_StartWritePage(uint8_t* pBuffer, uint32_t WriteAddr, uint16_t NumByteToWrite);
 void sFLASH_WriteBuffer(uint8_t* pBuffer, uint32_t WriteAddr, uint32_t NumByteToWrite);
 void sFLASH_ReadBuffer(uint8_t* pBuffer, uint32_t ReadAddr, uint32_t NumByteToRead);
 uint32_t sFLASH_ReadID(void);
@@ -111,6 +113,7 @@ uint32_t sFLASH_VerifyWrite(uint8_t* pBuffer, uint32_t ReadAddr, uint32_t NumByt
   */
 void sFLASH_WriteEnable(void);
 void sFLASH_WaitForWriteEnd(void);
+uint8_t sFLASH_IsWriteInProgress(void);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,29 @@
+#ifndef STICKCURVE_H_
+#define STICKCURVE_H_
+
+#include "stm32f4xx.h"
+
+#define STICKCURVE_LINEAR       0
+#define STICKCURVE_EXPO         1       // out = x * (1 - expo) + x^3 * expo
+#define STICKCURVE_CUSTOM       2       // interpolated between breakpoints
+
+#define STICKCURVE_POINTS       7       // custom breakpoints at 1/8 .. 7/8 of the stick range, 0 and 8/8 are fixed
+#define STICKCURVE_LUT_SIZE     32      // segments of the lookup table
+#define STICKCURVE_DEFAULT_RANGE 500    // stick value at full deflection, roughly 470 for PPM and 790 for SBus
+
+/** \brief The response curve of the stick as configured
+ *
+ * The points are in permille of the full output at equally spaced stick positions.
+ */
+typedef struct
+{
+    uint8_t type;
+    float expo;                             // 0 linear .. 1 cubic
+    int16_t points[STICKCURVE_POINTS];
+} stickcurve_t;
+
+void compileStickCurve(int16_t * lut, const stickcurve_t * curve, int16_t range);
+int16_t applyStickCurve(const int16_t * lut, float scale, int16_t range, int16_t value);
+char * getStickCurveLabel(uint8_t type);
+
+#endif
@@ -58,9 +58,13 @@ void DMA1_Stream5_IRQHandler(void);
 void DMA1_Stream6_IRQHandler(void);
 void USART1_IRQHandler(void);
 void USART2_IRQHandler(void);
+void DMA2_Stream0_IRQHandler(void);
 void DMA2_Stream2_IRQHandler(void);
+void DMA2_Stream3_IRQHandler(void);
 void OTG_FS_IRQHandler(void);
 void TIM1_CC_IRQHandler(void);
+void TIM5_IRQHandler(void);
+void PVD_IRQHandler(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,16 @@
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+#include "stm32f4xx.h"
+
+/*
+ * A free running 32 bit microsecond counter on TIM2, it wraps around every 71.6 minutes.
+ * Hence timestamps are only ever compared by their difference, never directly.
+ */
+#define MICROS()                    (TIM2->CNT)
+#define TIME_ELAPSED(now, since)    ((uint32_t) ((now) - (since)))          // us passed since, correct across the wrap around
+#define TIME_REACHED(now, deadline) ((int32_t) ((now) - (deadline)) >= 0)   // for deadlines up to 35 minutes ahead
+
+void initTimebase(void);
+
+#endif
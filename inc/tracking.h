@@ -0,0 +1,27 @@
+#ifndef TRACKING_H_
+#define TRACKING_H_
+
+#include "stm32f4xx.h"
+
+#define TRACKING_TABLE_SIZE     128     // segments of the angle table
+#define TRACKING_TABLE_SPAN     10.0f   // the table covers +-10 times the distance of the target, atan(10) = 84 degrees
+#define TRACKING_DEFAULT_US_PER_DEGREE 10.0f
+#define TRACKING_DEFAULT_MAX_RATE 90.0f // degrees per second
+
+/** \brief The servo pulse widths for aiming at the target, precalculated for the positions around it
+ */
+typedef struct
+{
+    uint8_t active;
+    int32_t start;                          // Hall sensor position of the first table entry
+    float scale;                            // TRACKING_TABLE_SIZE / table span in Hall sensor steps
+    float max_rate;                         // us per cycle
+    int16_t table[TRACKING_TABLE_SIZE + 1]; // servo pulse width in us
+} trackingplan_t;
+
+void compileTracking(trackingplan_t * tracking, uint8_t active, int32_t target, double distance, double steps_per_meter,
+                     double us_per_degree, double max_rate);
+uint16_t trackingCycle(const trackingplan_t * tracking, int32_t pos, int16_t override);
+void resetTracking(uint16_t current);
+
+#endif
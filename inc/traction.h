@@ -0,0 +1,35 @@
+#ifndef TRACTION_H_
+#define TRACTION_H_
+
+#include "stm32f4xx.h"
+
+#define TRACTION_LOG_SIZE       8       // slip events kept in the log
+#define TRACTION_REDUCE         0.7f    // the acceleration limit is multiplied with that every cycle the wheel slips
+#define TRACTION_MIN_SCALE      0.2f    // but never reduced below that part of the configured limit
+#define TRACTION_RECOVER        0.01f   // per cycle without slip the limit returns towards the configured one, 1.6s from min to full
+#define TRACTION_SLIP_FILTER    0.8f    // low pass of the slip calculated from the plant model, per controller cycle
+
+typedef struct
+{
+    uint32_t tick;              // HAL_GetTick() when the slip started
+    int32_t pos;                // Hall sensor position when the slip started
+    float slip;                 // m/s^2 at the start, positive when the wheel spins, negative when it skids
+} slipevent_t;
+
+typedef struct
+{
+    uint8_t slipping;           // 1 while the slip exceeds the threshold
+    float slip;                 // m/s^2 the wheel accelerates more than the carriage, positive in the direction of motion
+    float scale;                // part of the configured acceleration limit currently allowed
+    uint32_t events;            // number of times the wheel started to slip
+    uint8_t log_position;       // where the next event goes into the log
+    slipevent_t log[TRACTION_LOG_SIZE];
+} tractionstate_t;
+
+void tractionCycle(int32_t pos, uint16_t esc);
+void resyncTraction(void);
+int16_t limitTractionAccel(int16_t max_accel);
+const tractionstate_t * getTractionState(void);
+void clearTraction(void);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef UART_H_
+#define UART_H_
+
+#include "stm32f4xx_hal.h"
+#include "serial_print.h"
+
+#define UART_RX_BUFFER_SIZE     128     // bytes, circular DMA buffer, has to take all bytes received between two command task runs
+#define UART_TX_BUFFER_SIZE     1024    // bytes, more than JOB_TX_RESERVE
+#define UART_LINE_SIZE          81      // one extra char for the null termination
+
+/** \brief Statistics of a uart endpoint
+ */
+typedef struct
+{
+    uint32_t bytes_received;
+    uint32_t bytes_sent;
+    uint32_t bytes_dropped;         // output that did not fit into the transmit buffer
+    uint32_t lines_dropped;         // command lines longer than UART_LINE_SIZE
+    uint32_t errors;                // overrun, noise, framing and parity errors
+} uartstats_t;
+
+void initUARTPorts(void);
+char * UART_ReceiveString(Endpoints endpoint);
+void UART_TransmitString(Endpoints endpoint, char * ptr);
+void UARTPeriodElapsed(void);
+uint32_t UART_GetTxFree(Endpoints endpoint);
+const uartstats_t * getUARTStats(Endpoints endpoint);
+void UART_IdleHandler(UART_HandleTypeDef * huart);
+
+#endif
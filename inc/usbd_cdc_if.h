@@ -107,6 +107,7 @@
 extern USBD_CDC_ItfTypeDef  USBD_Interface_fops_FS;
 
 /* USER CODE BEGIN EXPORTED_VARIABLES */
+extern char commandlinebuffer[RXBUFFERSIZE];
 /* USER CODE END EXPORTED_VARIABLES */
 
 /**
@@ -123,6 +124,7 @@ uint8_t  CDC_TransmitBuffer(uint8_t *ptr, uint32_t len);
 uint16_t USB_ReceiveString();
 uint8_t  CDC_TransmitString(char *ptr);
 void USBPeriodElapsed(void);
+uint32_t CDC_GetTxFree(void);
 
 /* USER CODE END EXPORTED_FUNCTIONS */
 /**
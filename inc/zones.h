@@ -0,0 +1,22 @@
+#ifndef ZONES_H_
+#define ZONES_H_
+
+#include "stm32f4xx.h"
+
+#define SPEEDZONE_MAX           8       // breakpoints along the rope
+
+/** \brief The limits at one position along the rope, between two breakpoints they are interpolated
+ */
+typedef struct
+{
+    int32_t pos;                // Hall sensor position
+    int16_t max_speed;          // same units as stick_max_speed
+    int16_t max_accel;          // same units as stick_max_accel
+} speedzone_t;
+
+int8_t addSpeedZone(int32_t pos, int16_t max_speed, int16_t max_accel);
+void clearSpeedZones(void);
+int16_t getZoneBrakeAccel(const speedzone_t * zones, uint8_t count, double from, double to, int16_t maxaccel);
+void limitSpeedZones(const speedzone_t * zones, uint8_t count, double pos, int32_t speed, int16_t stick, int16_t * maxspeed, int16_t * maxaccel);
+
+#endif
@@ -0,0 +1,666 @@
+#include "halstub.h"
+#include "protocol.h"
+#include "controller.h"
+#include "controlplan.h"
+#include "sbus.h"
+#include "simulation.h"
+#include "clock_50Hz.h"
+#include "imu.h"
+#include "traction.h"
+#include "setpoint.h"
+#include "servo.h"
+#include "timebase.h"
+#include "config.h"
+#include "scheduler.h"
+#include "usbd_cdc_if.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "time.h"
+#include "unistd.h"
+#include "sys/wait.h"
+
+/*
+ * The host simulator: the controller, the SBus decoder and the protocol of the firmware run unchanged against the
+ * plant model, as fast as the PC can. Every scenario runs in a child process, so all the static state of the
+ * firmware starts fresh like after a reset.
+ */
+
+#define SIM_CYCLE_US        20000   // the control task period
+#define SIM_SBUS_BYTE_US    120     // one SBus byte at 100000 baud
+#define SIM_SBUS_NEUTRAL    992
+#define SIM_SBUS_HIGH       1811
+#define SIM_BENCH_RUNS      20
+#define SIM_WARMUP_CYCLES   50      // with the stick in neutral, the controller does not accept anything else at startup
+#define SIM_RESYNC_FRAMES   20      // setpoint frames of the decoder test
+#define SIM_SLIP_CYCLES     10      // cycles the wheel spins when it reaches the wet rope
+#define SIM_SLIP_STEPS      1       // Hall sensor steps per cycle the spinning wheel counts more than the cablecam moves
+#define SIM_SLIP_TRACTION   0.3f    // part of the thrust and brake force the wheel transmits on the wet rope
+
+/** \brief One scenario and the limits its score has to stay within
+ *
+ * All positions are Hall sensor steps, 100 per meter. The stick is given in SBus counts from neutral and held for
+ * stick_cycles, then it is released for the rest of the run. With a stream speed the stick stays neutral and a
+ * setpoint stream ($q) moves with that speed for stick_cycles instead, then holds.
+ * Scenarios without wheel slip and further commands leave these columns out.
+ */
+typedef struct
+{
+    char * name;
+    uint8_t mode;                   // MODE_ABSOLUTE_POSITION, MODE_LIMITER_ENDPOINTS, ...
+    double p;
+    double i;
+    double d;
+    int16_t max_accel;              // see $a
+    float slip_threshold;           // see $k, 0 for no traction control
+    float slope;                    // rad at position 0, see plantparams_t
+    int32_t start;
+    int32_t pos_start;
+    int32_t pos_end;
+    int16_t stick;
+    int16_t stream;                 // steps per second of the setpoint stream, 0 for none
+    uint32_t stick_cycles;
+    uint32_t cycles;
+
+    double max_tracking_error;      // RMS of target - position, absolute position mode only
+    double max_overshoot;
+    double max_endpoint_overrun;    // how far the cablecam may get past the end point it moves towards
+    uint32_t max_emergency_brakes;
+    uint32_t max_slip_events;
+    int32_t slip_pos;               // the rope is wet beyond that position, the wheel spins when it gets there, 0 for never
+    char * commands;                // further settings made at boot, separated by ';', e.g. "$Z 2000 1000 2"
+} scenario_t;
+
+/** \brief The result of one scenario run
+ */
+typedef struct
+{
+    double tracking_rms;
+    double tracking_max;
+    double overshoot;               // how far the cablecam went past the position it finally stopped at
+    double stop_distance;           // travelled after the stick got released
+    double endpoint_overrun;        // negative if it stayed that far away from the end point
+    uint32_t emergency_brakes;
+    uint32_t slip_events;           // the traction control saw the wheel slip
+    int32_t final_pos;
+    uint32_t cycles;
+    double wall_ns;                 // host time of the run
+} score_t;
+
+/*
+ * The gains are the ones found in the simulation with the default plant, the limits are what the firmware achieves
+ * with them plus some margin. The runs are deterministic, a change making one of the scores worse fails the suite.
+ * The zone scenarios put a zone with a low max accel in front of the end point. In limiter mode the ESC thrust ramps
+ * down with it slower than the cablecam's brake distance estimation assumes, there the emergency brake has to help.
+ */
+static const scenario_t scenarios[] =
+{
+    /* name             mode                    P      I     D     accel slip  slope   start start end   stick stream hold  cycles rms   over  overrun ebrakes slips slip pos, commands */
+    {"creep",           MODE_ABSOLUTE_POSITION, 250.0, 40.0, 50.0, 10,   0.0f,   0.0f, 1000, 500, 5500,   40,    0,  500,  750,  5.0, 15.0,  0.0,  0, 0},
+    {"cruise",          MODE_ABSOLUTE_POSITION, 250.0, 40.0, 50.0, 10,   0.0f, -0.05f, 1000, 500, 5500,  120,    0,  250,  500, 15.0, 20.0,  0.0,  0, 0},
+    {"downhill",        MODE_ABSOLUTE_POSITION, 250.0, 40.0, 50.0, 10,   0.0f, -0.15f, 1000, 500, 5500,  120,    0,  250,  500, 15.0, 20.0,  0.0,  0, 0},
+    {"uphill reverse",  MODE_ABSOLUTE_POSITION, 250.0, 40.0, 50.0, 10,   0.0f, -0.15f, 5000, 500, 5500, -120,    0,  250,  500, 40.0, 20.0,  0.0,  0, 0},
+    {"endpoint",        MODE_ABSOLUTE_POSITION, 250.0, 40.0, 50.0, 10,   0.0f, -0.05f, 1000, 500, 3000,  120,    0, 1000, 1000, 15.0, 10.0, 60.0,  2, 0},
+    {"limiter",         MODE_LIMITER_ENDPOINTS,   0.0,  0.0,  0.0, 10,   0.0f, -0.05f, 1000, 500, 3000,  120,    0, 1000, 1000,  0.0, 10.0, 60.0,  2, 0},
+    {"traction",        MODE_ABSOLUTE_POSITION, 250.0, 40.0, 50.0, 10,   1.5f, -0.05f, 1000, 500, 5500,  120,    0,  250,  500, 15.0, 20.0,  0.0,  0, 0},
+    {"stream",          MODE_ABSOLUTE_POSITION, 250.0, 40.0, 50.0, 10,   0.0f, -0.05f, 1000, 500, 5500,    0,  200,  500,  750, 15.0, 120.0, 0.0,  0, 0},
+    {"stream endpoint", MODE_ABSOLUTE_POSITION, 250.0, 40.0, 50.0, 10,   0.0f, -0.05f, 1000, 500, 3000,    0,  300, 1000, 1000, 15.0, 10.0, 20.0,  0, 0},
+    {"slip endpoint",   MODE_ABSOLUTE_POSITION, 250.0, 40.0, 50.0, 10,   1.5f, -0.05f, 1000, 500, 3000,  120,    0, 1000, 1000, 25.0, 10.0, 30.0,  2, 2, 2600},
+    {"zone endpoint",   MODE_ABSOLUTE_POSITION, 250.0, 40.0, 50.0, 10,   0.0f, -0.05f, 1000, 500, 3000,  120,    0, 1000, 1000, 15.0, 10.0, 20.0,  0, 0, 0, "$Z 500 1000 10;$Z 2000 1000 2"},
+    {"zone limiter",    MODE_LIMITER_ENDPOINTS,   0.0,  0.0,  0.0, 10,   0.0f, -0.05f, 1000, 500, 3000,  120,    0, 1000, 1000,  0.0, 10.0, 20.0, 10, 0, 0, "$Z 500 1000 10;$Z 2000 1000 2"},
+    {"zone stream",     MODE_ABSOLUTE_POSITION, 250.0, 40.0, 50.0, 10,   0.0f, -0.05f, 1000, 500, 3000,    0,  300, 1000, 1000, 15.0, 10.0, 20.0,  0, 0, 0, "$Z 500 1000 10;$Z 2000 1000 2"},
+};
+
+#define SCENARIO_COUNT  (sizeof(scenarios) / sizeof(scenarios[0]))
+
+/** \brief Receive one SBus frame through the uart interrupt handler, byte by byte like the hardware
+ *
+ * \param stick int16_t speed channel in SBus counts from neutral
+ * \return void
+ *
+ */
+static void sendSBusFrame(int16_t stick)
+{
+    sbusFrame_t frame;
+    uint8_t i;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.frame.syncByte = 0x0F;
+    frame.frame.chan0 = SIM_SBUS_NEUTRAL + stick;
+    frame.frame.chan1 = SIM_SBUS_NEUTRAL;
+    frame.frame.chan2 = SIM_SBUS_NEUTRAL;
+    frame.frame.chan3 = SIM_SBUS_NEUTRAL;
+    frame.frame.chan4 = SIM_SBUS_NEUTRAL;
+    frame.frame.chan5 = SIM_SBUS_HIGH;      // programming switch, operational
+    frame.frame.chan6 = SIM_SBUS_NEUTRAL;   // end point button
+    frame.frame.chan7 = SIM_SBUS_NEUTRAL;
+    frame.frame.endByte = 0x00;
+
+    for (i = 0; i < SBUS_FRAME_SIZE; i++)
+    {
+        USART1->SR = USART_SR_RXNE;
+        USART1->DR = frame.bytes[i];
+        SBUS_IRQHandler(&huart1);
+        advanceTime(SIM_SBUS_BYTE_US);
+    }
+}
+
+/** \brief Run the tasks the interrupts and commands signalled, in the order of their priority
+ *
+ * \return void
+ *
+ */
+static void runSignalledTasks(void)
+{
+    uint32_t signals = takeSignals();
+    if (signals & (1UL << TASK_RECEIVER))
+    {
+        processSBUSFrame();
+    }
+    if (signals & (1UL << TASK_COMMAND))
+    {
+        updateControlPlan();
+    }
+}
+
+/** \brief Encode a setpoint frame with the current time as timestamp
+ *
+ * \param frame uint8_t* SETPOINT_FRAME_SIZE bytes
+ * \param pos int32_t
+ * \param velocity int16_t steps per second
+ * \return void
+ *
+ */
+static void buildSetpointFrame(uint8_t * frame, int32_t pos, int16_t velocity)
+{
+    uint32_t timestamp = HAL_GetTick();
+    uint8_t i;
+
+    frame[0] = SETPOINT_SYNC;
+    memcpy(&frame[1], &timestamp, 4);
+    memcpy(&frame[5], &pos, 4);
+    memcpy(&frame[9], &velocity, 2);
+    frame[SETPOINT_FRAME_SIZE - 1] = 0;
+    for (i = 0; i < SETPOINT_FRAME_SIZE - 1; i++)
+    {
+        frame[SETPOINT_FRAME_SIZE - 1] ^= frame[i];
+    }
+}
+
+/** \brief Receive one setpoint frame like the USB endpoint does
+ *
+ * \param pos int32_t
+ * \param velocity int16_t steps per second
+ * \return void
+ *
+ */
+static void sendSetpointFrame(int32_t pos, int16_t velocity)
+{
+    static setpointdecoder_t decoder;
+    uint8_t frame[SETPOINT_FRAME_SIZE];
+    uint8_t i;
+
+    buildSetpointFrame(frame, pos, velocity);
+    for (i = 0; i < SETPOINT_FRAME_SIZE; i++)
+    {
+        decodeSetpointByte(&decoder, frame[i], 1);
+    }
+}
+
+/*
+ * Hall sensor steps the wheel counted more than the cablecam moved, because it spun
+ */
+static int32_t slip_offset = 0;
+
+/** \brief One control cycle: the SBus frame arrives, then the control task runs
+ *
+ * \param stick int16_t
+ * \return void
+ *
+ */
+static void runCycle(int16_t stick)
+{
+    sendSBusFrame(stick);
+    runSignalledTasks();
+    advanceTime(SIM_CYCLE_US - SBUS_FRAME_SIZE * SIM_SBUS_BYTE_US);
+
+    tickCounter();
+    simulationCycle();
+    ENCODER_VALUE += (uint32_t) slip_offset;
+    fuseIMU((int32_t) ENCODER_VALUE);
+    controllercycle();
+    runSignalledTasks();
+}
+
+/** \brief Send a command line to the protocol like the USB endpoint does
+ *
+ * \param line char* the command without line end, e.g. "$m 0"
+ * \return void
+ *
+ */
+static void command(char * line)
+{
+    char buffer[RXBUFFERSIZE];
+    snprintf(buffer, sizeof(buffer), "%s\n", line);
+    serialCom(buffer, EndPoint_USB);
+    runSignalledTasks();
+}
+
+/** \brief The boot sequence of main() as far as it matters without hardware, with SBus as receiver
+ *
+ * \param scenario const scenario_t*
+ * \return void
+ *
+ */
+static void boot(const scenario_t * scenario)
+{
+    char line[80];
+
+    initTimebase();
+    TIM3->CCMR2 = TIM_CCMR2_OC3PE | TIM_CCMR2_OC4PE;
+    TIM5->CR1 = TIM_CR1_CEN;
+    TIM5->CNT = (uint32_t) scenario->start;
+
+    setDefaultSettings();
+    activesettings.receivertype = RECEIVER_TYPE_SBUS;
+    activesettings.esc_scale = 12;
+    activesettings.pos_start = scenario->pos_start;
+    activesettings.pos_end = scenario->pos_end;
+    TIM3->CCR3 = activesettings.esc_neutral_pos;
+    setServoProtocol(activesettings.servo_protocol);
+
+    huart1.Instance = USART1;
+    huart1.pRxBuffPtr = getSBUSFrameAddress();
+    huart1.RxXferCount = SBUS_FRAME_SIZE;
+    USART1->CR1 = USART_CR1_RXNEIE;
+
+    initSimulation();
+    initController();
+    getSimulationParams()->slope = scenario->slope;
+    setSimulation(1);
+
+    /* the settings of the scenario are made via the protocol, as the user would */
+    command("$r 1");
+    snprintf(line, sizeof(line), "$m %d", scenario->mode);
+    command(line);
+    snprintf(line, sizeof(line), "$c %f %f %f", scenario->p, scenario->i, scenario->d);
+    command(line);
+    snprintf(line, sizeof(line), "$a %d %d", scenario->max_accel, scenario->max_accel);
+    command(line);
+    snprintf(line, sizeof(line), "$k %f", scenario->slip_threshold);
+    command(line);
+    if (scenario->stream != 0)
+    {
+        command("$q 1");
+    }
+    if (scenario->commands != NULL)
+    {
+        char commands[RXBUFFERSIZE];
+        char * next;
+        strncpy(commands, scenario->commands, sizeof(commands) - 1);
+        commands[sizeof(commands) - 1] = 0;
+        for (next = strtok(commands, ";"); next != NULL; next = strtok(NULL, ";"))
+        {
+            command(next);
+        }
+    }
+}
+
+/** \brief Run one scenario and score it
+ *
+ * \param scenario const scenario_t*
+ * \param trace uint8_t 1 to print every cycle
+ * \param score score_t*
+ * \return void
+ *
+ */
+static void runScenario(const scenario_t * scenario, uint8_t trace, score_t * score)
+{
+    struct timespec t0, t1;
+    double error_sum = 0.0;
+    uint32_t tracked = 0;
+    int32_t release_pos = scenario->start;
+    int32_t extreme;
+    int8_t direction = (scenario->stick + scenario->stream >= 0) ? 1 : -1;
+    uint8_t ebrake = 0;
+    uint32_t slip_cycles = 0;
+    uint32_t cycle;
+    int32_t * positions = malloc(scenario->cycles * sizeof(int32_t));
+
+    memset(score, 0, sizeof(*score));
+    boot(scenario);
+    for (cycle = 0; cycle < SIM_WARMUP_CYCLES; cycle++)
+    {
+        runCycle(0);
+    }
+    setConsoleEcho(trace);
+    extreme = scenario->start;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (cycle = 0; cycle < scenario->cycles; cycle++)
+    {
+        int16_t stick = (cycle < scenario->stick_cycles) ? scenario->stick : 0;
+        if (scenario->stream != 0)
+        {
+            uint32_t moving = (cycle < scenario->stick_cycles) ? cycle : scenario->stick_cycles;
+            sendSetpointFrame(scenario->start + (int32_t) (scenario->stream * (moving * SIM_CYCLE_US / 1e6)),
+                              (cycle < scenario->stick_cycles) ? scenario->stream : 0);
+        }
+
+        if (slip_cycles > 0)
+        {
+            slip_offset += SIM_SLIP_STEPS * direction;
+            slip_cycles--;
+        }
+        runCycle(stick);
+
+        int32_t pos = (int32_t) ENCODER_VALUE;
+        if (scenario->slip_pos != 0 && slip_offset == 0 && slip_cycles == 0 && (pos - scenario->slip_pos) * direction >= 0)
+        {
+            plantparams_t * params = getSimulationParams();
+            params->max_thrust *= SIM_SLIP_TRACTION;
+            params->brake *= SIM_SLIP_TRACTION;
+            slip_cycles = SIM_SLIP_CYCLES;
+        }
+        positions[cycle] = pos;
+        if ((pos - extreme) * direction > 0)
+        {
+            extreme = pos;
+        }
+        if (cycle == scenario->stick_cycles)
+        {
+            release_pos = pos;
+        }
+        if (controllerstatus.monitor == EMERGENCYBRAKE && !ebrake)
+        {
+            score->emergency_brakes++;
+        }
+        ebrake = (controllerstatus.monitor == EMERGENCYBRAKE);
+        if (activesettings.mode == MODE_ABSOLUTE_POSITION)
+        {
+            double e = (double) (getTargetPos() - pos);
+            error_sum += e * e;
+            tracked++;
+            if (fabs(e) > score->tracking_max)
+            {
+                score->tracking_max = fabs(e);
+            }
+        }
+        if (trace)
+        {
+            printf("%6.2f traction %.2f stick %4d target %6ld pos %6ld esc %4u monitor %d %s\n", cycle * SIM_CYCLE_US / 1e6, getTractionState()->scale, stick,
+                   (long) getTargetPos(), (long) pos, (unsigned) getServoOutput(SERVO_ESC), controllerstatus.monitor,
+                   getSafeModeLabel());
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    score->cycles = scenario->cycles;
+    score->wall_ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    score->final_pos = positions[scenario->cycles - 1];
+    score->slip_events = getTractionState()->events;
+    score->tracking_rms = (tracked > 0) ? sqrt(error_sum / tracked) : 0.0;
+    score->stop_distance = (double) ((score->final_pos - release_pos) * direction);
+    for (cycle = scenario->stick_cycles; cycle < scenario->cycles; cycle++)
+    {
+        double overshoot = (double) ((positions[cycle] - score->final_pos) * direction);
+        if (overshoot > score->overshoot)
+        {
+            score->overshoot = overshoot;
+        }
+    }
+    if (direction > 0)
+    {
+        score->endpoint_overrun = (double) (extreme - scenario->pos_end);
+    }
+    else
+    {
+        score->endpoint_overrun = (double) (scenario->pos_start - extreme);
+    }
+    free(positions);
+}
+
+/** \brief Run the scenario in a child process, so it starts with the firmware freshly reset
+ *
+ * \param scenario const scenario_t*
+ * \param trace uint8_t
+ * \param score score_t*
+ * \return int8_t 0 if ok, -1 if the child failed
+ *
+ */
+static int8_t forkScenario(const scenario_t * scenario, uint8_t trace, score_t * score)
+{
+    int fd[2];
+    int status;
+    pid_t pid;
+    ssize_t n;
+
+    fflush(stdout);
+    if (pipe(fd) != 0)
+    {
+        return -1;
+    }
+    pid = fork();
+    if (pid < 0)
+    {
+        return -1;
+    }
+    if (pid == 0)
+    {
+        close(fd[0]);
+        runScenario(scenario, trace, score);
+        fflush(stdout);
+        n = write(fd[1], score, sizeof(*score));
+        _exit(n == sizeof(*score) ? 0 : 1);
+    }
+    close(fd[1]);
+    n = read(fd[0], score, sizeof(*score));
+    close(fd[0]);
+    waitpid(pid, &status, 0);
+    return (n == sizeof(*score) && WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -1;
+}
+
+/** \brief Compare the score with the limits of the scenario
+ *
+ * \return uint8_t 1 if all are within their limits
+ *
+ */
+static uint8_t checkScore(const scenario_t * scenario, const score_t * score)
+{
+    uint8_t ok = 1;
+    if (scenario->mode == MODE_ABSOLUTE_POSITION && score->tracking_rms > scenario->max_tracking_error)
+    {
+        ok = 0;
+    }
+    if (score->overshoot > scenario->max_overshoot)
+    {
+        ok = 0;
+    }
+    if (score->endpoint_overrun > scenario->max_endpoint_overrun)
+    {
+        ok = 0;
+    }
+    if (score->emergency_brakes > scenario->max_emergency_brakes)
+    {
+        ok = 0;
+    }
+    if (score->slip_events > scenario->max_slip_events)
+    {
+        ok = 0;
+    }
+    return ok;
+}
+
+/** \brief A stream of setpoint frames with a byte lost in the middle of one frame and the sync byte of another
+ *
+ * The decoder has to find the following frames again without passing any frame byte to the text command parser,
+ * and a text command after the stream has to get through.
+ *
+ * \return uint8_t 1 if ok
+ *
+ */
+static uint8_t testSetpointResync(void)
+{
+    setpointdecoder_t decoder;
+    uint8_t frame[SETPOINT_FRAME_SIZE];
+    char * text = "$q 0\n";
+    uint32_t parsed = 0;            // bytes the text command parser got
+    uint8_t line_empty = 1;
+    uint8_t n;
+    uint8_t i;
+    const setpointstats_t * stats = getSetpointStats();
+
+    memset(&decoder, 0, sizeof(decoder));
+    enableSetpointStream(1, SETPOINT_DEFAULT_DELAY);
+    for (n = 0; n < SIM_RESYNC_FRAMES; n++)
+    {
+        buildSetpointFrame(frame, 1000 + 10 * n, 500);
+        for (i = 0; i < SETPOINT_FRAME_SIZE; i++)
+        {
+            if ((n == 5 && i == 6) || (n == 12 && i == 0))
+            {
+                continue;
+            }
+            if (!decodeSetpointByte(&decoder, frame[i], line_empty))
+            {
+                parsed++;
+                line_empty = 0;
+            }
+        }
+        advanceTime(5000);
+    }
+    if (parsed != 0 || stats->frames != SIM_RESYNC_FRAMES - 2 || stats->checksum_errors != 1)
+    {
+        printf("setpoint resync: %u bytes to the parser, %u frames, %u checksum errors\n", (unsigned) parsed,
+               (unsigned) stats->frames, (unsigned) stats->checksum_errors);
+        return 0;
+    }
+
+    advanceTime((SETPOINT_RESYNC_TIMEOUT + 1) * 1000);
+    for (i = 0; text[i] != 0; i++)
+    {
+        if (!decodeSetpointByte(&decoder, (uint8_t) text[i], line_empty))
+        {
+            parsed++;
+            line_empty = 0;
+        }
+    }
+    if (parsed != strlen(text))
+    {
+        printf("setpoint resync: %u of %u text bytes to the parser\n", (unsigned) parsed, (unsigned) strlen(text));
+        return 0;
+    }
+    return 1;
+}
+
+static int runRegression(void)
+{
+    uint8_t i;
+    int failed = 0;
+
+    printf("%-17s %10s %10s %10s %10s %10s %7s %7s  %s\n", "scenario", "rms err", "max err", "overshoot", "stop dist", "ep overrun",
+           "ebrakes", "slips", "result");
+    for (i = 0; i < SCENARIO_COUNT; i++)
+    {
+        score_t score;
+        uint8_t ok = 0;
+        if (forkScenario(&scenarios[i], 0, &score) == 0)
+        {
+            ok = checkScore(&scenarios[i], &score);
+            printf("%-17s %10.1f %10.1f %10.1f %10.1f %10.1f %7u %7u  %s\n", scenarios[i].name, score.tracking_rms, score.tracking_max,
+                   score.overshoot, score.stop_distance, score.endpoint_overrun, score.emergency_brakes, score.slip_events,
+                   ok ? "ok" : "FAILED");
+        }
+        else
+        {
+            printf("%-17s crashed\n", scenarios[i].name);
+        }
+        if (!ok)
+        {
+            failed++;
+        }
+    }
+    if (testSetpointResync())
+    {
+        printf("%-89s%s\n", "setpoint resync", "ok");
+    }
+    else
+    {
+        printf("%-89s%s\n", "setpoint resync", "FAILED");
+        failed++;
+    }
+    printf("%d of %u scenarios failed\n", failed, (unsigned) SCENARIO_COUNT + 1);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static int runBenchmark(uint32_t runs)
+{
+    uint8_t i;
+    uint32_t r;
+    double total_ns = 0.0;
+    uint64_t total_cycles = 0;
+
+    printf("%-17s %12s %12s %12s\n", "scenario", "cycles", "ns/cycle", "x realtime");
+    for (i = 0; i < SCENARIO_COUNT; i++)
+    {
+        double ns = 0.0;
+        uint64_t cycles = 0;
+        for (r = 0; r < runs; r++)
+        {
+            score_t score;
+            if (forkScenario(&scenarios[i], 0, &score) != 0)
+            {
+                printf("%-17s crashed\n", scenarios[i].name);
+                return EXIT_FAILURE;
+            }
+            ns += score.wall_ns;
+            cycles += score.cycles;
+        }
+        printf("%-17s %12llu %12.0f %12.0f\n", scenarios[i].name, (unsigned long long) cycles, ns / cycles,
+               cycles * (SIM_CYCLE_US * 1000.0) / ns);
+        total_ns += ns;
+        total_cycles += cycles;
+    }
+    printf("%-17s %12llu %12.0f %12.0f\n", "all", (unsigned long long) total_cycles, total_ns / total_cycles,
+           total_cycles * (SIM_CYCLE_US * 1000.0) / total_ns);
+    return EXIT_SUCCESS;
+}
+
+static int runTrace(char * name)
+{
+    uint8_t i;
+    for (i = 0; i < SCENARIO_COUNT; i++)
+    {
+        if (strcmp(scenarios[i].name, name) == 0)
+        {
+            score_t score;
+            return (forkScenario(&scenarios[i], 1, &score) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    fprintf(stderr, "unknown scenario %s\n", name);
+    return EXIT_FAILURE;
+}
+
+/*
+ * cablecamsim              run all scenarios and check their scores, exit code 1 if one is out of its limits
+ * cablecamsim -b [runs]    benchmark, every scenario is run that many times
+ * cablecamsim -t name      print every cycle of one scenario together with the firmware output
+ */
+int main(int argc, char * argv[])
+{
+    if (argc >= 2 && strcmp(argv[1], "-b") == 0)
+    {
+        return runBenchmark((argc >= 3) ? (uint32_t) atoi(argv[2]) : SIM_BENCH_RUNS);
+    }
+    else if (argc >= 3 && strcmp(argv[1], "-t") == 0)
+    {
+        return runTrace(argv[2]);
+    }
+    else if (argc == 1)
+    {
+        return runRegression();
+    }
+    fprintf(stderr, "usage: %s [-b [runs] | -t scenario]\n", argv[0]);
+    return EXIT_FAILURE;
+}
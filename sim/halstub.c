@@ -0,0 +1,234 @@
+#include "halstub.h"
+#include "scheduler.h"
+#include "arm_math.h"
+#include "stdio.h"
+
+/*
+ * The registers the firmware reads and writes directly: TIM2 is the microsecond timebase, TIM3 the ESC and servo
+ * output, TIM5 the encoder counter and USART1 the SBus input.
+ */
+TIM_TypeDef sim_TIM1;
+TIM_TypeDef sim_TIM2;
+TIM_TypeDef sim_TIM3;
+TIM_TypeDef sim_TIM5;
+USART_TypeDef sim_USART1;
+RCC_TypeDef sim_RCC;
+USART_TypeDef sim_USART2;
+USART_TypeDef sim_USART3;
+DWT_Type sim_DWT;
+CoreDebug_Type sim_CoreDebug;
+uint32_t sim_primask = 0;
+
+uint32_t SystemCoreClock = 16000000;
+
+/*
+ * The handles main.c defines on the target
+ */
+RTC_HandleTypeDef hrtc;
+SPI_HandleTypeDef hspi1;
+SPI_HandleTypeDef hspi3;
+UART_HandleTypeDef huart1;
+UART_HandleTypeDef huart2;
+UART_HandleTypeDef huart3;
+
+static uint64_t now_us = 0;
+static uint32_t backup[20];
+static uint32_t signals = 0;
+static uint8_t console_echo = 0;
+
+/** \brief Let the simulated time pass, all clocks of the firmware follow
+ *
+ * \param us uint32_t
+ * \return void
+ *
+ */
+void advanceTime(uint32_t us)
+{
+    now_us += us;
+    TIM2->CNT += us;
+    DWT->CYCCNT += us * (SystemCoreClock / 1000000);
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t) (now_us / 1000);
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    advanceTime(Delay * 1000);
+}
+
+void setConsoleEcho(uint8_t echo)
+{
+    console_echo = echo;
+}
+
+/*
+ * The USB CDC endpoint, the output goes to stdout if wanted
+ */
+uint8_t CDC_TransmitString(char * ptr)
+{
+    if (console_echo)
+    {
+        fputs(ptr, stdout);
+    }
+    return 0;
+}
+
+uint32_t CDC_GetTxFree(void)
+{
+    return 0x10000;
+}
+
+void USBPeriodElapsed(void)
+{
+}
+
+/*
+ * The scheduler, the simulation runs the tasks itself in the order of their priorities
+ */
+void signalTask(TASK_t id)
+{
+    signals |= (1UL << id);
+}
+
+/** \brief The tasks signalled since the last call
+ *
+ * \return uint32_t one bit per TASK_t
+ *
+ */
+uint32_t takeSignals(void)
+{
+    uint32_t s = signals;
+    signals = 0;
+    return s;
+}
+
+const task_t * getTask(TASK_t id)
+{
+    static task_t task;
+    (void) id;
+    return &task;
+}
+
+uint32_t getStackUsage(void)
+{
+    return 0;
+}
+
+/*
+ * Peripherals without a model
+ */
+void HAL_GPIO_WritePin(GPIO_TypeDef * GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+}
+
+void HAL_PWR_EnableBkUpAccess(void)
+{
+}
+
+void HAL_PWR_ConfigPVD(PWR_PVDTypeDef * sConfigPVD)
+{
+}
+
+void HAL_PWR_EnablePVD(void)
+{
+}
+
+uint32_t HAL_RTCEx_BKUPRead(RTC_HandleTypeDef * hrtc, uint32_t BackupRegister)
+{
+    return (BackupRegister < 20) ? backup[BackupRegister] : 0;
+}
+
+void HAL_RTCEx_BKUPWrite(RTC_HandleTypeDef * hrtc, uint32_t BackupRegister, uint32_t Data)
+{
+    if (BackupRegister < 20)
+    {
+        backup[BackupRegister] = Data;
+    }
+}
+
+uint32_t HAL_TIM_ReadCapturedValue(TIM_HandleTypeDef * htim, uint32_t Channel)
+{
+    return 0;
+}
+
+/*
+ * There is neither an eeprom nor an IMU on the SPI bus and the uarts 2/3 are not connected
+ */
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef * hspi, uint8_t * pData, uint16_t Size, uint32_t Timeout)
+{
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef * hspi, uint8_t * pData, uint16_t Size, uint32_t Timeout)
+{
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef * hspi, uint8_t * pTxData, uint8_t * pRxData, uint16_t Size, uint32_t Timeout)
+{
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef * hspi, uint8_t * pTxData, uint8_t * pRxData, uint16_t Size)
+{
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef * huart, uint8_t * pData, uint16_t Size)
+{
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef * huart, uint8_t * pData, uint16_t Size)
+{
+    return HAL_ERROR;
+}
+
+/*
+ * CMSIS-DSP
+ */
+void arm_mean_f32(float32_t * pSrc, uint32_t blockSize, float32_t * pResult)
+{
+    float32_t sum = 0.0f;
+    uint32_t i;
+    for (i = 0; i < blockSize; i++)
+    {
+        sum += pSrc[i];
+    }
+    *pResult = sum / blockSize;
+}
+
+void arm_offset_f32(float32_t * pSrc, float32_t offset, float32_t * pDst, uint32_t blockSize)
+{
+    uint32_t i;
+    for (i = 0; i < blockSize; i++)
+    {
+        pDst[i] = pSrc[i] + offset;
+    }
+}
+
+void arm_dot_prod_f32(float32_t * pSrcA, float32_t * pSrcB, uint32_t blockSize, float32_t * result)
+{
+    float32_t sum = 0.0f;
+    uint32_t i;
+    for (i = 0; i < blockSize; i++)
+    {
+        sum += pSrcA[i] * pSrcB[i];
+    }
+    *result = sum;
+}
@@ -0,0 +1,17 @@
+#ifndef HALSTUB_H_
+#define HALSTUB_H_
+
+#include "stm32f4xx_hal.h"
+
+/*
+ * The HAL and register stub of the host build. The peripherals the firmware accesses directly are plain variables,
+ * see include/stm32f4xx.h, the HAL functions do nothing or report an error for hardware that does not exist.
+ */
+
+extern UART_HandleTypeDef huart1;
+
+void advanceTime(uint32_t us);
+void setConsoleEcho(uint8_t echo);
+uint32_t takeSignals(void);
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef SIM_ARM_MATH_H_
+#define SIM_ARM_MATH_H_
+
+/*
+ * Host build: the few CMSIS-DSP functions the firmware uses, implemented in plain C in halstub.c.
+ * The real arm_math.h needs the SIMD intrinsics of the Cortex-M4.
+ */
+#include "stdint.h"
+
+typedef float float32_t;
+
+void arm_mean_f32(float32_t * pSrc, uint32_t blockSize, float32_t * pResult);
+void arm_offset_f32(float32_t * pSrc, float32_t offset, float32_t * pDst, uint32_t blockSize);
+void arm_dot_prod_f32(float32_t * pSrcA, float32_t * pSrcB, uint32_t blockSize, float32_t * result);
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef SIM_STM32F4XX_H_
+#define SIM_STM32F4XX_H_
+
+/*
+ * Host build: the device header of the STM32F405 with the peripherals the firmware accesses directly mapped to
+ * plain variables instead of their register addresses, see halstub.c. The core intrinsics are replaced as well,
+ * the ones of cmsis_gcc.h are ARM assembler.
+ */
+#include "stdint.h"
+
+#define __CMSIS_GCC_H
+
+#define __ASM                   __asm
+#define __INLINE                inline
+#define __STATIC_INLINE         static inline
+
+extern uint32_t sim_primask;
+
+static inline void __enable_irq(void) { sim_primask = 0; }
+static inline void __disable_irq(void) { sim_primask = 1; }
+static inline uint32_t __get_PRIMASK(void) { return sim_primask; }
+static inline void __set_PRIMASK(uint32_t primask) { sim_primask = primask; }
+static inline uint32_t __get_BASEPRI(void) { return 0; }
+static inline void __set_BASEPRI(uint32_t value) { (void) value; }
+static inline uint32_t __get_FPSCR(void) { return 0; }
+static inline void __set_FPSCR(uint32_t fpscr) { (void) fpscr; }
+static inline void __NOP(void) { }
+static inline void __WFI(void) { }
+static inline void __WFE(void) { }
+static inline void __SEV(void) { }
+static inline void __ISB(void) { __sync_synchronize(); }
+static inline void __DSB(void) { __sync_synchronize(); }
+static inline void __DMB(void) { __sync_synchronize(); }
+static inline uint32_t __REV(uint32_t value) { return __builtin_bswap32(value); }
+static inline uint32_t __REV16(uint32_t value) { return ((value & 0xFF00FF00U) >> 8) | ((value & 0x00FF00FFU) << 8); }
+static inline int32_t __REVSH(int32_t value) { return (int16_t) __builtin_bswap16((uint16_t) value); }
+static inline uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+    int i;
+    for (i = 0; i < 32; i++)
+    {
+        result = (result << 1) | ((value >> i) & 1U);
+    }
+    return result;
+}
+#define __CLZ(value)            ((uint8_t) ((value) == 0 ? 32 : __builtin_clz(value)))
+
+#include_next "stm32f4xx.h"
+
+#undef TIM1
+#undef TIM2
+#undef TIM3
+#undef TIM5
+#undef USART1
+#undef RCC
+#undef USART2
+#undef USART3
+#undef DWT
+#undef CoreDebug
+
+extern TIM_TypeDef sim_TIM1;
+extern TIM_TypeDef sim_TIM2;
+extern TIM_TypeDef sim_TIM3;
+extern TIM_TypeDef sim_TIM5;
+extern USART_TypeDef sim_USART1;
+extern RCC_TypeDef sim_RCC;
+extern USART_TypeDef sim_USART2;
+extern USART_TypeDef sim_USART3;
+extern DWT_Type sim_DWT;
+extern CoreDebug_Type sim_CoreDebug;
+
+#define TIM1                    (&sim_TIM1)
+#define TIM2                    (&sim_TIM2)
+#define TIM3                    (&sim_TIM3)
+#define TIM5                    (&sim_TIM5)
+#define USART1                  (&sim_USART1)
+#define RCC                     (&sim_RCC)
+#define USART2                  (&sim_USART2)
+#define USART3                  (&sim_USART3)
+#define DWT                     (&sim_DWT)
+#define CoreDebug               (&sim_CoreDebug)
+
+#endif
@@ -0,0 +1,82 @@
+#include "accelwindow.h"
+#include "controller.h"
+
+void resetAccelWindow(accelwindow_t * window)
+{
+    window->position = 0;
+    window->count = 0;
+}
+
+/** \brief Add the values of this controller cycle
+ *
+ * \param window accelwindow_t*
+ * \param pos int32_t Hall sensor position
+ * \param accel float m/s^2 the acceleration the wheel should have had within this cycle, e.g. measured by the IMU
+ * \return void
+ *
+ */
+void addAccelWindow(accelwindow_t * window, int32_t pos, float accel)
+{
+    window->pos[window->position] = pos;
+    window->accel[window->position] = accel;
+    window->position = (window->position + 1) % ACCEL_WINDOW_SIZE;
+    if (window->count < ACCEL_WINDOW_SIZE)
+    {
+        window->count++;
+    }
+}
+
+/** \brief The speed of the wheel over the last ACCEL_WINDOW_CYCLES cycles
+ *
+ * \param window const accelwindow_t*
+ * \param steps_per_meter float
+ * \return float m/s, 0 until the window contains that many cycles
+ *
+ */
+float getWindowSpeed(const accelwindow_t * window, float steps_per_meter)
+{
+    if (window->count <= ACCEL_WINDOW_CYCLES)
+    {
+        return 0.0f;
+    }
+    uint8_t newest = (window->position + ACCEL_WINDOW_SIZE - 1) % ACCEL_WINDOW_SIZE;
+    uint8_t middle = (newest + ACCEL_WINDOW_SIZE - ACCEL_WINDOW_CYCLES) % ACCEL_WINDOW_SIZE;
+    return ((float) (window->pos[newest] - window->pos[middle])) / steps_per_meter / (float) (ACCEL_WINDOW_CYCLES * Ta);
+}
+
+/** \brief The acceleration of the wheel and the reference acceleration over the same window
+ *
+ * The wheel acceleration is the change of the speed over the first half of the window to the one over the second
+ * half. That weights the acceleration of each cycle with a triangle peaking in the middle of the window, the
+ * reference acceleration is averaged with the same weights, so both are comparable.
+ *
+ * \param window const accelwindow_t*
+ * \param steps_per_meter float
+ * \param wheel float* m/s^2
+ * \param reference float* m/s^2
+ * \return int8_t 0 if ok, -1 if the window is not filled yet
+ *
+ */
+int8_t getWindowAcceleration(const accelwindow_t * window, float steps_per_meter, float * wheel, float * reference)
+{
+    uint8_t j;
+    float sum = 0.0f;
+
+    if (window->count < ACCEL_WINDOW_SIZE)
+    {
+        return -1;
+    }
+    uint8_t newest = (window->position + ACCEL_WINDOW_SIZE - 1) % ACCEL_WINDOW_SIZE;
+    uint8_t middle = (newest + ACCEL_WINDOW_SIZE - ACCEL_WINDOW_CYCLES) % ACCEL_WINDOW_SIZE;
+    uint8_t oldest = window->position;
+    int32_t change = window->pos[newest] - 2 * window->pos[middle] + window->pos[oldest];
+    *wheel = ((float) change) / steps_per_meter / (float) (ACCEL_WINDOW_CYCLES * Ta * ACCEL_WINDOW_CYCLES * Ta);
+
+    for (j = 0; j < 2 * ACCEL_WINDOW_CYCLES; j++)
+    {
+        float weight = (j < ACCEL_WINDOW_CYCLES) ? ((float) j + 0.5f) : ((float) (2 * ACCEL_WINDOW_CYCLES - j) - 0.5f);
+        sum += weight * window->accel[(newest + ACCEL_WINDOW_SIZE - j) % ACCEL_WINDOW_SIZE];
+    }
+    *reference = sum / (float) (ACCEL_WINDOW_CYCLES * ACCEL_WINDOW_CYCLES);
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include "autotune.h"
+#include "controller.h"
+#include "job.h"
+#include "math.h"
+
+/*
+ * The relay experiment drives the ESC with +amplitude while the cablecam is below the hold position and with
+ * -amplitude while above. The cablecam oscillates around the hold position then, its period is the ultimate
+ * period and the ultimate gain is 4 * amplitude / (pi * oscillation amplitude).
+ */
+typedef enum {
+    AUTOTUNE_IDLE = 0,
+    AUTOTUNE_RUNNING,
+    AUTOTUNE_MEASURED,
+    AUTOTUNE_ABORTED
+} AUTOTUNE_PHASE_t;
+
+static AUTOTUNE_PHASE_t phase = AUTOTUNE_IDLE;
+static int16_t relay_amplitude;
+static int16_t relay_output;
+static int32_t hold_pos;
+static int32_t pos_min;
+static int32_t pos_max;
+static double brake_accel;          // Hall sensor steps per cycle^2 the cablecam is assumed to brake with
+static uint16_t cycle;
+static uint16_t period_start;       // cycle of the last switch to +amplitude
+static uint8_t periods;             // number of periods completed
+static int32_t e_max;
+static int32_t e_min;
+static uint32_t sum_period;         // cycles
+static int32_t sum_peak_to_peak;    // Hall sensor steps
+
+static autotuneresult_t result;
+
+/*
+ * Kp, Ti and Td of each rule as factors of Ku and Tu
+ */
+static const float rules[AUTOTUNE_RULES][3] =
+{
+    {0.6f, 0.5f, 0.125f},
+    {0.33f, 0.5f, 0.33f},
+    {0.2f, 0.5f, 0.33f},
+    {0.4545f, 2.2f, 0.1587f}
+};
+
+static char * rulelabels[AUTOTUNE_RULES] = {"Ziegler-Nichols", "some overshoot", "no overshoot", "Tyreus-Luyben"};
+
+/** \brief Start the relay experiment around the current position, the controller calls autoTuneCycle() from now on
+ *
+ * \param amplitude int16_t relay amplitude in controller output units
+ * \param hold int32_t Hall sensor position to oscillate around
+ * \param min_pos int32_t the experiment is aborted below
+ * \param max_pos int32_t the experiment is aborted above
+ * \param brake double deceleration in Hall sensor steps per cycle^2 the braking distance is calculated with
+ * \return void
+ *
+ */
+void startAutoTune(int16_t amplitude, int32_t hold, int32_t min_pos, int32_t max_pos, double brake)
+{
+    relay_amplitude = amplitude;
+    relay_output = amplitude;
+    hold_pos = hold;
+    pos_min = min_pos;
+    pos_max = max_pos;
+    brake_accel = (brake > 0.0f) ? brake : 1.0f;
+    cycle = 0;
+    period_start = 0;
+    periods = 0;
+    e_max = 0;
+    e_min = 0;
+    sum_period = 0;
+    sum_peak_to_peak = 0;
+    result.valid = 0;
+    phase = AUTOTUNE_RUNNING;
+}
+
+uint8_t isAutoTuneActive()
+{
+    return phase == AUTOTUNE_RUNNING;
+}
+
+const autotuneresult_t * getAutoTuneResult()
+{
+    return &result;
+}
+
+/** \brief One controller cycle of the relay experiment, returns the output to use instead of the PID loop's
+ *
+ * The experiment is aborted already when the cablecam would stop past the limits, so it never overruns them
+ * by the braking distance at the relay speed.
+ *
+ * \param pos int32_t current Hall sensor position
+ * \param speed int32_t Hall sensor steps per cycle
+ * \param abort uint8_t 1 to stop the experiment, e.g. because the stick got moved or the RC signal is lost
+ * \return int16_t controller output, positive to increase the position
+ *
+ */
+int16_t autoTuneCycle(int32_t pos, int32_t speed, uint8_t abort)
+{
+    int32_t e = hold_pos - pos;
+    double stop = pos + ((double) speed) * fabs((double) speed) / (2.0f * brake_accel);
+
+    if (abort || stop < pos_min || stop > pos_max || ++cycle > AUTOTUNE_MAX_CYCLES)
+    {
+        phase = AUTOTUNE_ABORTED;
+        return 0;
+    }
+
+    if (e > e_max)
+    {
+        e_max = e;
+    }
+    if (e < e_min)
+    {
+        e_min = e;
+    }
+
+    if (e > AUTOTUNE_HYSTERESIS && relay_output < 0)
+    {
+        /* a full period is over */
+        relay_output = relay_amplitude;
+        if (period_start != 0)
+        {
+            if (periods >= AUTOTUNE_SETTLE_PERIODS)
+            {
+                sum_period += cycle - period_start;
+                sum_peak_to_peak += e_max - e_min;
+            }
+            periods++;
+            if (periods >= AUTOTUNE_SETTLE_PERIODS + AUTOTUNE_MEASURE_PERIODS)
+            {
+                phase = AUTOTUNE_MEASURED;
+                return 0;
+            }
+        }
+        period_start = cycle;
+        e_max = e;
+        e_min = e;
+    }
+    else if (e < -AUTOTUNE_HYSTERESIS && relay_output > 0)
+    {
+        relay_output = -relay_amplitude;
+    }
+    return relay_output;
+}
+
+/** \brief One step of the auto-tune job, waits for the experiment and calculates the ultimate gain and period
+ *
+ * \param progress uint32_t* set to the number of oscillation periods so far
+ * \return int8_t JOB_RUNNING, JOB_DONE with the result available via getAutoTuneResult() or JOB_FAILED
+ *
+ */
+int8_t stepAutoTune(uint32_t * progress)
+{
+    *progress = periods;
+    if (phase == AUTOTUNE_RUNNING)
+    {
+        return JOB_RUNNING;
+    }
+    if (phase != AUTOTUNE_MEASURED || sum_peak_to_peak == 0)
+    {
+        phase = AUTOTUNE_IDLE;
+        return JOB_FAILED;
+    }
+    phase = AUTOTUNE_IDLE;
+
+    /* the hysteresis delays the switching, hence the effective amplitude is smaller */
+    double a = ((double) sum_peak_to_peak) / (2 * AUTOTUNE_MEASURE_PERIODS);
+    double a_effective = (a > AUTOTUNE_HYSTERESIS) ? sqrt(a * a - AUTOTUNE_HYSTERESIS * AUTOTUNE_HYSTERESIS) : a;
+
+    result.amplitude = relay_amplitude;
+    result.oscillation = a;
+    result.ku = 4.0 * relay_amplitude / (M_PI * a_effective);
+    result.tu = ((double) sum_period) * Ta / AUTOTUNE_MEASURE_PERIODS;
+    result.valid = 1;
+    return JOB_DONE;
+}
+
+/** \brief The PID gains of a tuning rule for the last result, in the units of $1, $2 and $3
+ *
+ * \param rule uint8_t 0..AUTOTUNE_RULES-1
+ * \param p double* Kp
+ * \param i double* Ki = Kp / Ti
+ * \param d double* Kd = Kp * Td
+ * \return void
+ *
+ */
+void getAutoTuneGains(uint8_t rule, double * p, double * i, double * d)
+{
+    *p = rules[rule][0] * result.ku;
+    *i = *p / (rules[rule][1] * result.tu);
+    *d = *p * rules[rule][2] * result.tu;
+}
+
+char * getAutoTuneRuleLabel(uint8_t rule)
+{
+    return rulelabels[rule];
+}
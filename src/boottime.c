@@ -0,0 +1,65 @@
+#include "boottime.h"
+
+/*
+ * DWT cycle counter value at the end of each boot stage, 0 if the stage was not reached yet.
+ */
+static uint32_t bootstagecycles[BOOT_STAGE_COUNT];
+
+static char * bootstagelabels[BOOT_STAGE_COUNT] = {"main",
+                                                   "esc output",
+                                                   "peripherals",
+                                                   "settings",
+                                                   "rc input",
+                                                   "controller",
+                                                   "usb",
+                                                   "imu",
+                                                   "first cycle"
+                                                  };
+
+/** \brief Start the DWT cycle counter and take the first timestamp
+ *
+ * The cycle counter counts CPU cycles since it got enabled, that is since main() was entered.
+ * The time between reset and main() is the startup code only and is not measured.
+ *
+ * \return void
+ *
+ */
+void initBootTime()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    setBootStage(BOOT_STAGE_MAIN);
+}
+
+/** \brief Mark the end of a boot stage
+ *
+ * Only the first call for each stage is recorded.
+ *
+ * \param stage BOOT_STAGE_t
+ * \return void
+ *
+ */
+void setBootStage(BOOT_STAGE_t stage)
+{
+    if (bootstagecycles[stage] == 0)
+    {
+        bootstagecycles[stage] = DWT->CYCCNT | 1; // never 0, that means not reached
+    }
+}
+
+/** \brief Time between entering main() and the end of the stage
+ *
+ * \param stage BOOT_STAGE_t
+ * \return uint32_t time in us, 0 if the stage was not reached yet
+ *
+ */
+uint32_t getBootStageTime(BOOT_STAGE_t stage)
+{
+    return bootstagecycles[stage] / (SystemCoreClock / 1000000);
+}
+
+char * getBootStageLabel(BOOT_STAGE_t stage)
+{
+    return bootstagelabels[stage];
+}
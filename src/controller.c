@@ -1,22 +1,49 @@
 #include "config.h"
 #include "protocol.h"
 #include "controller.h"
-#include "protocol.h"
 #include "clock_50Hz.h"
 #include "sbus.h"
+#include "controlplan.h"
+#include "posbackup.h"
+#include "shaper.h"
+#include "imu.h"
+#include "esctable.h"
+#include "job.h"
+#include "feedforward.h"
+#include "traction.h"
+#include "stickcurve.h"
+#include "tracking.h"
+#include "postrigger.h"
+#include "servo.h"
+#include "setpoint.h"
+#include "latency.h"
+#include "timebase.h"
+#include "autotune.h"
+#include "gainschedule.h"
+#include "math.h"
 
 extern sbusData_t sbusdata;
 
 void printControlLoop(int16_t input, double speed, double pos, double brakedistance, CONTROLLER_MONITOR_t monitor, uint16_t esc, Endpoints endpoint);
 void printPIDMonitor(double e, double y, Endpoints endpoint);
-int16_t stickCycle(double pos, double brakedistance);
+int16_t stickCycle(const controlplan_t * plan, double pos, double brakedistance);
+int16_t getBrakeAccel(const controlplan_t * plan, double pos, int32_t speed);
+double streamStep(const controlplan_t * plan, double setpoint, int32_t speed);
 
 /*
  * Preserve the previous filtered stick value to calculate the acceleration
  */
 int16_t stick_last_value = 0;
 
-double yalt = 0.0f, ealt = 0.0f, esum = 0.0f;
+double yalt = 0.0f, ealt = 0.0f, iterm = 0.0f;
+
+/*
+ * The PID gains in use, they follow the gain schedule gradually. The I term is kept as sum of Ki*Ta*e instead of Ki*Ta*sum(e),
+ * so a change of the gains acts on the future errors only and does not rescale the entire integral, the output does not jump.
+ * After a resetThrottle() the scheduled gains are taken as is.
+ */
+pidgains_t pidgains;
+uint8_t pidgains_valid = 0;
 
 
 int32_t pos_current_old = 0L;
@@ -24,6 +51,14 @@ double pos_target = 0.0f, pos_target_old = 0.0f;
 
 uint8_t endpointclicks = 0;
 uint16_t lastendpointswitch = 0;
+uint16_t lastzoneswitch = 0;
+
+/*
+ * The poti values the current max accel and max speed were derived from. The RC values jitter by a count or two,
+ * without a hysteresis that would change the limits and hence require a new control plan nearly every cycle.
+ */
+uint16_t max_accel_poti = 0;
+uint16_t max_speed_poti = 0;
 
 /*
  * To get the motor direction, we need to know if the stick was moved forward or reverse.
@@ -31,7 +66,24 @@ uint16_t lastendpointswitch = 0;
  */
 int32_t stickintegral = 0;
 
-#define Ta  0.02
+/*
+ * The direction the target position moved in last, the feed forward map of that direction is used while it stands still
+ */
+uint8_t feedforward_direction = FEEDFORWARD_FORWARD;
+
+/*
+ * The change of the target position in the last cycle, the setpoint stream accelerates from there like the stick does.
+ * The setpoint of the last cycle tells how fast the stream itself moves.
+ */
+double target_step = 0.0f;
+double stream_setpoint_old = 0.0f;
+uint8_t stream_setpoint_valid = 0;
+
+/*
+ * The speed the brake distance is calculated with in the modes driving the ESC directly. The Hall sensor counts whole
+ * steps, so at low speeds the speed of a single cycle jumps between e.g. 1 and 2, which would double the brake distance.
+ */
+double speed_brake_filtered = 0.0f;
 
 
 void setPIDValues(double kp, double ki, double kd)
@@ -39,19 +91,23 @@ void setPIDValues(double kp, double ki, double kd)
     activesettings.P = kp;
     activesettings.I = ki;
     activesettings.D = kd;
+    requestControlPlan();
 }
 
 void setPValue(double v)
 {
     activesettings.P = v;
+    requestControlPlan();
 }
 void setIValue(double v)
 {
     activesettings.I = v;
+    requestControlPlan();
 }
 void setDValue(double v)
 {
     activesettings.D = v;
+    requestControlPlan();
 }
 
 
@@ -73,6 +129,13 @@ int32_t getPos(void)
 
 void initController(void)
 {
+    compileControlPlan();
+    /*
+     * The encoder might have been set to the position of the last checkpoint, hence the
+     * speed calculation and the target position start from there.
+     */
+    pos_current_old = ENCODER_VALUE;
+    resetPosTarget();
     controllerstatus.safemode = INVALID_RC;
     controllerstatus.monitor = FREE;
 }
@@ -99,6 +162,16 @@ uint16_t getEndPointSwitch()
     return getDuty(activesettings.rc_channel_endpoint);
 }
 
+uint16_t getZoneSwitch()
+{
+    return getDuty(activesettings.rc_channel_zone);
+}
+
+uint16_t getYawStick()
+{
+    return getDuty(activesettings.rc_channel_yaw);
+}
+
 uint16_t getMaxAccelPoti()
 {
     return getDuty(activesettings.rc_channel_max_accel);
@@ -121,7 +194,7 @@ uint16_t getMaxSpeedPoti()
  *
  * Just to repeat, getDuty() returns a value like 1200 (neutral for SBUS), this function returns +200 then, assuming neutral is set to +1000.
  */
-int16_t getStickPositionRaw()
+int16_t getStickPositionRaw(const controlplan_t * plan)
 {
     /*
      * "value" is the duty signal rebased from the stick_neutral_pos to zero.
@@ -130,9 +203,9 @@ int16_t getStickPositionRaw()
      * Remember that getDuty() itself can return a value of 0 as well in case no valid RC signal was received either
      * or non received for a while.
      */
-    int16_t value = getDuty(activesettings.rc_channel_speed) - activesettings.stick_neutral_pos;
+    int16_t value = getDuty(activesettings.rc_channel_speed) - plan->stick_neutral_pos;
 
-    if (value == -activesettings.stick_neutral_pos) // in case getDuty() returned 0 meaning no valid stick position was received...
+    if (value == -plan->stick_neutral_pos) // in case getDuty() returned 0 meaning no valid stick position was received...
     {
         // No valid value for that, use Neutral
         return 0;
@@ -146,8 +219,8 @@ int16_t getStickPositionRaw()
          * an invalid signal as well. At startup the speed signal has to be in idle.
          */
         if ((controllerstatus.safemode == INVALID_RC || controllerstatus.safemode == NOT_NEUTRAL_AT_STARTUP) &&
-            (value > activesettings.stick_neutral_range ||
-             value < -activesettings.stick_neutral_range))
+            (value > plan->stick_neutral_range ||
+             value < -plan->stick_neutral_range))
         {
             if (controllerstatus.safemode == INVALID_RC)
             {
@@ -168,15 +241,15 @@ int16_t getStickPositionRaw()
     }
 
     /* Remove the neutral range */
-    if (value > activesettings.stick_neutral_range )
+    if (value > plan->stick_neutral_range )
     {
         // above idle is just fine
-        return value - activesettings.stick_neutral_range;
+        return value - plan->stick_neutral_range;
     }
-    else if (value < -activesettings.stick_neutral_range)
+    else if (value < -plan->stick_neutral_range)
     {
         // below negative idle is fine
-        return value + activesettings.stick_neutral_range;
+        return value + plan->stick_neutral_range;
     }
     else
     {
@@ -209,31 +282,40 @@ int16_t getStickPositionRaw()
  * \return stick_requested_value int16_t
  *
  */
-int16_t stickCycle(double pos, double brakedistance)
+int16_t stickCycle(const controlplan_t * plan, double pos, double brakedistance)
 {
     /*
      * WATCHOUT, while the stick values are all in us, the value, stick_requested_value, esc_out values are all in 0.1us units.
      * Else the acceleration would not be fine grained enough.
      */
-    int16_t tmp = getStickPositionRaw();
+    int16_t tmp = getStickPositionRaw(plan);
     stickintegral += tmp;
     int16_t value = tmp*10;
 
     int32_t speed = ENCODER_VALUE - pos_current_old; // When the current pos is greater than the previous, speed is positive
 
     // In passthrough mode the returned value is the raw value
-    if (activesettings.mode != MODE_PASSTHROUGH)
+    if (plan->mode != MODE_PASSTHROUGH)
     {
         /*
          * In all other modes the accel and speed limiters are turned on
          */
-        int16_t maxaccel = activesettings.stick_max_accel;
-        int16_t maxspeed = activesettings.stick_max_speed;
+        const rampfilter_limits_t * limits = &plan->limits[controllerstatus.safemode != OPERATIONAL];
+        int16_t maxaccel = limitTractionAccel(limits->max_accel); // reduced while the wheel slips
+        int16_t maxspeed = limits->max_speed; // already multiplied by 10
 
-        if (controllerstatus.safemode != OPERATIONAL)
+        /*
+         * The response curve gives finer control near neutral, precompiled into a table so it costs an interpolation only
+         */
+        value = applyStickCurve(plan->stick_curve[controllerstatus.safemode != OPERATIONAL], plan->stick_curve_scale, plan->stick_curve_range, tmp);
+
+        /*
+         * Along the rope the limits might be lower, and the cablecam has to slow down before it enters such a zone.
+         * Like the end points the zones are honored in OPERATIONAL mode only.
+         */
+        if (controllerstatus.safemode == OPERATIONAL)
         {
-            maxaccel = activesettings.stick_max_accel_safemode;
-            maxspeed = activesettings.stick_max_speed_safemode;
+            limitSpeedZones(plan->zones, plan->zone_count, pos, speed, stick_last_value, &maxspeed, &maxaccel);
         }
 
         int16_t diff = value - stick_last_value;
@@ -260,38 +342,27 @@ int16_t stickCycle(double pos, double brakedistance)
          * It is important to calculate the new value based on the acceleration first, then we have the new target speed,
          * now it is limited to an absolute value.
          */
-        if (value > maxspeed*10)
+        if (value > maxspeed)
         {
-            value = maxspeed*10;
+            value = maxspeed;
         }
-        else if (value < -maxspeed*10)
+        else if (value < -maxspeed)
         {
-            value = -maxspeed*10;
+            value = -maxspeed;
         }
 
 
 
-        if (controllerstatus.safemode == OPERATIONAL && activesettings.mode != MODE_PASSTHROUGH && activesettings.mode != MODE_LIMITER)
+        if (controllerstatus.safemode == OPERATIONAL && plan->mode != MODE_PASSTHROUGH && plan->mode != MODE_LIMITER)
         {
             /*
              * The current status is OPERATIONAL, hence the endpoints are honored.
              *
              * If we would overshoot the end points, then ignore the requested value and reduce the stick position by max_accel.
+             *
+             * Note: The control plan has pos_start <= pos_end always.
              */
 
-
-            /*
-             * The pos_start has to be smaller than pos_end always. This is checked in the end_point set logic.
-             * However there is a cases where this might not be so:
-             * Start and end point had been set but then only the start point is moved.
-             */
-            if (activesettings.pos_start > activesettings.pos_end)
-            {
-                double tmp = activesettings.pos_start;
-                activesettings.pos_start = activesettings.pos_end;
-                activesettings.pos_end = tmp;
-            }
-
             /*
              * One problem is the direction. Once the endpoint was overshot, a stick position driving the cablecam even further over
              * the limit is not allowed. But driving it back between start and end point is fine. But what value of the stick
@@ -312,17 +383,17 @@ int16_t stickCycle(double pos, double brakedistance)
              *
              *
              */
-            if (pos + brakedistance >= activesettings.pos_end)
+            if (pos + brakedistance >= plan->pos_end)
             {
                 /*
                  * In case the CableCam will overshoot the end point reduce the speed to zero.
                  * Only if the stick is in the reverse direction already, accept the value. Else you cannot maneuver
                  * back into the safe zone.
                  */
-                if (((int16_t) activesettings.esc_direction) * value > 0)
+                if (((int16_t) plan->esc_direction) * value > 0)
                 {
-                    value = stick_last_value - (maxaccel * ((int16_t) activesettings.esc_direction)); // reduce speed at full allowed acceleration
-                    if (value * ((int16_t) activesettings.esc_direction) < 0) // watch out to not get into reverse.
+                    value = stick_last_value - (maxaccel * ((int16_t) plan->esc_direction)); // reduce speed at full allowed acceleration
+                    if (value * ((int16_t) plan->esc_direction) < 0) // watch out to not get into reverse.
                     {
                         value = 0;
                     }
@@ -331,7 +402,7 @@ int16_t stickCycle(double pos, double brakedistance)
                     /*
                      * Failsafe: In case the endpoint itself had been overshot and stick says to do so further, stop immediately.
                      */
-                    if (pos >= activesettings.pos_end)
+                    if (pos >= plan->pos_end)
                     {
                         stick_last_value = 0;
                         return 0;
@@ -346,7 +417,7 @@ int16_t stickCycle(double pos, double brakedistance)
                 /*
                  * Failsafe: No matter what the user did going way over the endpoint at speed causes this function to return a speed=0 request.
                  */
-                if (pos + brakedistance >= activesettings.pos_end + activesettings.max_position_error && speed > 0)
+                if (pos + brakedistance >= plan->pos_end + plan->max_position_error && speed > 0)
                 {
                     /*
                      * We are in danger to overshoot the end point by max_position_error because we are moving with a speed > 0 towards
@@ -360,17 +431,17 @@ int16_t stickCycle(double pos, double brakedistance)
             }
 
 
-            if (pos - brakedistance <= activesettings.pos_start)
+            if (pos - brakedistance <= plan->pos_start)
             {
                 /*
                  * In case the CableCam will overshoot the start point reduce the speed to zero.
                  * Only if the stick is in the reverse direction already, accept the value. Else you cannot maneuver
                  * back into the safe zone.
                  */
-                if (((int16_t) activesettings.esc_direction) * value < 0)
+                if (((int16_t) plan->esc_direction) * value < 0)
                 {
-                    value = stick_last_value + (maxaccel * ((int16_t) activesettings.esc_direction)); // reduce speed at full allowed acceleration
-                    if (value * ((int16_t) activesettings.esc_direction) > 0) // watch out to not get into reverse.
+                    value = stick_last_value + (maxaccel * ((int16_t) plan->esc_direction)); // reduce speed at full allowed acceleration
+                    if (value * ((int16_t) plan->esc_direction) > 0) // watch out to not get into reverse.
                     {
                         value = 0;
                     }
@@ -379,7 +450,7 @@ int16_t stickCycle(double pos, double brakedistance)
                     /*
                      * Failsafe: In case the endpoint itself had been overshot and stick says to do so further, stop immediately.
                      */
-                    if (pos <= activesettings.pos_start)
+                    if (pos <= plan->pos_start)
                     {
                         stick_last_value = 0;
                         return 0;
@@ -394,7 +465,7 @@ int16_t stickCycle(double pos, double brakedistance)
                 /*
                  * Failsafe: No matter what the user did going way over the endpoint at speed causes this function to return a speed=0 request.
                  */
-                if (pos - brakedistance <= activesettings.pos_start - activesettings.max_position_error && speed < 0)
+                if (pos - brakedistance <= plan->pos_start - plan->max_position_error && speed < 0)
                 {
                     /*
                      * We are in danger to overshoot the end point by max_position_error because we are moving with a speed > 0 towards
@@ -485,24 +556,63 @@ int16_t stickCycle(double pos, double brakedistance)
                 activesettings.pos_start = pos;
             }
         }
+        requestControlPlan();
     }
     lastendpointswitch = currentendpointswitch; // Needed to identify a raising flank on the tip switch
 
+    /*
+     * Evaluate the zone switch. In programming mode a click adds a speed zone breakpoint at the current position
+     * with the current operational limits, which can be dialed in with the max accel and max speed potis.
+     */
+    uint16_t currentzoneswitch = getZoneSwitch();
+    if (currentzoneswitch > 1200 && controllerstatus.safemode == PROGRAMMING && lastzoneswitch <= 1200 && lastzoneswitch != 0)
+    {
+        if (addSpeedZone(ENCODER_VALUE, activesettings.stick_max_speed, activesettings.stick_max_accel) == 0)
+        {
+            PrintlnSerial_string("Zone point set", EndPoint_All);
+        }
+        else
+        {
+            PrintlnSerial_string("All zone points used already", EndPoint_All);
+        }
+        requestControlPlan();
+    }
+    lastzoneswitch = currentzoneswitch;
+
 
+    /*
+     * The potis change the settings, hence the plan has to be recompiled - but only if the value did change by more than the jitter.
+     * The compile is requested only, controllercycle() keeps working with the current plan until the command task compiled the new one.
+     */
+    uint8_t settings_changed = 0;
     uint16_t max_accel = getMaxAccelPoti();
-    if (max_accel != 0 && max_accel > activesettings.stick_neutral_pos + activesettings.stick_neutral_range)
+    if (max_accel != 0 && max_accel > plan->poti_threshold &&
+        (max_accel > max_accel_poti + POTI_HYSTERESIS || max_accel + POTI_HYSTERESIS < max_accel_poti))
     {
         /*
          * (max_accel - neutral) * 10 / esc_scale = 0...700      that would be way too much, should be rather 0..35, so a factor of 20
          * Hence removing the diff*10/scale/20 = diff/scale/2
          */
-        activesettings.stick_max_accel = 1 + ((max_accel - activesettings.stick_neutral_pos - activesettings.stick_neutral_range) / activesettings.esc_scale / 2);
+        int16_t v = 1 + (scaleESCOutput(plan, max_accel - plan->poti_threshold) / 2);
+        max_accel_poti = max_accel;
+        if (v != activesettings.stick_max_accel)
+        {
+            activesettings.stick_max_accel = v;
+            settings_changed = 1;
+        }
     }
 
     uint16_t max_speed = getMaxSpeedPoti();
-    if (max_speed != 0 && max_speed > activesettings.stick_neutral_pos + activesettings.stick_neutral_range)
+    if (max_speed != 0 && max_speed > plan->poti_threshold &&
+        (max_speed > max_speed_poti + POTI_HYSTERESIS || max_speed + POTI_HYSTERESIS < max_speed_poti))
     {
-       activesettings.stick_max_speed = 1 + ((max_speed - activesettings.stick_neutral_pos - activesettings.stick_neutral_range) * 10 / activesettings.esc_scale);
+        int16_t v = 1 + scaleESCOutput(plan, (max_speed - plan->poti_threshold) * 10);
+        max_speed_poti = max_speed;
+        if (v != activesettings.stick_max_speed)
+        {
+            activesettings.stick_max_speed = v;
+            settings_changed = 1;
+        }
     }
 
     /*
@@ -510,7 +620,7 @@ int16_t stickCycle(double pos, double brakedistance)
      * Note that this is not exact science. The cablecam might roll downhill and the user does hold against constantly.
      * In this case, this guess would be wrong.
      */
-    if (activesettings.esc_direction == 0)
+    if (plan->esc_direction == 0)
     {
         if (pos > 500 || pos < -500)
         {
@@ -534,16 +644,23 @@ int16_t stickCycle(double pos, double brakedistance)
             {
                 activesettings.esc_direction = -1;
             }
+            settings_changed = 1;
         }
     }
 
+    if (settings_changed)
+    {
+        requestControlPlan();
+    }
+
     return value;
 }
 
 void resetThrottle()
 {
-    esum = 0.0f;
+    iterm = 0.0f;
     ealt = 0.0f;
+    pidgains_valid = 0;
     yalt = 0.0f;
 }
 
@@ -551,17 +668,153 @@ void resetPosTarget()
 {
     pos_target = (double) ENCODER_VALUE;
     pos_target_old = pos_target;
+    target_step = 0.0f;
+}
+
+/** \brief The acceleration the end point brake can use from the current position on
+ *
+ * The brake ramps the stick down with the max accel, lowered by the traction control while the wheel slips and by
+ * the speed zones it passes until the end point it moves towards. The brake distance has to be calculated with the
+ * same value, else it starts braking too late.
+ *
+ * \param plan const controlplan_t*
+ * \param pos double Current position
+ * \param speed int32_t Hall sensor steps per cycle
+ * \return int16_t the acceleration limit in the units of the stick values, at least 1
+ *
+ */
+int16_t getBrakeAccel(const controlplan_t * plan, double pos, int32_t speed)
+{
+    int16_t maxaccel = limitTractionAccel(plan->limits[controllerstatus.safemode != OPERATIONAL].max_accel);
+    if (controllerstatus.safemode == OPERATIONAL)
+    {
+        maxaccel = getZoneBrakeAccel(plan->zones, plan->zone_count, pos, (speed >= 0) ? plan->pos_end : plan->pos_start, maxaccel);
+    }
+    return (maxaccel < 1) ? 1 : maxaccel;
+}
+
+/** \brief The change of the target position to follow the setpoint stream with, called every cycle the stream drives
+ *
+ * The stream gets the same limits as the stick: the max speed and max accel, the latter reduced by the traction
+ * control, and in OPERATIONAL mode the speed zones and the end points. The setpoint is kept within the end points
+ * and the target slows down early enough to stop at them, so even a stream running past an end point brakes
+ * the same way the stick does. A jump of the setpoint is approached with the max accel, decelerating in time to stop there.
+ *
+ * \param plan const controlplan_t*
+ * \param setpoint double the position the stream asks for
+ * \param speed int32_t Hall sensor steps per cycle
+ * \return double the change of the target position
+ *
+ */
+double streamStep(const controlplan_t * plan, double setpoint, int32_t speed)
+{
+    const rampfilter_limits_t * limits = &plan->limits[controllerstatus.safemode != OPERATIONAL];
+    int16_t maxaccel = limitTractionAccel(limits->max_accel);
+    int16_t maxspeed = limits->max_speed;
+    double stream_speed = stream_setpoint_valid ? setpoint - stream_setpoint_old : 0.0f;
+
+    stream_setpoint_old = setpoint;
+    stream_setpoint_valid = 1;
+    if (controllerstatus.safemode == OPERATIONAL)
+    {
+        double stick = target_step / plan->stick_speed_factor;
+        if (stick > INT16_MAX)
+        {
+            stick = INT16_MAX;
+        }
+        else if (stick < -INT16_MAX)
+        {
+            stick = -INT16_MAX;
+        }
+        limitSpeedZones(plan->zones, plan->zone_count, pos_target, speed, (int16_t) stick, &maxspeed, &maxaccel);
+        if (setpoint > plan->pos_end)
+        {
+            setpoint = plan->pos_end;
+            stream_speed = 0.0f;
+        }
+        else if (setpoint < plan->pos_start)
+        {
+            setpoint = plan->pos_start;
+            stream_speed = 0.0f;
+        }
+    }
+    double accel = ((double) maxaccel) * plan->stick_speed_factor;
+    double max_step = ((double) maxspeed) * plan->stick_speed_factor;
+
+    /* the target follows the movement of the stream and closes the gap to it no faster than it can stop */
+    double e = setpoint - pos_target;
+    double approach = sqrt(2.0f * accel * abs_d(e));
+    double step = stream_speed + ((e > approach) ? approach : ((e < -approach) ? -approach : e));
+    if (step > max_step)
+    {
+        step = max_step;
+    }
+    else if (step < -max_step)
+    {
+        step = -max_step;
+    }
+
+    /*
+     * The braking distance to the end points, step^2/(2*accel), has to remain within them, with the lowest accel
+     * of the speed zones on the way
+     */
+    if (controllerstatus.safemode == OPERATIONAL)
+    {
+        double accel_end = ((double) getZoneBrakeAccel(plan->zones, plan->zone_count, pos_target, plan->pos_end, maxaccel)) * plan->stick_speed_factor;
+        double accel_start = ((double) getZoneBrakeAccel(plan->zones, plan->zone_count, pos_target, plan->pos_start, maxaccel)) * plan->stick_speed_factor;
+        double brake_end = (pos_target < plan->pos_end) ? sqrt(2.0f * accel_end * (plan->pos_end - pos_target)) : 0.0f;
+        double brake_start = (pos_target > plan->pos_start) ? sqrt(2.0f * accel_start * (pos_target - plan->pos_start)) : 0.0f;
+        if (step > brake_end)
+        {
+            step = brake_end;
+        }
+        else if (step < -brake_start)
+        {
+            step = -brake_start;
+        }
+    }
+
+    if (step > target_step + accel)
+    {
+        step = target_step + accel;
+    }
+    else if (step < target_step - accel)
+    {
+        step = target_step - accel;
+    }
+    return step;
+}
+
+/** \brief Continue from the current encoder value after it got set to a different position
+ *
+ * Without, the jump of the encoder value would be seen as speed by the next cycle.
+ *
+ * \return void
+ *
+ */
+void resetPosition()
+{
+    pos_current_old = ENCODER_VALUE;
+    resyncTraction();
+    resyncIMU();
+    resetPosTarget();
 }
 
 // ******** Main Loop *********
 void controllercycle()
 {
+    /*
+     * The plan is fetched once per cycle, so all calculations of this cycle are based on the same settings.
+     */
+    const controlplan_t * plan = getControlPlan();
+
     controllerstatus.monitor = FREE; // might be overwritten by stickCycle() so has to come first
     /*
      * speed = change in position per cycle. Speed is always positive.
      * speed = abs(pos_old - pos)
      *
-     * time_to_stop = number of cycles it takes to get the current stick value down to neutral with the given activesettings.stick_max_accel
+     * time_to_stop = number of cycles it takes to get the current stick value down to neutral with the max_accel the brake can use,
+     * the lowest one of the speed zones until the end point, see getBrakeAccel()
      * time_to_stop = abs(getStick()/max_accel)
      *
      *
@@ -586,24 +839,47 @@ void controllercycle()
      *      time_to_stop
      */
     int32_t pos_current = ENCODER_VALUE;
+    tractionCycle(pos_current, TIM3->CCR3);
     double speed_current = abs_d((double) (pos_current_old - pos_current));
     double pos = (double) pos_current;
 
-    double time_to_stop = abs_d((double) (getStick()/activesettings.stick_max_accel));
+    double pos_brake = (plan->mode == MODE_ABSOLUTE_POSITION) ? pos_target_old : pos;
+    double time_to_stop = abs_d(((double) getStick()) / getBrakeAccel(plan, pos_brake, pos_current - pos_current_old));
 
-    double distance_to_stop = speed_current * time_to_stop / 2.0f;
+    /*
+     * The input shaper delays the stick signal by plan->shaper.lag cycles on average, the cablecam travels that much further.
+     * In absolute position mode the brake acts on the target, so the speed is the one the stick value gives the target,
+     * also in a cycle an emergency brake held the target.
+     */
+    speed_brake_filtered = BRAKE_SPEED_FILTER * speed_brake_filtered + (1.0f - BRAKE_SPEED_FILTER) * speed_current;
+    double speed_brake = (plan->mode == MODE_ABSOLUTE_POSITION) ? abs_d(((double) getStick()) * plan->stick_speed_factor) : speed_brake_filtered;
+    double distance_to_stop = speed_brake * (time_to_stop / 2.0f + plan->shaper.lag);
     int16_t stick_filtered_value;
 
-    if (activesettings.mode == MODE_ABSOLUTE_POSITION)
+    // in case of mode-absolute the actual position does not matter, it is the target position that counts
+    stick_filtered_value = stickCycle(plan, pos_brake, distance_to_stop); // go through the stick position calculation with its limiters, max accel etc
+
+    /*
+     * The input shaper spreads every change of the stick over one swing period, so the camera does not start to swing.
+     * In passthrough mode there are no filters at all, and when the stick had to be forced into neutral to
+     * stop the cablecam, that has to happen right away, without the delay of the shaper.
+     */
+    if (plan->mode == MODE_PASSTHROUGH || (controllerstatus.monitor != FREE && stick_filtered_value == 0))
     {
-        // in case of mode-absolute the actual position does not matter, it is the target position that counts
-        stick_filtered_value = stickCycle(pos_target_old, distance_to_stop); // go through the stick position calculation with its limiters, max accel etc
+        resetShaper(stick_filtered_value);
     }
     else
     {
-        stick_filtered_value = stickCycle(pos, distance_to_stop); // go through the stick position calculation with its limiters, max accel etc
+        stick_filtered_value = shapeStick(&plan->shaper, stick_filtered_value);
     }
 
+    /*
+     * The swing of the camera shows in the acceleration along the rope the IMU measures, without an IMU at least in
+     * the speed of the wheel.
+     */
+    const imustate_t * imu = getIMUState();
+    recordSwing(imu->present ? imu->accel_rope : (float) (pos_current - pos_current_old));
+
     /*
      * The stick position and the speed_new variables both define essentially the ESC target. So if the
      * stick is currently set to 100% forward, that means 100% thrust or 100% speed. The main difference is
@@ -612,12 +888,12 @@ void controllercycle()
      */
     int16_t esc_output = stick_filtered_value;
 
-    if (activesettings.mode != MODE_PASSTHROUGH && activesettings.mode != MODE_LIMITER)
+    if (plan->mode != MODE_PASSTHROUGH && plan->mode != MODE_LIMITER)
     {
         /*
          * In passthrough mode or limiter mode, the cablecam can move freely, no end points are considered. In all other modes...
          */
-        if (activesettings.mode == MODE_ABSOLUTE_POSITION)
+        if (plan->mode == MODE_ABSOLUTE_POSITION)
         {
             /*
              * In absolute mode everything revolves around the target pos. The speed is the change in target pos etc.
@@ -629,22 +905,34 @@ void controllercycle()
 
             /*
              * The new target is the old target increased by the stick signal.
+             * While the stick is neutral, an external setpoint stream can move the target instead, within the same limits.
              */
-            pos_target += ((double)stick_filtered_value) * activesettings.stick_speed_factor;
+            double setpoint;
+            double step = ((double)stick_filtered_value) * plan->stick_speed_factor;
+            if (stick_filtered_value == 0 && isSetpointStreamActive() && getStreamSetpoint(HAL_GetTick(), &setpoint) >= 0)
+            {
+                step = streamStep(plan, setpoint, pos_current - pos_current_old);
+            }
+            else
+            {
+                stream_setpoint_valid = 0;
+            }
+            pos_target += step;
 
             // In OPERATIONAL mode the position including the break distance has to be within the end points, in programming mode you can go past that
             if (controllerstatus.safemode == OPERATIONAL)
             {
                 // Of course the target can never exceed the end points, unless in programming mode
-                if (pos_target > activesettings.pos_end)
+                if (pos_target > plan->pos_end)
                 {
-                    pos_target = activesettings.pos_end;
+                    pos_target = plan->pos_end;
                 }
-                else if (pos_target < activesettings.pos_start)
+                else if (pos_target < plan->pos_start)
                 {
-                    pos_target = activesettings.pos_start;
+                    pos_target = plan->pos_start;
                 }
             }
+            target_step = pos_target - pos_target_old;
             pos_target_old = pos_target;
 
 
@@ -652,12 +940,47 @@ void controllercycle()
              * The PID loop calculates the error between target pos and actual pos and does change the throttle/speed signal in order to keep the error as small as possible.
              */
             double y = 0.0f;
+            double feedforward = 0.0f;
+            if (step > 0.0)
+            {
+                feedforward_direction = FEEDFORWARD_FORWARD;
+            }
+            else if (step < 0.0)
+            {
+                feedforward_direction = FEEDFORWARD_REVERSE;
+            }
 
 
+            /*
+             * The gains depend on the speed and direction of the target position, a slow creep needs different gains than a full speed run.
+             */
+            pidgains_t scheduled;
+            getScheduledGains(&plan->gains, feedforward_direction, (float) (step / Ta), &scheduled);
+            if (pidgains_valid)
+            {
+                blendGains(&pidgains, &scheduled);
+            }
+            else
+            {
+                pidgains = scheduled;
+                pidgains_valid = 1;
+            }
+
             double e = pos_target - pos;     // This is the amount of steps the target pos does not match the reality
-            esum += e;
+            iterm += pidgains.ki_ta * e;
+            /*
+             * The output saturates at an int16, an I term beyond that only winds up and overshoots for as long as it takes to unwind
+             */
+            if (iterm > INT16_MAX)
+            {
+                iterm = INT16_MAX;
+            }
+            else if (iterm < -INT16_MAX)
+            {
+                iterm = -INT16_MAX;
+            }
 
-            if (e >= activesettings.max_position_error || e <= -activesettings.max_position_error)
+            if (e >= plan->max_position_error || e <= -plan->max_position_error)
             {
                 // The cablecam cannot catchup with the target position --> EMERGENCY BRAKE
                 resetThrottle();
@@ -667,16 +990,44 @@ void controllercycle()
             }
             else
             {
-                // y = Kp*e + Ki*Ta*esum + Kd/Ta*(e  ealt);
-                y = (activesettings.P * e) + (activesettings.I * Ta * esum) + (activesettings.D / Ta) * (e - ealt);         // PID loop calculation
+                // y = Kp*e + sum(Ki*Ta*e) + Kd/Ta*(e - ealt);
+                double pd = (pidgains.kp * e) + pidgains.kd_ta * (e - ealt);
+                y = pd + iterm;         // PID loop calculation, Ta is part of the gains already
+
+                /*
+                 * The thrust learned for this position is added, so the PID loop has to correct the difference only.
+                 * Whatever the P and D part still adds is learned for the next time, in OPERATIONAL mode only, as the end points are final then.
+                 * The I term is not learned, else map and iterm would both integrate the same error and wind up against each other.
+                 */
+                if (plan->feedforward_active)
+                {
+                    feedforward = getFeedForward(plan->pos_start, plan->pos_end, pos_target, feedforward_direction);
+                    if (controllerstatus.safemode == OPERATIONAL)
+                    {
+                        learnFeedForward(plan->pos_start, plan->pos_end, pos_target, feedforward_direction, pd);
+                    }
+                }
 
-                if (activesettings.esc_direction == 1)
+                /*
+                 * With high gains a large error gives more than an int16 can hold, it must saturate and not wrap
+                 * around to full thrust in the opposite direction.
+                 */
+                double u = y + feedforward;
+                if (u > INT16_MAX)
+                {
+                    u = INT16_MAX;
+                }
+                else if (u < -INT16_MAX)
                 {
-                    esc_output = (int16_t) y;
+                    u = -INT16_MAX;
+                }
+                if (plan->esc_direction == 1)
+                {
+                    esc_output = (int16_t) u;
                 }
                 else
                 {
-                    esc_output = (int16_t) -y;
+                    esc_output = (int16_t) -u;
                 }
 
                 ealt = e;
@@ -696,19 +1047,64 @@ void controllercycle()
         }
     }
 
-    if (esc_output > 0)
+    if (isESCCalibrationActive())
+    {
+        /*
+         * While the ESC table is calibrated, the calibration drives the ESC. Moving the stick, cancelling the job or
+         * getting close to the end points in OPERATIONAL mode stops it.
+         */
+        setServoOutput(SERVO_ESC, escCalibrationCycle(pos_current, pos_current - pos_current_old, getStickPositionRaw(plan) != 0 || !getJob()->active));
+    }
+    else if (isAutoTuneActive())
     {
-        TIM3->CCR3 = activesettings.esc_neutral_pos + activesettings.esc_neutral_range + (esc_output/activesettings.esc_scale);
+        /*
+         * The relay experiment of the PID auto-tune drives the ESC, it stops on its own when the cablecam gets too far away.
+         * The PID loop starts fresh afterwards.
+         */
+        int16_t relay = autoTuneCycle(pos_current, pos_current - pos_current_old, getStickPositionRaw(plan) != 0 || !getJob()->active ||
+                                      getDuty(activesettings.rc_channel_speed) == 0);
+        resetThrottle();
+        resetPosTarget();
+        setServoOutput(SERVO_ESC, getESCPulse(plan, (plan->esc_direction == 1) ? relay : -relay));
     }
-    else if (esc_output < 0)
+    else
     {
-        TIM3->CCR3 = activesettings.esc_neutral_pos - activesettings.esc_neutral_range + (esc_output/activesettings.esc_scale);
+        setServoOutput(SERVO_ESC, getESCPulse(plan, esc_output));
+    }
+
+    /*
+     * The yaw servo on Servo2 keeps the camera aimed at the target, unless the output is used for position triggers.
+     * Moving the yaw stick out of neutral turns the servo manually.
+     */
+    if (plan->tracking.active && getPosTriggerCount() == 0)
+    {
+        int16_t yaw = getYawStick();
+        int16_t override = 0;
+        if (yaw != 0)
+        {
+            yaw -= plan->stick_neutral_pos;
+            if (yaw > plan->stick_neutral_range)
+            {
+                override = yaw - plan->stick_neutral_range;
+            }
+            else if (yaw < -plan->stick_neutral_range)
+            {
+                override = yaw + plan->stick_neutral_range;
+            }
+        }
+        setServoOutput(SERVO_YAW, trackingCycle(&plan->tracking, pos_current, override));
     }
     else
     {
-        TIM3->CCR3 = activesettings.esc_neutral_pos;
+        resetTracking(TIM3->CCR4);
     }
 
+    /*
+     * All outputs change within the same PWM period, with getDuty() returning 0 the RC signal is lost.
+     */
+    commitServoOutputs(plan->servo_outputs, getDuty(activesettings.rc_channel_speed) == 0);
+    traceLatencyOutput(getServoUpdateDelay());
+
     /*
      * Log the last CYCLEMONITOR_SAMPLE_COUNT events in memory.
      * If neither the cablecam moves nor should move (esc_output == 0), then there is nothing interesting to log
@@ -717,11 +1113,13 @@ void controllercycle()
     {
         cyclemonitor_t * sample = &controllerstatus.cyclemonitor[controllerstatus.cyclemonitor_position];
         sample->distance_to_stop = distance_to_stop;
-        sample->esc = TIM3->CCR3;
+        sample->esc = getServoOutput(SERVO_ESC);
         sample->pos = pos;
         sample->speed = speed_current;
         sample->stick = getStick();
-        sample->tick = HAL_GetTick();
+        sample->tick = MICROS();
+        sample->rc_age = (uint16_t) ((sbusdata.timeout || TIME_ELAPSED(sample->tick, sbusdata.sbusLastValidFrame) > 0xFFFF * 1000UL) ?
+                                     0xFFFF : TIME_ELAPSED(sample->tick, sbusdata.sbusLastValidFrame) / 1000);
         controllerstatus.cyclemonitor_position++;
         if (controllerstatus.cyclemonitor_position > CYCLEMONITOR_SAMPLE_COUNT)
         {
@@ -730,6 +1128,8 @@ void controllercycle()
     }
 
 
+    checkpointPos(pos_current, pos_current - pos_current_old);
+
     pos_current_old = pos_current; // required for the actual speed calculation
 
     if (is1Hz())
@@ -804,19 +1204,15 @@ void printControlLoop(int16_t input, double speed, double pos, double brakedista
 
 void printPIDMonitor(double e, double y, Endpoints endpoint)
 {
-    // y = (activesettings.P * e) + (activesettings.I * Ta * esum) + (activesettings.D / Ta) * (e - ealt);
+    // y = (pidgains.kp * e) + iterm + pidgains.kd_ta * (e - ealt);
     PrintSerial_string("y = ", endpoint);
-    PrintSerial_double(activesettings.P, endpoint);
+    PrintSerial_double(pidgains.kp, endpoint);
     PrintSerial_string("* ", endpoint);
     PrintSerial_double(e, endpoint);
     PrintSerial_string("+   ", endpoint);
-    PrintSerial_double(activesettings.I, endpoint);
-    PrintSerial_string("* ", endpoint);
-    PrintSerial_double(Ta, endpoint);
-    PrintSerial_string("* ", endpoint);
-    PrintSerial_double(esum, endpoint);
+    PrintSerial_double(iterm, endpoint);
     PrintSerial_string("+   ", endpoint);
-    PrintSerial_double(activesettings.D, endpoint);
+    PrintSerial_double(pidgains.kd_ta * Ta, endpoint);
     PrintSerial_string("* ", endpoint);
     PrintSerial_double(e-ealt, endpoint);
     PrintSerial_string("/ ", endpoint);
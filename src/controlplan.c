@@ -0,0 +1,230 @@
+#include "controlplan.h"
+#include "protocol.h"
+#include "controller.h"
+#include "scheduler.h"
+#include "string.h"
+
+/*
+ * Two plans, one is used by the controller, the other is the one being compiled.
+ * activeplan is a single byte, hence switching between both is atomic.
+ */
+static controlplan_t plans[2];
+static volatile uint8_t activeplan = 0;
+static volatile uint8_t plan_requested = 0;
+
+/** \brief Derive the control plan from the activesettings and make it the active one
+ *
+ * Called at boot and by updateControlPlan(). Whenever a value of the activesettings changed, e.g. by a protocol
+ * command or by setting the endpoints via the RC, requestControlPlan() has to be called.
+ *
+ * \return void
+ *
+ */
+void compileControlPlan()
+{
+    controlplan_t * plan = &plans[activeplan ^ 1];
+    uint8_t i;
+
+    plan->mode = activesettings.mode;
+    plan->esc_direction = activesettings.esc_direction;
+
+    plan->stick_neutral_pos = activesettings.stick_neutral_pos;
+    plan->stick_neutral_range = activesettings.stick_neutral_range;
+    plan->poti_threshold = activesettings.stick_neutral_pos + activesettings.stick_neutral_range;
+
+    plan->limits[0].max_accel = activesettings.stick_max_accel;
+    plan->limits[0].max_speed = activesettings.stick_max_speed * 10;
+    plan->limits[1].max_accel = activesettings.stick_max_accel_safemode;
+    plan->limits[1].max_speed = activesettings.stick_max_speed_safemode * 10;
+
+    plan->stick_curve_range = activesettings.stick_curve_range;
+    plan->stick_curve_scale = ((float) STICKCURVE_LUT_SIZE) / activesettings.stick_curve_range;
+    compileStickCurve(plan->stick_curve[0], &activesettings.stick_curve[0], activesettings.stick_curve_range);
+    compileStickCurve(plan->stick_curve[1], &activesettings.stick_curve[1], activesettings.stick_curve_range);
+
+    plan->zone_count = activesettings.zone_count;
+    for (i = 0; i < activesettings.zone_count; i++)
+    {
+        plan->zones[i].pos = activesettings.zones[i].pos;
+        plan->zones[i].max_speed = activesettings.zones[i].max_speed * 10;
+        plan->zones[i].max_accel = activesettings.zones[i].max_accel;
+    }
+
+    /*
+     * The pos_start has to be smaller than pos_end always. This is checked in the end_point set logic.
+     * However there is a cases where this might not be so:
+     * Start and end point had been set but then only the start point is moved.
+     */
+    if (activesettings.pos_start > activesettings.pos_end)
+    {
+        plan->pos_start = activesettings.pos_end;
+        plan->pos_end = activesettings.pos_start;
+    }
+    else
+    {
+        plan->pos_start = activesettings.pos_start;
+        plan->pos_end = activesettings.pos_end;
+    }
+    plan->max_position_error = activesettings.max_position_error;
+    plan->stick_speed_factor = activesettings.stick_speed_factor;
+
+    compileGainSchedule(&plan->gains, activesettings.P, activesettings.I, activesettings.D);
+    plan->feedforward_active = (activesettings.feedforward_active == 1);
+
+    plan->esc_neutral_pos = activesettings.esc_neutral_pos;
+    plan->esc_pos_offset = activesettings.esc_neutral_pos + activesettings.esc_neutral_range;
+    plan->esc_neg_offset = activesettings.esc_neutral_pos - activesettings.esc_neutral_range;
+    plan->esc_scale = activesettings.esc_scale;
+    if (activesettings.esc_scale > 1)
+    {
+        /*
+         * value/esc_scale == (value * ceil(2^32/esc_scale)) >> 32 for every 16 bit value,
+         * and a 32x32->64 bit multiplication is a single instruction.
+         */
+        plan->esc_scale_reciprocal = (uint32_t) ((0x100000000ULL + activesettings.esc_scale - 1) / activesettings.esc_scale);
+    }
+    else
+    {
+        plan->esc_scale_reciprocal = 0;
+    }
+
+    plan->esc_table_active = (activesettings.esc_table_active == 1 && activesettings.esc_table_range > 0);
+    plan->esc_table_range = activesettings.esc_table_range;
+    if (plan->esc_table_active)
+    {
+        plan->esc_table_scale = ((float) (ESC_TABLE_POINTS - 1)) / activesettings.esc_table_range;
+        memcpy(plan->esc_table, activesettings.esc_table, sizeof(plan->esc_table));
+    }
+
+    compileShaper(&plan->shaper, activesettings.shaper_type, activesettings.shaper_frequency, activesettings.shaper_damping);
+    memcpy(plan->servo_outputs, activesettings.servo_outputs, sizeof(plan->servo_outputs));
+    compileTracking(&plan->tracking, activesettings.tracking_active, activesettings.tracking_target, activesettings.tracking_distance,
+                    activesettings.hall_steps_per_meter, activesettings.tracking_us_per_degree, activesettings.tracking_max_rate);
+
+    activeplan ^= 1;
+}
+
+/** \brief Note that the activesettings changed, the plan is compiled by the command task with updateControlPlan()
+ *
+ * Compiling takes a while, hence it is never done within controllercycle(). As the tasks run to completion and the control
+ * task has the highest priority, a compile in the command task can never overlap a control cycle, the cycle always works
+ * with one complete plan. Several changes until the command task runs result in a single compile.
+ *
+ * \return void
+ *
+ */
+void requestControlPlan()
+{
+    plan_requested = 1;
+    signalTask(TASK_COMMAND);
+}
+
+/** \brief Compile the plan if a settings change requested it
+ *
+ * \return void
+ *
+ */
+void updateControlPlan()
+{
+    if (plan_requested)
+    {
+        plan_requested = 0;
+        compileControlPlan();
+    }
+}
+
+const controlplan_t * getControlPlan()
+{
+    return &plans[activeplan];
+}
+
+/** \brief Same as value/esc_scale, rounding towards zero, but without the division
+ *
+ * \param plan const controlplan_t* The plan to take the scale from
+ * \param value int16_t The ESC value in 0.1us units
+ * \return int16_t value/esc_scale
+ *
+ */
+int16_t scaleESCOutput(const controlplan_t * plan, int16_t value)
+{
+    if (plan->esc_scale_reciprocal == 0)
+    {
+        return value;
+    }
+    else if (value < 0)
+    {
+        return -(int16_t) ((((uint64_t) -value) * plan->esc_scale_reciprocal) >> 32);
+    }
+    else
+    {
+        return (int16_t) ((((uint64_t) value) * plan->esc_scale_reciprocal) >> 32);
+    }
+}
+
+/** \brief A pulse width below 0 would wrap around to a huge one, which the servo limits turn into full thrust forward
+ *
+ * \param pulse int32_t
+ * \return uint16_t the pulse, 1 if below so the servo limits turn it into their minimum, 0 would switch the output off
+ *
+ */
+static uint16_t clampPulse(int32_t pulse)
+{
+    return (pulse < 1) ? 1 : (uint16_t) pulse;
+}
+
+/** \brief The pulse width for the ESC output value
+ *
+ * Without the ESC table the pulse width is linear to the value, starting at the end of the esc_neutral_range.
+ * With the table, the value is interpolated between the table points of its direction, so the speed of the
+ * cablecam is linear to the value. Values beyond the table range continue with the slope of a servo signal.
+ *
+ * \param plan const controlplan_t*
+ * \param value int16_t The ESC value in 0.1us units
+ * \return uint16_t pulse width in us
+ *
+ */
+uint16_t getESCPulse(const controlplan_t * plan, int16_t value)
+{
+    if (value == 0)
+    {
+        return plan->esc_neutral_pos;
+    }
+    else if (!plan->esc_table_active)
+    {
+        if (value > 0)
+        {
+            return clampPulse((int32_t) plan->esc_pos_offset + scaleESCOutput(plan, value));
+        }
+        else
+        {
+            return clampPulse((int32_t) plan->esc_neg_offset + scaleESCOutput(plan, value));
+        }
+    }
+
+    int16_t u = scaleESCOutput(plan, value);
+    const int16_t * table = plan->esc_table[(value > 0) ? ESC_TABLE_FORWARD : ESC_TABLE_REVERSE];
+    int16_t offset;
+    if (u < 0)
+    {
+        u = -u;
+    }
+    if (u >= plan->esc_table_range)
+    {
+        offset = table[ESC_TABLE_POINTS - 1] + u - plan->esc_table_range;
+    }
+    else
+    {
+        float x = u * plan->esc_table_scale;
+        uint8_t i = (uint8_t) x;
+        offset = table[i] + (int16_t) ((x - i) * (table[i + 1] - table[i]) + 0.5f);
+    }
+
+    if (value > 0)
+    {
+        return plan->esc_neutral_pos + offset;
+    }
+    else
+    {
+        return clampPulse((int32_t) plan->esc_neutral_pos - offset);
+    }
+}
@@ -54,6 +54,120 @@ uint32_t eeprom_write_sector_safe(uint8_t *write, uint16_t size, uint16_t sector
     return sFLASH_VerifyWrite(write, sectoraddress, size);
 }
 
+/*
+ * State of the incremental write started by eeprom_write_sector_start()
+ */
+typedef enum {
+    EEPROM_PHASE_IDLE = 0,
+    EEPROM_PHASE_ERASE,
+    EEPROM_PHASE_WRITE,
+    EEPROM_PHASE_VERIFY
+} EEPROM_PHASE_t;
+
+static EEPROM_PHASE_t write_phase = EEPROM_PHASE_IDLE;
+static uint8_t *write_buffer;
+static uint16_t write_size;
+static uint16_t write_offset;
+static uint32_t write_address;
+static uint32_t write_errors;
+
+/**
+ * @brief  starts the same erase-write-verify sequence as eeprom_write_sector_safe() but without waiting for
+ * the flash. The sequence is executed by calling eeprom_write_sector_step() until it does not return EEPROM_WRITE_BUSY.
+ * The buffer must not be changed until then.
+ * @param  write: buffer address
+ * @param  size: amount of bytes to be written (less than the sector size which is 65k)
+ * @param  sector: the sector number
+ * @retval 0 if started, 2 if the flash is not initialized
+ */
+uint32_t eeprom_write_sector_start(uint8_t *write, uint16_t size, uint16_t sector)
+{
+    if (FlashID < 10)
+    {
+        // Not initialized or wrong SPI ID
+        return 2;
+    }
+    write_buffer = write;
+    write_size = size;
+    write_offset = 0;
+    write_address = ((uint32_t) sector) * 0x00010000;
+    write_errors = 0;
+    sFLASH_StartEraseSector(write_address);
+    write_phase = EEPROM_PHASE_ERASE;
+    return 0;
+}
+
+/**
+ * @brief  executes the next piece of the write started by eeprom_write_sector_start(). One call programs or
+ * verifies a single flash page at most and returns right away while the flash is busy.
+ * @retval EEPROM_WRITE_BUSY while not finished, EEPROM_WRITE_DONE when written and verified, EEPROM_WRITE_FAILED otherwise
+ */
+int8_t eeprom_write_sector_step()
+{
+    uint16_t len;
+
+    if (write_phase == EEPROM_PHASE_IDLE)
+    {
+        return EEPROM_WRITE_FAILED;
+    }
+    if (sFLASH_IsWriteInProgress())
+    {
+        return EEPROM_WRITE_BUSY;
+    }
+
+    len = write_size - write_offset;
+    if (len > sFLASH_SPI_PAGESIZE)
+    {
+        len = sFLASH_SPI_PAGESIZE;
+    }
+
+    switch (write_phase)
+    {
+    case EEPROM_PHASE_ERASE:
+        /* erase is done */
+        write_phase = EEPROM_PHASE_WRITE;
+        return EEPROM_WRITE_BUSY;
+    case EEPROM_PHASE_WRITE:
+        if (len != 0)
+        {
+            /* The sector start is page aligned, hence every chunk is one page */
+            sFLASH_StartWritePage(&write_buffer[write_offset], write_address + write_offset, len);
+            write_offset += len;
+        }
+        else
+        {
+            write_offset = 0;
+            write_phase = EEPROM_PHASE_VERIFY;
+        }
+        return EEPROM_WRITE_BUSY;
+    default:
+        if (len != 0)
+        {
+            write_errors += sFLASH_VerifyWrite(&write_buffer[write_offset], write_address + write_offset, len);
+            write_offset += len;
+            return EEPROM_WRITE_BUSY;
+        }
+        write_phase = EEPROM_PHASE_IDLE;
+        return (write_errors == 0) ? EEPROM_WRITE_DONE : EEPROM_WRITE_FAILED;
+    }
+}
+
+/**
+ * @brief  the progress of the write started by eeprom_write_sector_start()
+ * @retval 0..100 percent, erasing is counted as the first third, writing and verifying as the other two
+ */
+uint8_t eeprom_write_sector_progress()
+{
+    uint32_t done = (write_size == 0) ? 100 : ((uint32_t) write_offset) * 100 / write_size;
+    switch (write_phase)
+    {
+    case EEPROM_PHASE_ERASE: return 0;
+    case EEPROM_PHASE_WRITE: return (uint8_t) (33 + done / 3);
+    case EEPROM_PHASE_VERIFY: return (uint8_t) (66 + done / 3);
+    default: return 100;
+    }
+}
+
 static uint32_t last_address = 0;
 
 void eeprom_append_unverified(uint8_t *write, uint32_t size, uint16_t start_sector)
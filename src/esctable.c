@@ -0,0 +1,226 @@
+#include "esctable.h"
+#include "protocol.h"
+#include "job.h"
+
+/*
+ * The calibration drives the ESC with ESC_CAL_STEPS increasing pulse widths per direction and measures the
+ * speed at each. The pulse widths are offsets from the esc_neutral_pos in us.
+ */
+typedef enum {
+    ESC_CAL_IDLE = 0,
+    ESC_CAL_RUNNING,
+    ESC_CAL_MEASURED,
+    ESC_CAL_ABORTED
+} ESC_CAL_PHASE_t;
+
+static ESC_CAL_PHASE_t phase = ESC_CAL_IDLE;
+static int16_t cal_range;
+static uint8_t cal_direction;
+static uint8_t cal_step;
+static uint16_t cal_cycle;
+static int32_t cal_pos_begin;
+static int32_t cal_pos_min;
+static int32_t cal_pos_max;
+static double cal_brake;                // Hall sensor steps per cycle^2 the cablecam is assumed to brake with
+
+/*
+ * Hall sensor steps per cycle for the pulse width step * range / ESC_CAL_STEPS, index 0 is neutral
+ */
+static float cal_speed[2][ESC_CAL_STEPS + 1];
+
+/** \brief Start driving the ESC through its range, the controller calls escCalibrationCycle() from now on
+ *
+ * \param range int16_t us, the largest pulse width offset from neutral, the cablecam runs at full speed with it
+ * \param min_pos int32_t the calibration is aborted before the cablecam could not stop above it anymore
+ * \param max_pos int32_t the calibration is aborted before the cablecam could not stop below it anymore
+ * \param brake double deceleration in Hall sensor steps per cycle^2 the braking distance is calculated with
+ * \return void
+ *
+ */
+void startESCCalibration(int16_t range, int32_t min_pos, int32_t max_pos, double brake)
+{
+    cal_range = range;
+    cal_pos_min = min_pos;
+    cal_pos_max = max_pos;
+    cal_brake = (brake > 0.0f) ? brake : 1.0f;
+    cal_direction = ESC_TABLE_FORWARD;
+    cal_step = 1;
+    cal_cycle = 0;
+    cal_speed[ESC_TABLE_FORWARD][0] = 0.0f;
+    cal_speed[ESC_TABLE_REVERSE][0] = 0.0f;
+    phase = ESC_CAL_RUNNING;
+}
+
+uint8_t isESCCalibrationActive()
+{
+    return phase == ESC_CAL_RUNNING;
+}
+
+/** \brief One controller cycle of the calibration, returns the pulse width to output instead of the controller's
+ *
+ * Each pulse width is held for ESC_CAL_SETTLE_CYCLES until the speed is stable, then the distance travelled within
+ * ESC_CAL_MEASURE_CYCLES is the speed. Between both directions the ESC is neutral for ESC_CAL_PAUSE_CYCLES.
+ * Should the wheel be on the rope nevertheless, the calibration is aborted as soon as the cablecam would stop
+ * past the position limits.
+ *
+ * \param pos int32_t current Hall sensor position
+ * \param speed int32_t Hall sensor steps per cycle
+ * \param abort uint8_t 1 to stop the calibration, e.g. because the stick got moved
+ * \return uint16_t pulse width in us
+ *
+ */
+uint16_t escCalibrationCycle(int32_t pos, int32_t speed, uint8_t abort)
+{
+    double stop = pos + ((double) speed) * ((speed < 0) ? -speed : speed) / (2.0f * cal_brake);
+
+    if (abort || stop < cal_pos_min || stop > cal_pos_max)
+    {
+        phase = ESC_CAL_ABORTED;
+        return activesettings.esc_neutral_pos;
+    }
+
+    cal_cycle++;
+    if (cal_step > ESC_CAL_STEPS)
+    {
+        /* the pause between the directions */
+        if (cal_cycle >= ESC_CAL_PAUSE_CYCLES)
+        {
+            if (cal_direction == ESC_TABLE_REVERSE)
+            {
+                phase = ESC_CAL_MEASURED;
+                return activesettings.esc_neutral_pos;
+            }
+            cal_direction = ESC_TABLE_REVERSE;
+            cal_step = 1;
+            cal_cycle = 0;
+        }
+        else
+        {
+            return activesettings.esc_neutral_pos;
+        }
+    }
+
+    if (cal_cycle == ESC_CAL_SETTLE_CYCLES)
+    {
+        cal_pos_begin = pos;
+    }
+    else if (cal_cycle == ESC_CAL_SETTLE_CYCLES + ESC_CAL_MEASURE_CYCLES)
+    {
+        int32_t distance = pos - cal_pos_begin;
+        cal_speed[cal_direction][cal_step] = ((float) (distance < 0 ? -distance : distance)) / ESC_CAL_MEASURE_CYCLES;
+        cal_step++;
+        cal_cycle = 0;
+        if (cal_step > ESC_CAL_STEPS)
+        {
+            return activesettings.esc_neutral_pos;
+        }
+    }
+
+    int16_t offset = (int16_t) (((int32_t) cal_range) * cal_step / ESC_CAL_STEPS);
+    if (cal_direction == ESC_TABLE_FORWARD)
+    {
+        return activesettings.esc_neutral_pos + offset;
+    }
+    else
+    {
+        return activesettings.esc_neutral_pos - offset;
+    }
+}
+
+/** \brief Invert the measured speeds of one direction into the table
+ *
+ * The table point i is the pulse width offset at which the cablecam runs at i/(ESC_TABLE_POINTS-1) of the
+ * max_speed, point 0 is where the ESC starts to move. Speeds measured lower than at a smaller pulse width,
+ * e.g. because of a bump, are raised to that value, so the table is monotonic.
+ *
+ * \param direction uint8_t ESC_TABLE_FORWARD or ESC_TABLE_REVERSE
+ * \param max_speed float the speed at the end of the table
+ * \return void
+ *
+ */
+static void buildTable(uint8_t direction, float max_speed)
+{
+    float * speed = cal_speed[direction];
+    int16_t * table = activesettings.esc_table[direction];
+    uint8_t k = 0;
+    uint8_t i;
+
+    while (k < ESC_CAL_STEPS && speed[k + 1] == 0.0f)
+    {
+        k++;
+    }
+    table[0] = (int16_t) (((int32_t) cal_range) * k / ESC_CAL_STEPS);
+
+    for (i = 1; i < ESC_TABLE_POINTS; i++)
+    {
+        float target = max_speed * i / (ESC_TABLE_POINTS - 1);
+        while (k < ESC_CAL_STEPS - 1 && speed[k + 1] < target)
+        {
+            k++;
+        }
+        float fraction = (speed[k + 1] > speed[k]) ? (target - speed[k]) / (speed[k + 1] - speed[k]) : 1.0f;
+        if (fraction > 1.0f)
+        {
+            fraction = 1.0f;
+        }
+        table[i] = (int16_t) (((float) cal_range) * (k + fraction) / ESC_CAL_STEPS + 0.5f);
+        if (table[i] < table[i - 1])
+        {
+            table[i] = table[i - 1];
+        }
+    }
+}
+
+/** \brief One step of the calibration job, waits for the measurements and calculates the tables from them
+ *
+ * Both directions get a table for the same max speed, the lower one of the two directions, so the same
+ * ESC value results in the same speed forward and reverse.
+ *
+ * \param progress uint32_t* set to the number of pulse widths measured so far
+ * \return int8_t JOB_RUNNING, JOB_DONE with the tables stored in the activesettings or JOB_FAILED
+ *
+ */
+int8_t stepESCCalibration(uint32_t * progress)
+{
+    uint8_t direction;
+
+    *progress = cal_direction * ESC_CAL_STEPS + cal_step - 1;
+    if (phase == ESC_CAL_RUNNING)
+    {
+        return JOB_RUNNING;
+    }
+    if (phase != ESC_CAL_MEASURED)
+    {
+        phase = ESC_CAL_IDLE;
+        return JOB_FAILED;
+    }
+    phase = ESC_CAL_IDLE;
+
+    for (direction = ESC_TABLE_FORWARD; direction <= ESC_TABLE_REVERSE; direction++)
+    {
+        float * speed = cal_speed[direction];
+        uint8_t k;
+        for (k = 1; k <= ESC_CAL_STEPS; k++)
+        {
+            if (speed[k] < speed[k - 1])
+            {
+                speed[k] = speed[k - 1];
+            }
+        }
+    }
+    float max_speed = cal_speed[ESC_TABLE_FORWARD][ESC_CAL_STEPS];
+    if (cal_speed[ESC_TABLE_REVERSE][ESC_CAL_STEPS] < max_speed)
+    {
+        max_speed = cal_speed[ESC_TABLE_REVERSE][ESC_CAL_STEPS];
+    }
+    if (max_speed <= 0.0f)
+    {
+        return JOB_FAILED;
+    }
+
+    buildTable(ESC_TABLE_FORWARD, max_speed);
+    buildTable(ESC_TABLE_REVERSE, max_speed);
+    activesettings.esc_table_range = cal_range;
+    activesettings.esc_table_active = 1;
+    return JOB_DONE;
+}
@@ -0,0 +1,129 @@
+#include "feedforward.h"
+
+/*
+ * The thrust the cablecam needs at a position to follow the target, per direction. Along a sagging rope
+ * it is positive uphill and negative downhill, in ESC value units before the esc_direction is applied.
+ */
+static float map[2][FEEDFORWARD_BINS];
+
+/*
+ * The end points the map was learned for, when they change the bins are at different positions
+ */
+static double map_start = 0.0;
+static double map_end = 0.0;
+
+void clearFeedForward()
+{
+    uint8_t i;
+    for (i = 0; i < FEEDFORWARD_BINS; i++)
+    {
+        map[FEEDFORWARD_FORWARD][i] = 0.0f;
+        map[FEEDFORWARD_REVERSE][i] = 0.0f;
+    }
+}
+
+/** \brief The position in bins, clearing the map if the end points changed
+ *
+ * \return float 0..FEEDFORWARD_BINS-1 with the bin centers at the integers, negative if the span is too short for the bins
+ *
+ */
+static float getBinPosition(double pos_start, double pos_end, double pos)
+{
+    if (pos_start != map_start || pos_end != map_end)
+    {
+        clearFeedForward();
+        map_start = pos_start;
+        map_end = pos_end;
+    }
+    if (pos_end - pos_start < FEEDFORWARD_BINS)
+    {
+        return -1.0f;
+    }
+    float x = (float) ((pos - pos_start) * FEEDFORWARD_BINS / (pos_end - pos_start)) - 0.5f;
+    if (x < 0.0f)
+    {
+        x = 0.0f;
+    }
+    else if (x > FEEDFORWARD_BINS - 1)
+    {
+        x = FEEDFORWARD_BINS - 1;
+    }
+    return x;
+}
+
+/** \brief The thrust the map has learned for the position, interpolated between the two nearest bins
+ *
+ * \param pos_start double start point, smaller than pos_end
+ * \param pos_end double
+ * \param pos double the target position
+ * \param direction uint8_t FEEDFORWARD_FORWARD or FEEDFORWARD_REVERSE
+ * \return float ESC value in 0.1us units
+ *
+ */
+float getFeedForward(double pos_start, double pos_end, double pos, uint8_t direction)
+{
+    float x = getBinPosition(pos_start, pos_end, pos);
+    if (x < 0.0f)
+    {
+        return 0.0f;
+    }
+    uint8_t i = (uint8_t) x;
+    if (i >= FEEDFORWARD_BINS - 1)
+    {
+        return map[direction][FEEDFORWARD_BINS - 1];
+    }
+    return map[direction][i] + (x - i) * (map[direction][i + 1] - map[direction][i]);
+}
+
+/** \brief Move the part of the thrust the P and D terms had to add into the bin of the position
+ *
+ * The map integrates the P and D output per position, so the next run along the rope gets that thrust as
+ * feed forward and the PID loop only has to correct what is different this time. The I term is left out,
+ * it integrates the same error already and the two integrators would wind up against each other. The change per cycle is
+ * limited, so a single disturbance does not spoil the map. Only positions between the end points are learned.
+ *
+ * \param pos_start double start point, smaller than pos_end
+ * \param pos_end double
+ * \param pos double the target position
+ * \param direction uint8_t FEEDFORWARD_FORWARD or FEEDFORWARD_REVERSE
+ * \param pid double the P and D output of this cycle in ESC value units, without the I term
+ * \return void
+ *
+ */
+void learnFeedForward(double pos_start, double pos_end, double pos, uint8_t direction, double pid)
+{
+    if (pos < pos_start || pos > pos_end)
+    {
+        return;
+    }
+    float x = getBinPosition(pos_start, pos_end, pos);
+    if (x < 0.0f)
+    {
+        return;
+    }
+    uint8_t i = (uint8_t) (x + 0.5f);
+    float step = FEEDFORWARD_LEARN_RATE * (float) pid;
+    if (step > FEEDFORWARD_MAX_STEP)
+    {
+        step = FEEDFORWARD_MAX_STEP;
+    }
+    else if (step < -FEEDFORWARD_MAX_STEP)
+    {
+        step = -FEEDFORWARD_MAX_STEP;
+    }
+    float value = map[direction][i] + step;
+    if (value > FEEDFORWARD_LIMIT)
+    {
+        value = FEEDFORWARD_LIMIT;
+    }
+    else if (value < -FEEDFORWARD_LIMIT)
+    {
+        value = -FEEDFORWARD_LIMIT;
+    }
+    map[direction][i] = value;
+}
+
+const float * getFeedForwardMap(uint8_t direction)
+{
+    return map[direction];
+}
@@ -0,0 +1,157 @@
+#include "gainschedule.h"
+#include "protocol.h"
+#include "controller.h"
+
+/** \brief Add a breakpoint to the schedule of a direction in the activesettings, keeping them sorted by speed
+ *
+ * A breakpoint at the same speed is replaced.
+ *
+ * \param direction uint8_t FEEDFORWARD_FORWARD or FEEDFORWARD_REVERSE
+ * \param speed int32_t Hall sensor steps per second
+ * \param p float
+ * \param i float
+ * \param d float
+ * \return int8_t 0 if ok, -1 if all GAINSCHEDULE_POINTS breakpoints are used already
+ *
+ */
+int8_t addGainPoint(uint8_t direction, int32_t speed, float p, float i, float d)
+{
+    gainpoint_t * points = activesettings.gain_schedule[direction];
+    uint8_t * count = &activesettings.gain_count[direction];
+    uint8_t k = 0;
+
+    while (k < *count && points[k].speed < speed)
+    {
+        k++;
+    }
+    if (k == *count || points[k].speed != speed)
+    {
+        uint8_t j;
+        if (*count >= GAINSCHEDULE_POINTS)
+        {
+            return -1;
+        }
+        for (j = *count; j > k; j--)
+        {
+            points[j] = points[j - 1];
+        }
+        (*count)++;
+    }
+    points[k].speed = speed;
+    points[k].p = p;
+    points[k].i = i;
+    points[k].d = d;
+    return 0;
+}
+
+void clearGainSchedule(uint8_t direction)
+{
+    activesettings.gain_count[direction] = 0;
+}
+
+/** \brief Calculate the lookup tables of both directions from the breakpoints in the activesettings
+ *
+ * The table spans 0 to the speed of the last breakpoint, below the first and above the last breakpoint the gains
+ * of that one apply. A direction without breakpoints uses the fixed gains of $1, $2 and $3 everywhere.
+ *
+ * \param plan gainplan_t*
+ * \param p double the fixed P gain
+ * \param i double the fixed I gain
+ * \param d double the fixed D gain
+ * \return void
+ *
+ */
+void compileGainSchedule(gainplan_t * plan, double p, double i, double d)
+{
+    uint8_t direction;
+    uint8_t n;
+
+    for (direction = 0; direction < 2; direction++)
+    {
+        const gainpoint_t * points = activesettings.gain_schedule[direction];
+        uint8_t count = activesettings.gain_count[direction];
+        int32_t range = (count > 0) ? points[count - 1].speed : 0;
+        uint8_t k = 0;
+
+        plan->scale[direction] = (range > 0) ? ((float) GAINSCHEDULE_LUT_SIZE) / range : 0.0f;
+        for (n = 0; n <= GAINSCHEDULE_LUT_SIZE; n++)
+        {
+            pidgains_t * entry = &plan->lut[direction][n];
+            float pp, ii, dd;
+
+            if (count == 0)
+            {
+                pp = (float) p;
+                ii = (float) i;
+                dd = (float) d;
+            }
+            else
+            {
+                int32_t speed = range * n / GAINSCHEDULE_LUT_SIZE;
+                while (k < count - 1 && points[k + 1].speed <= speed)
+                {
+                    k++;
+                }
+                if (k == count - 1 || speed <= points[k].speed)
+                {
+                    pp = points[k].p;
+                    ii = points[k].i;
+                    dd = points[k].d;
+                }
+                else
+                {
+                    const gainpoint_t * a = &points[k];
+                    const gainpoint_t * b = &points[k + 1];
+                    float f = ((float) (speed - a->speed)) / (b->speed - a->speed);
+                    pp = a->p + f * (b->p - a->p);
+                    ii = a->i + f * (b->i - a->i);
+                    dd = a->d + f * (b->d - a->d);
+                }
+            }
+            entry->kp = pp;
+            entry->ki_ta = ii * (float) Ta;
+            entry->kd_ta = dd / (float) Ta;
+        }
+    }
+}
+
+/** \brief The gains for the current target speed, interpolated within the lookup table
+ *
+ * \param plan const gainplan_t*
+ * \param direction uint8_t FEEDFORWARD_FORWARD or FEEDFORWARD_REVERSE, the direction the target moved in last
+ * \param speed float Hall sensor steps per second of the target position, the sign is ignored
+ * \param gains pidgains_t*
+ * \return void
+ *
+ */
+void getScheduledGains(const gainplan_t * plan, uint8_t direction, float speed, pidgains_t * gains)
+{
+    const pidgains_t * lut = plan->lut[direction];
+    float x = ((speed < 0.0f) ? -speed : speed) * plan->scale[direction];
+    uint8_t n;
+
+    if (x >= GAINSCHEDULE_LUT_SIZE)
+    {
+        *gains = lut[GAINSCHEDULE_LUT_SIZE];
+        return;
+    }
+    n = (uint8_t) x;
+    x -= n;
+    gains->kp = lut[n].kp + x * (lut[n + 1].kp - lut[n].kp);
+    gains->ki_ta = lut[n].ki_ta + x * (lut[n + 1].ki_ta - lut[n].ki_ta);
+    gains->kd_ta = lut[n].kd_ta + x * (lut[n + 1].kd_ta - lut[n].kd_ta);
+}
+
+/** \brief Move the gains in use a step towards the scheduled ones, so a change of speed or direction does not jump the output
+ *
+ * \param current pidgains_t* the gains in use
+ * \param target const pidgains_t* the scheduled gains
+ * \return void
+ *
+ */
+void blendGains(pidgains_t * current, const pidgains_t * target)
+{
+    current->kp += GAINSCHEDULE_BLEND * (target->kp - current->kp);
+    current->ki_ta += GAINSCHEDULE_BLEND * (target->ki_ta - current->ki_ta);
+    current->kd_ta += GAINSCHEDULE_BLEND * (target->kd_ta - current->kd_ta);
+}
@@ -0,0 +1,281 @@
+#include "imu.h"
+#include "stm32f4xx_hal.h"
+#include "math.h"
+#include "controller.h"
+#include "protocol.h"
+#include "scheduler.h"
+#include "accelwindow.h"
+
+extern SPI_HandleTypeDef hspi1;
+
+#define IMU_CS_LOW()    HAL_GPIO_WritePin(GPIOA, GPIO_PIN_4, GPIO_PIN_RESET)
+#define IMU_CS_HIGH()   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_4, GPIO_PIN_SET)
+
+/** \brief States of the FIFO read
+ *
+ * The imu task starts the DMA burst, the DMA interrupt signals the task when the data is there.
+ */
+typedef enum {
+    IMU_IDLE = 0,
+    IMU_READ_FIFO,
+    IMU_DATA_READY
+} IMU_PHASE_t;
+
+static volatile IMU_PHASE_t phase = IMU_IDLE;
+static uint8_t txbuffer[1 + IMU_MAX_BURST * IMU_SAMPLE_SIZE];
+static uint8_t rxbuffer[1 + IMU_MAX_BURST * IMU_SAMPLE_SIZE];
+static uint16_t burstsamples = 0;
+
+static imustate_t state;
+
+/* accel_rope summed up between two controller cycles, for the slip detection over the window of cycles */
+static float accel_sum = 0.0f;
+static uint16_t accel_count = 0;
+static accelwindow_t window;
+static uint8_t fused = 0;
+
+static void writeRegister(uint8_t reg, uint8_t value)
+{
+    uint8_t data[2] = {reg, value};
+    IMU_CS_LOW();
+    HAL_SPI_Transmit(&hspi1, data, 2, 10);
+    IMU_CS_HIGH();
+}
+
+static uint8_t readRegister(uint8_t reg)
+{
+    uint8_t tx[2] = {reg | MPU6000_READ, 0};
+    uint8_t rx[2] = {0, 0};
+    IMU_CS_LOW();
+    HAL_SPI_TransmitReceive(&hspi1, tx, rx, 2, 10);
+    IMU_CS_HIGH();
+    return rx[1];
+}
+
+static uint16_t readFIFOCount(void)
+{
+    uint8_t tx[3] = {MPU6000_FIFO_COUNTH | MPU6000_READ, 0, 0};
+    uint8_t rx[3] = {0, 0, 0};
+    IMU_CS_LOW();
+    HAL_SPI_TransmitReceive(&hspi1, tx, rx, 3, 10);
+    IMU_CS_HIGH();
+    return (((uint16_t) rx[1]) << 8) | rx[2];
+}
+
+static void resetFIFO(void)
+{
+    writeRegister(MPU6000_USER_CTRL, 0x10 | 0x04); // I2C_IF_DIS, FIFO_RESET
+    writeRegister(MPU6000_USER_CTRL, 0x10 | 0x40); // I2C_IF_DIS, FIFO_EN
+}
+
+/** \brief Detect and configure the MPU6000
+ *
+ * The sensor samples accel and gyro at 1kHz with a 42Hz low pass and writes both into its FIFO, which is
+ * read every IMU_READ_PERIOD by DMA. Hence there is no cpu load per sample, only per burst.
+ * Takes about 150ms because of the reset of the sensor.
+ *
+ * \return void
+ *
+ */
+void initIMU()
+{
+    IMU_CS_HIGH();
+    state.present = 0;
+
+    writeRegister(MPU6000_PWR_MGMT_1, 0x80); // device reset
+    HAL_Delay(100);
+    writeRegister(MPU6000_SIGNAL_PATH_RESET, 0x07);
+    HAL_Delay(50);
+    writeRegister(MPU6000_PWR_MGMT_1, 0x03); // clock source is the z gyro pll
+    writeRegister(MPU6000_USER_CTRL, 0x10); // I2C_IF_DIS, SPI only
+
+    if (readRegister(MPU6000_WHOAMI) != MPU6000_WHOAMI_ID)
+    {
+        return;
+    }
+
+    writeRegister(MPU6000_SMPLRT_DIV, 0); // 1kHz / (1 + 0)
+    writeRegister(MPU6000_CONFIG, 0x03); // DLPF 42Hz, internal sample rate 1kHz
+    writeRegister(MPU6000_GYRO_CONFIG, 0x18); // +-2000deg/s
+    writeRegister(MPU6000_ACCEL_CONFIG, 0x10); // +-8g
+    writeRegister(MPU6000_FIFO_EN, 0x78); // accel and all gyros, in this order in the FIFO
+    resetFIFO();
+
+    state.present = 1;
+}
+
+/** \brief Calculate the angles and the acceleration along the rope from one sample
+ *
+ * \param data uint8_t* IMU_SAMPLE_SIZE bytes as read from the FIFO
+ * \return void
+ *
+ */
+static void processSample(uint8_t * data)
+{
+    const float dt = 1.0f / IMU_SAMPLE_RATE;
+    uint8_t i;
+    for (i = 0; i < 3; i++)
+    {
+        state.accel[i] = ((float) (int16_t) ((data[2*i] << 8) | data[2*i+1])) * IMU_ACCEL_SCALE;
+        state.gyro[i] = ((float) (int16_t) ((data[6+2*i] << 8) | data[6+2*i+1])) * IMU_GYRO_SCALE;
+    }
+
+    /*
+     * Complementary filter: the gyro is exact short term but drifts, the direction of gravity is right long term
+     * but disturbed by every acceleration. A nose up rotation is a negative rotation around y.
+     */
+    float pitch_accel = atan2f(state.accel[0], state.accel[2]);
+    float roll_accel = atan2f(state.accel[1], state.accel[2]);
+    state.pitch = IMU_ANGLE_FILTER * (state.pitch - state.gyro[1] * dt) + (1.0f - IMU_ANGLE_FILTER) * pitch_accel;
+    state.roll = IMU_ANGLE_FILTER * (state.roll + state.gyro[0] * dt) + (1.0f - IMU_ANGLE_FILTER) * roll_accel;
+    state.roll_rate = state.gyro[0];
+
+    /* The accelerometer measures gravity as well, on a slope a part of it is along the rope */
+    state.accel_rope = state.accel[0] - 9.81f * sinf(state.pitch);
+    accel_sum += state.accel_rope;
+    accel_count++;
+
+    /* Prediction of the position, corrected by the encoder in fuseIMU() */
+    state.velocity += state.accel_rope * (float) activesettings.hall_steps_per_meter * dt;
+    state.position += state.velocity * dt;
+    state.samples++;
+}
+
+/** \brief The imu task, run every IMU_READ_PERIOD to start reading the FIFO and when signalled by the DMA interrupt
+ *
+ * Reading the FIFO count is a short blocking transfer, the samples are read by DMA and processed in the run after.
+ *
+ * \return void
+ *
+ */
+void imuTask()
+{
+    if (!state.present)
+    {
+        return;
+    }
+    if (phase == IMU_DATA_READY)
+    {
+        uint16_t i;
+        for (i = 0; i < burstsamples; i++)
+        {
+            processSample(&rxbuffer[1 + i * IMU_SAMPLE_SIZE]);
+        }
+        phase = IMU_IDLE;
+    }
+    else if (phase == IMU_IDLE)
+    {
+        uint16_t count = readFIFOCount();
+        if (count >= MPU6000_FIFO_SIZE)
+        {
+            /* The FIFO was full, the samples are not consecutive anymore */
+            state.overflows++;
+            resetFIFO();
+            return;
+        }
+        burstsamples = count / IMU_SAMPLE_SIZE;
+        if (burstsamples > IMU_MAX_BURST)
+        {
+            burstsamples = IMU_MAX_BURST;
+        }
+        if (burstsamples != 0)
+        {
+            txbuffer[0] = MPU6000_FIFO_R_W | MPU6000_READ;
+            phase = IMU_READ_FIFO;
+            IMU_CS_LOW();
+            if (HAL_SPI_TransmitReceive_DMA(&hspi1, txbuffer, rxbuffer, 1 + burstsamples * IMU_SAMPLE_SIZE) != HAL_OK)
+            {
+                IMU_CS_HIGH();
+                phase = IMU_IDLE;
+            }
+        }
+    }
+}
+
+/** \brief DMA complete callback of the SPI, called from the DMA interrupt
+ *
+ * \param hspi SPI_HandleTypeDef*
+ * \return void
+ *
+ */
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &hspi1 && phase == IMU_READ_FIFO)
+    {
+        IMU_CS_HIGH();
+        phase = IMU_DATA_READY;
+        signalTask(TASK_IMU);
+    }
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &hspi1)
+    {
+        IMU_CS_HIGH();
+        phase = IMU_IDLE;
+    }
+}
+
+/** \brief Correct the IMU prediction with the Hall sensor position, called every controller cycle
+ *
+ * The encoder is the truth for the position long term, the IMU fills in between the Hall sensor steps and
+ * measures the acceleration of the carriage independent of the wheel. Comparing it with the acceleration of
+ * the wheel shows the wheel slipping, positive when it spins and negative when it skids. Both are taken over
+ * ACCEL_WINDOW_CYCLES, within a single cycle one Hall sensor step would look like a slip already.
+ *
+ * \param pos int32_t current Hall sensor position
+ * \return void
+ *
+ */
+void fuseIMU(int32_t pos)
+{
+    if (!state.present)
+    {
+        return;
+    }
+    float steps_per_meter = (float) activesettings.hall_steps_per_meter;
+    float accel_wheel;
+    float accel_carriage;
+    if (!fused)
+    {
+        state.position = (float) pos;
+        state.velocity = 0.0f;
+        state.slip = 0.0f;
+        resetAccelWindow(&window);
+        fused = 1;
+    }
+
+    addAccelWindow(&window, pos, (accel_count != 0) ? accel_sum / accel_count : state.accel_rope);
+    if (getWindowAcceleration(&window, steps_per_meter, &accel_wheel, &accel_carriage) == 0)
+    {
+        float slip = accel_wheel - accel_carriage;
+        if (getWindowSpeed(&window, steps_per_meter) < 0.0f)
+        {
+            slip = -slip;
+        }
+        state.slip = IMU_SLIP_FILTER * state.slip + (1.0f - IMU_SLIP_FILTER) * slip;
+    }
+    accel_sum = 0.0f;
+    accel_count = 0;
+
+    float error = ((float) pos) - state.position;
+    state.position += IMU_POS_GAIN * error;
+    state.velocity += IMU_VEL_GAIN * error / (float) Ta;
+
+}
+
+/** \brief Start the fusion from the current position again, e.g. after the encoder value got set
+ *
+ * \return void
+ *
+ */
+void resyncIMU()
+{
+    fused = 0;
+}
+
+const imustate_t * getIMUState()
+{
+    return &state;
+}
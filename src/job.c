@@ -0,0 +1,86 @@
+#include "job.h"
+#include "usbd_cdc_if.h"
+#include "uart.h"
+#include "scheduler.h"
+
+/*
+ * There is a single job at a time, the commands starting one are rejected while another is active.
+ */
+static job_t job;
+
+/** \brief Start a long running command in the background
+ *
+ * Instead of printing or writing everything at once, which would block all other tasks including the controller,
+ * the job task calls the step function repeatedly, one step per run.
+ *
+ * \param name char* Name shown in the progress
+ * \param step jobstep_t Function doing one bounded piece of the work
+ * \param total uint32_t The value of position when the job is done, for the progress
+ * \param cancelable uint8_t 1 if cancelJob() may stop it
+ * \param endpoint Endpoints Where the output goes to
+ * \return int8_t 0 if started, -1 if another job is still active
+ *
+ */
+int8_t startJob(char * name, jobstep_t step, uint32_t total, uint8_t cancelable, Endpoints endpoint)
+{
+    if (job.active)
+    {
+        return -1;
+    }
+    job.name = name;
+    job.step = step;
+    job.endpoint = endpoint;
+    job.position = 0;
+    job.total = total;
+    job.cancelable = cancelable;
+    job.active = 1;
+    signalTask(TASK_JOB);
+    return 0;
+}
+
+/** \brief Stop the active job before its next step
+ *
+ * \return int8_t 0 if cancelled or no job was active, -1 if the job cannot be cancelled
+ *
+ */
+int8_t cancelJob()
+{
+    if (job.active && !job.cancelable)
+    {
+        return -1;
+    }
+    job.active = 0;
+    return 0;
+}
+
+const job_t * getJob()
+{
+    return &job;
+}
+
+/** \brief The job task, executes one step of the active job every JOB_PERIOD
+ *
+ * If the output has not been sent yet, the step is postponed, so the transmit buffer never overflows and
+ * the output is paced to what the host can take.
+ *
+ * \return void
+ *
+ */
+void jobTask()
+{
+    if (!job.active)
+    {
+        return;
+    }
+    if (getTxFree(job.endpoint) < JOB_TX_RESERVE)
+    {
+        return;
+    }
+    if (job.step(&job) != JOB_RUNNING)
+    {
+        job.active = 0;
+    }
+    /* send the output of the step right away */
+    USBPeriodElapsed();
+    UARTPeriodElapsed();
+}
@@ -0,0 +1,178 @@
+#include "latency.h"
+#include "string.h"
+
+static latencystats_t stats[LATENCY_SEGMENT_COUNT];
+
+static char * segmentlabels[LATENCY_SEGMENT_COUNT] = {"decode", "wait", "control", "pwm", "cycle", "total"};
+
+/*
+ * All stamps are DWT cycle counter values. The interrupt stores the frame, the receiver task pairs it with
+ * its snapshot and the control task picks up that pair at the start of the cycle, if there is a new one.
+ */
+static volatile uint32_t framecycles;
+static volatile uint32_t snapshotframecycles;
+static volatile uint32_t snapshotcycles;
+static volatile uint8_t snapshotfresh = 0;
+
+/*
+ * The stamps of the current control cycle
+ */
+typedef struct
+{
+    uint32_t frame;
+    uint32_t snapshot;
+    uint32_t start;
+    uint32_t output;
+    uint32_t edge;
+    uint8_t hasframe;               // the cycle used a new frame, else only the cycle duration is accounted
+    uint8_t hasoutput;
+} latencytrace_t;
+
+static latencytrace_t trace;
+
+static uint8_t getBucket(uint32_t us)
+{
+    uint8_t msb;
+    uint32_t bucket;
+
+    if (us < 2 * LATENCY_SUB_BUCKETS)
+    {
+        return us;
+    }
+    msb = 31 - __CLZ(us);
+    bucket = 2 * LATENCY_SUB_BUCKETS + (msb - 4) * LATENCY_SUB_BUCKETS + ((us >> (msb - 3)) & (LATENCY_SUB_BUCKETS - 1));
+    return (bucket < LATENCY_HISTOGRAM_SIZE) ? bucket : LATENCY_HISTOGRAM_SIZE - 1;
+}
+
+/** \brief The smallest latency in us counted in the histogram bucket
+ *
+ * \param bucket uint8_t
+ * \return uint32_t us
+ *
+ */
+uint32_t getLatencyBucketStart(uint8_t bucket)
+{
+    if (bucket < 2 * LATENCY_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+    bucket -= 2 * LATENCY_SUB_BUCKETS;
+    return (LATENCY_SUB_BUCKETS + (bucket % LATENCY_SUB_BUCKETS)) << (bucket / LATENCY_SUB_BUCKETS + 1);
+}
+
+static void addLatency(LATENCYSEGMENT_t segment, uint32_t cycles)
+{
+    latencystats_t * s = &stats[segment];
+    uint32_t us = cycles / (SystemCoreClock / 1000000);
+
+    if (s->count == 0 || us < s->min)
+    {
+        s->min = us;
+    }
+    if (us > s->max)
+    {
+        s->max = us;
+    }
+    s->count++;
+    s->sum += us;
+    s->histogram[getBucket(us)]++;
+}
+
+/** \brief Take the timestamp of a stage, called by the receiver interrupts, the receiver task and the control task
+ *
+ * \param stamp LATENCYSTAMP_t
+ * \return void
+ *
+ */
+void traceLatency(LATENCYSTAMP_t stamp)
+{
+    uint32_t now = DWT->CYCCNT;
+    uint32_t primask;
+
+    switch (stamp)
+    {
+    case LATENCY_FRAME:
+        framecycles = now;
+        break;
+    case LATENCY_SNAPSHOT:
+        snapshotframecycles = framecycles;
+        snapshotcycles = now;
+        snapshotfresh = 1;
+        break;
+    case LATENCY_CYCLE_START:
+        primask = __get_PRIMASK();
+        __disable_irq();
+        trace.hasframe = snapshotfresh;
+        trace.frame = snapshotframecycles;
+        trace.snapshot = snapshotcycles;
+        snapshotfresh = 0;
+        __set_PRIMASK(primask);
+        trace.hasoutput = 0;
+        trace.start = now;
+        break;
+    case LATENCY_CYCLE_END:
+        addLatency(LATENCY_CYCLE, now - trace.start);
+        if (trace.hasframe && trace.hasoutput)
+        {
+            addLatency(LATENCY_DECODE, trace.snapshot - trace.frame);
+            addLatency(LATENCY_WAIT, trace.start - trace.snapshot);
+            addLatency(LATENCY_CONTROL, trace.output - trace.start);
+            addLatency(LATENCY_PWM, trace.edge - trace.output);
+            addLatency(LATENCY_TOTAL, trace.edge - trace.frame);
+        }
+        break;
+    }
+}
+
+/** \brief Take the timestamp of the ESC output, called right after the compare registers got written
+ *
+ * \param edgecycles uint32_t cpu cycles until the PWM period starts that outputs the new values
+ * \return void
+ *
+ */
+void traceLatencyOutput(uint32_t edgecycles)
+{
+    trace.output = DWT->CYCCNT;
+    trace.edge = trace.output + edgecycles;
+    trace.hasoutput = 1;
+}
+
+void resetLatency()
+{
+    memset(stats, 0, sizeof(stats));
+}
+
+void getLatencyStats(LATENCYSEGMENT_t segment, latencystats_t * copy)
+{
+    memcpy(copy, &stats[segment], sizeof(latencystats_t));
+}
+
+/** \brief The latency a given share of the samples stays below, estimated from the histogram
+ *
+ * \param stats const latencystats_t*
+ * \param permille uint16_t e.g. 500 for the median, 990 for the 99th percentile
+ * \return uint32_t us, the end of the histogram bucket the percentile falls into, at most the max
+ *
+ */
+uint32_t getLatencyPercentile(const latencystats_t * stats, uint16_t permille)
+{
+    uint64_t rank = ((uint64_t) stats->count) * permille;
+    uint64_t seen = 0;
+    uint8_t i;
+
+    for (i = 0; i < LATENCY_HISTOGRAM_SIZE - 1; i++)
+    {
+        seen += ((uint64_t) stats->histogram[i]) * 1000;
+        if (seen >= rank)
+        {
+            uint32_t end = getLatencyBucketStart(i + 1) - 1;
+            return (end < stats->max) ? end : stats->max;
+        }
+    }
+    return stats->max;
+}
+
+char * getLatencySegmentLabel(LATENCYSEGMENT_t segment)
+{
+    return segmentlabels[segment];
+}
@@ -0,0 +1,124 @@
+#include "linkquality.h"
+#include "stm32f4xx_hal.h"
+#include "timebase.h"
+#include "string.h"
+
+static linkstats_t stats;
+
+static uint8_t started = 0;
+static uint32_t lastframetime;      // us
+static uint32_t lastframetick;      // HAL_GetTick() at the last frame, for gaps longer than the microsecond counter wraps
+static uint8_t failsafe = 0;
+static uint32_t failsafestart;
+
+/** \brief Account one RC frame, called by the receiver interrupts
+ *
+ * Everything is a constant amount of work, the interval to the previous frame goes into the histogram
+ * and is compared with the nominal interval to find lost frames.
+ *
+ * \param flags uint8_t LINKQUALITY_FLAG_SIGNALLOSS and LINKQUALITY_FLAG_FAILSAFE as reported by the receiver
+ * \return void
+ *
+ */
+void recordReceiverFrame(uint8_t flags)
+{
+    uint32_t now = MICROS();
+    uint32_t tick = HAL_GetTick();
+
+    stats.frames++;
+    if (started)
+    {
+        uint32_t interval;
+        uint32_t bucket;
+
+        if (tick - lastframetick > 3600000L)
+        {
+            /* the microsecond counter wraps every 71 minutes */
+            interval = 0xFFFFFFFF;
+        }
+        else
+        {
+            interval = TIME_ELAPSED(now, lastframetime);
+        }
+
+        bucket = interval >> 10;
+        if (bucket >= LINKQUALITY_HISTOGRAM_SIZE)
+        {
+            bucket = LINKQUALITY_HISTOGRAM_SIZE - 1;
+        }
+        stats.histogram[bucket]++;
+
+        if (interval > stats.longest_gap)
+        {
+            stats.longest_gap = interval;
+        }
+        if (tick - lastframetick > LINKQUALITY_TIMEOUT)
+        {
+            stats.timeouts++;
+        }
+
+        if (stats.nominal_interval == 0)
+        {
+            stats.nominal_interval = interval;
+        }
+        else if (interval > stats.nominal_interval + stats.nominal_interval / 2)
+        {
+            uint32_t lost = (interval + stats.nominal_interval / 2) / stats.nominal_interval - 1;
+            stats.lost_frames += lost;
+            stats.lost_runs++;
+            if (lost > stats.longest_run)
+            {
+                stats.longest_run = lost;
+            }
+        }
+        else
+        {
+            /* follow the receiver's frame rate slowly, the gaps do not count */
+            stats.nominal_interval += ((int32_t) (interval - stats.nominal_interval)) / 8;
+        }
+    }
+    started = 1;
+    lastframetime = now;
+    lastframetick = tick;
+
+    if (flags & LINKQUALITY_FLAG_SIGNALLOSS)
+    {
+        stats.signalloss_frames++;
+    }
+    if (flags & LINKQUALITY_FLAG_FAILSAFE)
+    {
+        stats.failsafe_frames++;
+        if (!failsafe)
+        {
+            stats.failsafe_episodes++;
+            failsafestart = tick;
+            failsafe = 1;
+        }
+        if (tick - failsafestart > stats.failsafe_longest)
+        {
+            stats.failsafe_longest = tick - failsafestart;
+        }
+    }
+    else
+    {
+        failsafe = 0;
+    }
+}
+
+void resetLinkStats()
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&stats, 0, sizeof(stats));
+    started = 0;
+    failsafe = 0;
+    __set_PRIMASK(primask);
+}
+
+void getLinkStats(linkstats_t * copy)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memcpy(copy, &stats, sizeof(linkstats_t));
+    __set_PRIMASK(primask);
+}
@@ -49,6 +49,7 @@
 #include "main.h"
 #include "stm32f4xx_hal.h"
 #include "usb_device.h"
+#include "config.h"
 #include "controller.h"
 #include "protocol.h"
 
@@ -58,6 +59,20 @@
 #include "usbd_cdc_if.h"
 #include "spi_flash.h"
 #include "eeprom.h"
+#include "postrigger.h"
+#include "posbackup.h"
+#include "boottime.h"
+#include "profiler.h"
+#include "scheduler.h"
+#include "job.h"
+#include "simulation.h"
+#include "imu.h"
+#include "shaper.h"
+#include "tracking.h"
+#include "uart.h"
+#include "latency.h"
+#include "timebase.h"
+#include "controlplan.h"
 
 /* Private variables ---------------------------------------------------------*/
 RTC_HandleTypeDef hrtc;
@@ -77,9 +92,8 @@ DMA_HandleTypeDef hdma_usart2_rx;
 DMA_HandleTypeDef hdma_usart2_tx;
 DMA_HandleTypeDef hdma_usart3_rx;
 DMA_HandleTypeDef hdma_usart3_tx;
-
-/* Private variables ---------------------------------------------------------*/
-uint32_t lasttick;
+DMA_HandleTypeDef hdma_spi1_rx;
+DMA_HandleTypeDef hdma_spi1_tx;
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
@@ -95,6 +109,10 @@ static void MX_USART2_UART_Init(void);
 static void MX_TIM5_Init(void);
 static void MX_TIM1_Init(void);
 
+static void controlTask(void);
+static void commandTask(void);
+static void telemetryTask(void);
+
 void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
 
 int main(void)
@@ -108,39 +126,50 @@ int main(void)
 
     /* Configure the system clock */
     SystemClock_Config();
-
-    /* Initialize all configured peripherals */
+    initTimebase();
+    initBootTime();
+    initScheduler();
+
+    /*
+     * The ESC output comes first, so the ESC sees a valid neutral signal as early as possible.
+     * The pulse width is the 1500us from MX_TIM3_Init() until the settings with the real neutral value are loaded.
+     */
     MX_GPIO_Init();
+    MX_TIM3_Init();
+    if (HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_3) != HAL_OK)
+    {
+        /* PWM generation Error */
+        Error_Handler();
+    }
+    if (HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_4) != HAL_OK)
+    {
+        /* PWM generation Error */
+        Error_Handler();
+    }
+    setBootStage(BOOT_STAGE_ESC_OUTPUT);
+
+    /* Initialize all other configured peripherals, USB is started at the very end */
+    MX_TIM5_Init();
+    HAL_TIM_Encoder_Start(&htim5, TIM_CHANNEL_1 | TIM_CHANNEL_2);
     MX_DMA_Init();
     MX_RTC_Init();
+    initPosBackup();
     MX_SPI1_Init();
     MX_SPI3_Init();
-    MX_TIM3_Init();
     MX_USART3_UART_Init();
-    MX_USB_DEVICE_Init();
     MX_USART2_UART_Init();
-    MX_TIM5_Init();
+    initUARTPorts();
 
     /* Disable Half Transfer Interrupt */
     /* __HAL_DMA_DISABLE_IT(huart1.hdmarx, DMA_IT_HT); */
 
     initProtocol();
 
-
-    HAL_TIM_Encoder_Start(&htim5, TIM_CHANNEL_1 | TIM_CHANNEL_2);
+    initPosTriggers();
+    initSimulation();
 
     LED_WARN_OFF;
-
-    if (HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_3) != HAL_OK)
-    {
-        /* PWM generation Error */
-        Error_Handler();
-    }
-    if (HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_4) != HAL_OK)
-    {
-        /* PWM generation Error */
-        Error_Handler();
-    }
+    setBootStage(BOOT_STAGE_PERIPHERALS);
 
     if (eeprom_init() != 0)
     {
@@ -148,35 +177,7 @@ int main(void)
         Error_Handler();
     }
 
-    activesettings.esc_direction = 0;
-    activesettings.D = 0.0f;
-    activesettings.I = 0.0f;
-    activesettings.P = 0.0f;
-    activesettings.max_position_error = 100.0f;
-    activesettings.mode = MODE_PASSTHROUGH;
-    activesettings.pos_end = (double) POS_END_NOT_SET;
-    activesettings.pos_start = (double) -POS_END_NOT_SET;
-    activesettings.rc_channel_endpoint = 6;
-    activesettings.rc_channel_programming = 5;
-    activesettings.rc_channel_speed = 0;
-    activesettings.stick_max_accel = 20;
-    activesettings.stick_max_accel_safemode = 10;
-    activesettings.stick_max_speed = 500;
-    activesettings.stick_max_speed_safemode = 100;
-    activesettings.stick_neutral_pos = 992;
-    activesettings.stick_neutral_range = 30;
-    strcpy(activesettings.version, "20170817");
-    activesettings.stick_speed_factor = 0.01f;
-    activesettings.receivertype = RECEIVER_TYPE_SUMPPM;
-
-    // 20170815
-    activesettings.esc_neutral_pos = 1500;
-    activesettings.esc_neutral_range = 30;
-
-    // 20170817
-    activesettings.rc_channel_max_accel = 255;
-    activesettings.rc_channel_max_speed = 255;
-
+    setDefaultSettings();
 
     eeprom_read_sector((uint8_t *)&defaultsettings, sizeof(defaultsettings), EEPROM_SECTOR_FOR_SETTINGS);
     if (strncmp(activesettings.version, defaultsettings.version, sizeof(activesettings.version)) == 0)
@@ -205,11 +206,93 @@ int main(void)
             activesettings.rc_channel_max_accel = 255;
             activesettings.rc_channel_max_speed = 255;
         }
+
+        // With firmware 20170820 the hall_steps_per_meter got added, the erased eeprom reads as NaN
+        if (!(activesettings.hall_steps_per_meter > 0.0f))
+        {
+            activesettings.hall_steps_per_meter = 100.0f;
+        }
+
+        // With firmware 20170822 the input shaper got added
+        if (activesettings.shaper_type > SHAPER_EI || !(activesettings.shaper_frequency > 0.0f) || !(activesettings.shaper_damping >= 0.0f))
+        {
+            activesettings.shaper_type = SHAPER_OFF;
+            activesettings.shaper_frequency = 0.5f;
+            activesettings.shaper_damping = 0.0f;
+        }
+
+        // With firmware 20170823 the esc table got added, erased eeprom reads as 0xFF
+        if (activesettings.esc_table_active > 1)
+        {
+            activesettings.esc_table_active = 0;
+            activesettings.esc_table_range = 0;
+        }
+
+        // With firmware 20170824 the feed forward map got added
+        if (activesettings.feedforward_active > 1)
+        {
+            activesettings.feedforward_active = 0;
+        }
+
+        // With firmware 20170825 the traction control got added
+        if (!(activesettings.traction_slip_threshold >= 0.0f))
+        {
+            activesettings.traction_slip_threshold = 0.0f;
+        }
+
+        // With firmware 20170826 the speed zones got added, the erased eeprom reads as 0xFF which is "not used" for the channel
+        if (activesettings.zone_count > SPEEDZONE_MAX)
+        {
+            activesettings.zone_count = 0;
+        }
+
+        // With firmware 20170827 the stick curves got added
+        if (activesettings.stick_curve[0].type > STICKCURVE_CUSTOM || activesettings.stick_curve[1].type > STICKCURVE_CUSTOM ||
+            activesettings.stick_curve_range <= 0)
+        {
+            activesettings.stick_curve[0].type = STICKCURVE_LINEAR;
+            activesettings.stick_curve[0].expo = 0.0f;
+            activesettings.stick_curve[1] = activesettings.stick_curve[0];
+            activesettings.stick_curve_range = STICKCURVE_DEFAULT_RANGE;
+        }
+
+        // With firmware 20170828 the yaw tracking got added, the erased eeprom reads as 0xFF which is "not used" for the channel
+        if (activesettings.tracking_active > 1 || !(activesettings.tracking_max_rate > 0.0f))
+        {
+            activesettings.tracking_active = 0;
+            activesettings.tracking_target = 0;
+            activesettings.tracking_distance = 0.0f;
+            activesettings.tracking_us_per_degree = TRACKING_DEFAULT_US_PER_DEGREE;
+            activesettings.tracking_max_rate = TRACKING_DEFAULT_MAX_RATE;
+        }
+
+        // With firmware 20170829 the servo output settings got added
+        if (activesettings.servo_protocol > SERVO_PROTOCOL_ONESHOT125 || activesettings.servo_outputs[SERVO_ESC].max == 0 ||
+            activesettings.servo_outputs[SERVO_ESC].max == 0xFFFF)
+        {
+            setDefaultServoOutputs();
+        }
+        else if (activesettings.servo_outputs[SERVO_ESC].min == SERVO_MIN &&
+                 activesettings.servo_outputs[SERVO_ESC].max == SERVO_MAX)
+        {
+            // The first servo output defaults cut the ESC off at 900..2100
+            setDefaultESCOutputLimits();
+        }
+
+        // With firmware 20170830 the gain schedule got added, without breakpoints the P, I and D values apply at all speeds
+        if (activesettings.gain_count[0] > GAINSCHEDULE_POINTS || activesettings.gain_count[1] > GAINSCHEDULE_POINTS)
+        {
+            activesettings.gain_count[0] = 0;
+            activesettings.gain_count[1] = 0;
+        }
     }
     else
     {
         strcpy(controllerstatus.boottext_eeprom, "eeprom does not contain valid default - keeping the system defaults");
     }
+    TIM3->CCR3 = activesettings.esc_neutral_pos;
+    setServoProtocol(activesettings.servo_protocol);
+    setBootStage(BOOT_STAGE_SETTINGS);
 
     if (activesettings.receivertype == RECEIVER_TYPE_SBUS)
     {
@@ -242,56 +325,125 @@ int main(void)
          */
         activesettings.esc_scale = 6;
     }
+    setBootStage(BOOT_STAGE_RC_INPUT);
 
+    restorePosBackup();
     initController();
+    setBootStage(BOOT_STAGE_CONTROLLER);
+
+    /*
+     * The USB enumeration is done by the host and driven by interrupts, hence it runs while the controller is active already.
+     */
+    MX_USB_DEVICE_Init();
+    setBootStage(BOOT_STAGE_USB);
+
+    /* The MPU6000 needs 150ms for its reset, hence it is last */
+    initIMU();
+    setBootStage(BOOT_STAGE_IMU);
+
+    /*
+     * From here on everything is done by the tasks, see scheduler.h for the priorities.
+     */
+    addTask(TASK_CONTROL, "control", controlTask, 20);
+    addTask(TASK_RECEIVER, "receiver", processSBUSFrame, 0);
+    addTask(TASK_IMU, "imu", imuTask, IMU_READ_PERIOD);
+    addTask(TASK_COMMAND, "command", commandTask, 0);
+    addTask(TASK_TELEMETRY, "telemetry", telemetryTask, 20);
+    addTask(TASK_JOB, "job", jobTask, JOB_PERIOD);
+    runScheduler();
+}
+
+/** \brief The hard real-time task, run every 20ms
+ *
+ * The clock50Hz gets increased by one with every run and hence provides a stable information
+ * for slow frequency operations.
+ *
+ * \return void
+ *
+ */
+static void controlTask()
+{
+    tickCounter();
+    PROFILER_ENTER();
+    simulationCycle();
+    fuseIMU((int32_t) ENCODER_VALUE);
+    traceLatency(LATENCY_CYCLE_START);
+    controllercycle();
+    traceLatency(LATENCY_CYCLE_END);
+    PROFILER_EXIT(PROBE_CONTROLLERCYCLE);
+    setBootStage(BOOT_STAGE_FIRST_CYCLE);
+}
 
-    while (1)
+/** \brief Handle one received command line, signalled by the USB receive callback
+ *
+ * \return void
+ *
+ */
+static void commandTask()
+{
+    char * line;
+    if( USB_ReceiveString() > 0 )
+    {
+        PROFILER_ENTER();
+        serialCom(commandlinebuffer, EndPoint_USB);
+        PROFILER_EXIT(PROBE_SERIALCOM);
+        /* there might be more lines in the buffer and the response should be sent right away */
+        signalTask(TASK_COMMAND);
+        USBPeriodElapsed();
+    }
+    /* the uarts are handled the same way, each answer goes to where the command came from */
+    if ((line = UART_ReceiveString(EndPoint_UART3)) != NULL)
+    {
+        serialCom(line, EndPoint_UART3);
+        signalTask(TASK_COMMAND);
+        UARTPeriodElapsed();
+    }
+    if ((line = UART_ReceiveString(EndPoint_UART2)) != NULL)
+    {
+        serialCom(line, EndPoint_UART2);
+        signalTask(TASK_COMMAND);
+        UARTPeriodElapsed();
+    }
+    /* the commands, jobs and the RC switches only request a new plan, it is compiled here once */
+    updateControlPlan();
+}
+
+/** \brief Send the buffered USB and uart output and update the LEDs, run every 20ms
+ *
+ * \return void
+ *
+ */
+static void telemetryTask()
+{
+    USBPeriodElapsed();
+    UARTPeriodElapsed();
+    if (is1Hz() && controllerstatus.safemode == OPERATIONAL)
     {
         /*
-         * HAL_GetTick() returns the hardware system time value in ms.
-         * Every time 20 ms have passed, the clock50Hz gets increased by one
-         * and hence provides a stable information for slow frequency operations.
+         * In operational mode we let the LED toggle slowly, once per second
+         *
          */
-        if (HAL_GetTick() - lasttick > 20)
-        {
-            lasttick = HAL_GetTick();
-            tickCounter();
-
-            USBPeriodElapsed();
-            if (is1Hz() && controllerstatus.safemode == OPERATIONAL)
-            {
-                /*
-                 * In operational mode we let the LED toggle slowly, once per second
-                 *
-                 */
-                LED_STATUS_TOGGLE;
-            }
-            if (is5Hz() && controllerstatus.safemode == PROGRAMMING)
-            {
-                /*
-                 * In programming mode we let the LED toggle quickly, 5 times per second
-                 *
-                 */
-                LED_STATUS_TOGGLE;
-            }
-            if (controllerstatus.safemode == INVALID_RC ||controllerstatus.safemode == NOT_NEUTRAL_AT_STARTUP)
-            {
-                /*
-                 * When there is no valid RC signal, the WARN LED is turned on
-                 *
-                 */
-                LED_WARN_ON;
-            }
-            else
-            {
-                LED_WARN_OFF;
-            }
-            controllercycle();
-        }
-        if( USB_ReceiveString() > 0 )
-        {
-            serialCom(EndPoint_USB);
-        }
+        LED_STATUS_TOGGLE;
+    }
+    if (is5Hz() && controllerstatus.safemode == PROGRAMMING)
+    {
+        /*
+         * In programming mode we let the LED toggle quickly, 5 times per second
+         *
+         */
+        LED_STATUS_TOGGLE;
+    }
+    if (controllerstatus.safemode == INVALID_RC ||controllerstatus.safemode == NOT_NEUTRAL_AT_STARTUP)
+    {
+        /*
+         * When there is no valid RC signal, the WARN LED is turned on
+         *
+         */
+        LED_WARN_ON;
+    }
+    else
+    {
+        LED_WARN_OFF;
     }
 }
 
@@ -358,7 +510,7 @@ void SystemClock_Config(void)
     HAL_SYSTICK_CLKSourceConfig(SYSTICK_CLKSOURCE_HCLK);
 
     /* SysTick_IRQn interrupt configuration */
-    HAL_NVIC_SetPriority(SysTick_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(SysTick_IRQn, NVIC_PRIORITY_SYSTICK, 0);
 }
 
 /* RTC init function */
@@ -389,8 +541,8 @@ static void MX_SPI1_Init(void)
     hspi1.Init.DataSize = SPI_DATASIZE_8BIT;
     hspi1.Init.CLKPolarity = SPI_POLARITY_LOW;
     hspi1.Init.CLKPhase = SPI_PHASE_1EDGE;
-    hspi1.Init.NSS = SPI_NSS_HARD_INPUT;
-    hspi1.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_2;
+    hspi1.Init.NSS = SPI_NSS_SOFT;
+    hspi1.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16; // 1MHz, the max of the MPU6000 for all registers other than the sensor values
     hspi1.Init.FirstBit = SPI_FIRSTBIT_MSB;
     hspi1.Init.TIMode = SPI_TIMODE_DISABLE;
     hspi1.Init.CRCCalculation = SPI_CRCCALCULATION_DISABLE;
@@ -625,20 +777,26 @@ static void MX_DMA_Init(void)
 
     /* DMA interrupt init */
     /* DMA1_Stream1_IRQn interrupt configuration */
-    HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, NVIC_PRIORITY_SERIAL, 0);
     HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
     /* DMA1_Stream3_IRQn interrupt configuration */
-    HAL_NVIC_SetPriority(DMA1_Stream3_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(DMA1_Stream3_IRQn, NVIC_PRIORITY_SERIAL, 0);
     HAL_NVIC_EnableIRQ(DMA1_Stream3_IRQn);
     /* DMA1_Stream5_IRQn interrupt configuration */
-    HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, NVIC_PRIORITY_SERIAL, 0);
     HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
     /* DMA1_Stream6_IRQn interrupt configuration */
-    HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, NVIC_PRIORITY_SERIAL, 0);
     HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+    /* DMA2_Stream0_IRQn interrupt configuration */
+    HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, NVIC_PRIORITY_SERIAL, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
     /* DMA2_Stream2_IRQn interrupt configuration */
-    HAL_NVIC_SetPriority(DMA2_Stream2_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(DMA2_Stream2_IRQn, NVIC_PRIORITY_RC_INPUT, 0);
     HAL_NVIC_EnableIRQ(DMA2_Stream2_IRQn);
+    /* DMA2_Stream3_IRQn interrupt configuration */
+    HAL_NVIC_SetPriority(DMA2_Stream3_IRQn, NVIC_PRIORITY_SERIAL, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream3_IRQn);
 }
 
 /** Configure pins as
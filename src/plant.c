@@ -0,0 +1,130 @@
+#include "plant.h"
+#include "math.h"
+
+/** \brief Default parameters of a typical cablecam with a car ESC on a 100m rope
+ *
+ * \param params plantparams_t*
+ * \return void
+ *
+ */
+void initPlantParams(plantparams_t * params)
+{
+    params->mass = 4.0f;
+    params->slope = -0.05f;
+    params->slope_gradient = 0.001f;
+    params->friction = 1.0f;
+    params->drag = 2.0f;
+    params->max_thrust = 20.0f;
+    params->brake = 8.0f;
+    params->esc_lag = 0.1f;
+    params->esc_neutral_pos = 1500;
+    params->esc_neutral_range = 30;
+    params->esc_full_range = 500;
+    params->steps_per_meter = 100.0f;
+}
+
+/** \brief Put the cablecam at a standstill at the given Hall sensor position
+ *
+ * \param state plantstate_t*
+ * \param params const plantparams_t*
+ * \param counter int32_t Hall sensor position
+ * \return void
+ *
+ */
+void resetPlant(plantstate_t * state, const plantparams_t * params, int32_t counter)
+{
+    state->position = ((float) counter) / params->steps_per_meter;
+    state->speed = 0.0f;
+    state->thrust = 0.0f;
+    state->counter = counter;
+}
+
+/** \brief The thrust the ESC asks the motor for at the given pulse width
+ *
+ * \param params const plantparams_t*
+ * \param esc int16_t pulse width in us
+ * \return float N, 0 within the neutral range of the ESC
+ *
+ */
+static float getESCThrust(const plantparams_t * params, int16_t esc)
+{
+    int16_t value = esc - params->esc_neutral_pos;
+    float span = (float) (params->esc_full_range - params->esc_neutral_range);
+
+    if (value > params->esc_neutral_range)
+    {
+        value -= params->esc_neutral_range;
+    }
+    else if (value < -params->esc_neutral_range)
+    {
+        value += params->esc_neutral_range;
+    }
+    else
+    {
+        return 0.0f;
+    }
+    if (span <= 0.0f)
+    {
+        return 0.0f;
+    }
+    float thrust = params->max_thrust * ((float) value) / span;
+    if (thrust > params->max_thrust)
+    {
+        thrust = params->max_thrust;
+    }
+    else if (thrust < -params->max_thrust)
+    {
+        thrust = -params->max_thrust;
+    }
+    return thrust;
+}
+
+/** \brief Advance the simulation by one time step
+ *
+ * The speed is integrated with the Euler method, the position with the mean speed of the step. That is accurate
+ * enough at the 20ms controller cycle for the slow dynamics of a cablecam. It uses single precision floats only,
+ * so it costs a few us on the FPU of the STM32F4.
+ * Friction and the drag brake never reverse the motion, they stop the cablecam within the step instead.
+ *
+ * \param state plantstate_t*
+ * \param params const plantparams_t*
+ * \param esc int16_t ESC pulse width in us as generated for TIM3 CCR3
+ * \param dt float s, the time step
+ * \return void
+ *
+ */
+void stepPlant(plantstate_t * state, const plantparams_t * params, int16_t esc, float dt)
+{
+    float target = getESCThrust(params, esc);
+    float lag = (params->esc_lag > dt) ? dt / params->esc_lag : 1.0f;
+    state->thrust += (target - state->thrust) * lag;
+
+    float slope = params->slope + params->slope_gradient * state->position;
+    float force = state->thrust - params->mass * PLANT_GRAVITY * sinf(slope) - params->drag * state->speed;
+
+    /* Forces that act against the motion only: rolling friction and, in neutral, the ESC drag brake */
+    float resistance = params->friction;
+    if (target == 0.0f)
+    {
+        resistance += params->brake;
+    }
+
+    if (state->speed == 0.0f && fabsf(force) <= resistance)
+    {
+        /* standing and the friction holds it */
+        return;
+    }
+
+    float direction = (state->speed != 0.0f) ? state->speed : force;
+    force -= (direction > 0.0f) ? resistance : -resistance;
+
+    float speed = state->speed + force / params->mass * dt;
+    if ((state->speed > 0.0f && speed < 0.0f) || (state->speed < 0.0f && speed > 0.0f))
+    {
+        /* the resistance stopped the cablecam within this step */
+        speed = 0.0f;
+    }
+    state->position += (state->speed + speed) * 0.5f * dt;
+    state->speed = speed;
+    state->counter = (int32_t) floorf(state->position * params->steps_per_meter);
+}
@@ -0,0 +1,155 @@
+#include "posbackup.h"
+#include "config.h"
+#include "protocol.h"
+#include "simulation.h"
+#include "string.h"
+
+extern RTC_HandleTypeDef hrtc;
+
+/*
+ * Layout of the checkpoint in the RTC backup registers.
+ */
+#define POSBACKUP_REG_MAGIC     RTC_BKP_DR0
+#define POSBACKUP_REG_POS       RTC_BKP_DR1
+#define POSBACKUP_REG_SPEED     RTC_BKP_DR2
+#define POSBACKUP_REG_CHECKSUM  RTC_BKP_DR3
+
+static volatile int32_t lastcheckpointspeed = 0;
+
+static uint32_t getChecksum(uint32_t pos, uint32_t speed)
+{
+    return ~(POSBACKUP_MAGIC ^ pos ^ speed);
+}
+
+static void writeCheckpoint(int32_t pos, int32_t speed)
+{
+    if (isSimulationActive())
+    {
+        /* a simulated position must never be restored as the real one */
+        return;
+    }
+    /*
+     * The magic is cleared first and written last, hence a checkpoint interrupted by a power loss
+     * has no valid magic and is rejected, it never mixes the old and the new values.
+     */
+    HAL_RTCEx_BKUPWrite(&hrtc, POSBACKUP_REG_MAGIC, 0);
+    HAL_RTCEx_BKUPWrite(&hrtc, POSBACKUP_REG_POS, (uint32_t) pos);
+    HAL_RTCEx_BKUPWrite(&hrtc, POSBACKUP_REG_SPEED, (uint32_t) speed);
+    HAL_RTCEx_BKUPWrite(&hrtc, POSBACKUP_REG_CHECKSUM, getChecksum((uint32_t) pos, (uint32_t) speed));
+    HAL_RTCEx_BKUPWrite(&hrtc, POSBACKUP_REG_MAGIC, POSBACKUP_MAGIC);
+}
+
+/** \brief Enable the access to the backup domain and the brown-out detection
+ *
+ * The RTC backup registers keep their values across resets and, as long as VBAT is powered,
+ * across power cycles as well. The power voltage detector raises an interrupt when VDD drops
+ * below 2.9V, so the very last position can be saved before the board loses power.
+ *
+ * \return void
+ *
+ */
+void initPosBackup()
+{
+    PWR_PVDTypeDef sConfigPVD;
+
+    __HAL_RCC_PWR_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+
+    sConfigPVD.PVDLevel = PWR_PVDLEVEL_7;
+    sConfigPVD.Mode = PWR_PVD_MODE_IT_RISING;
+    HAL_PWR_ConfigPVD(&sConfigPVD);
+    HAL_PWR_EnablePVD();
+
+    HAL_NVIC_SetPriority(PVD_IRQn, NVIC_PRIORITY_ENCODER, 0);
+    HAL_NVIC_EnableIRQ(PVD_IRQn);
+}
+
+/** \brief Set the encoder to the position stored in the backup registers if plausible
+ *
+ * Has to be called after the settings had been loaded, as the endpoints are used for the plausibility check,
+ * and before the controller starts.
+ * The checkpoint is used only if
+ * - it is complete, meaning magic and checksum are valid,
+ * - the cablecam was not moving at that time, else the position at power off is unknown,
+ * - the position is within the endpoints, allowing for the max_position_error.
+ *
+ * \return uint8_t 1 if the position got restored, 0 if the encoder starts at zero
+ *
+ */
+uint8_t restorePosBackup()
+{
+    uint32_t magic = HAL_RTCEx_BKUPRead(&hrtc, POSBACKUP_REG_MAGIC);
+    uint32_t pos = HAL_RTCEx_BKUPRead(&hrtc, POSBACKUP_REG_POS);
+    uint32_t speed = HAL_RTCEx_BKUPRead(&hrtc, POSBACKUP_REG_SPEED);
+    uint32_t checksum = HAL_RTCEx_BKUPRead(&hrtc, POSBACKUP_REG_CHECKSUM);
+
+    if (magic != POSBACKUP_MAGIC || checksum != getChecksum(pos, speed))
+    {
+        strcpy(controllerstatus.boottext_position, "no position checkpoint found - position starts at zero");
+        return 0;
+    }
+    if ((int32_t) speed > POSBACKUP_MAX_RESUME_SPEED || (int32_t) speed < -POSBACKUP_MAX_RESUME_SPEED)
+    {
+        strcpy(controllerstatus.boottext_position, "position checkpoint taken while moving - position starts at zero");
+        return 0;
+    }
+    if (activesettings.pos_end != (double) POS_END_NOT_SET &&
+            activesettings.pos_start != (double) -POS_END_NOT_SET)
+    {
+        double start = activesettings.pos_start;
+        double end = activesettings.pos_end;
+        if (start > end)
+        {
+            start = activesettings.pos_end;
+            end = activesettings.pos_start;
+        }
+        if ((double) ((int32_t) pos) < start - activesettings.max_position_error ||
+                (double) ((int32_t) pos) > end + activesettings.max_position_error)
+        {
+            strcpy(controllerstatus.boottext_position, "position checkpoint outside the endpoints - position starts at zero");
+            return 0;
+        }
+    }
+
+    /*
+     * The encoder is running already, hence whatever it counted since the boot is added. The counter is stopped
+     * meanwhile, else a step counted between reading and writing CNT would be lost.
+     */
+    TIM5->CR1 &= ~TIM_CR1_CEN;
+    uint32_t counted = ENCODER_VALUE;
+    ENCODER_VALUE = counted + pos;
+    TIM5->CR1 |= TIM_CR1_CEN;
+    strcpy(controllerstatus.boottext_position, "position restored from the checkpoint");
+    return 1;
+}
+
+/** \brief Store the current position and speed in the backup registers
+ *
+ * Called every controller cycle. As the backup registers are plain registers, there is no wear.
+ *
+ * \param pos int32_t Current encoder position
+ * \param speed int32_t Change of the position within the last cycle
+ * \return void
+ *
+ */
+void checkpointPos(int32_t pos, int32_t speed)
+{
+    /* The brown-out interrupt writes the checkpoint as well, it must not interleave with this one */
+    HAL_NVIC_DisableIRQ(PVD_IRQn);
+    lastcheckpointspeed = speed;
+    writeCheckpoint(pos, speed);
+    HAL_NVIC_EnableIRQ(PVD_IRQn);
+}
+
+/** \brief Brown-out callback of the power voltage detector
+ *
+ * VDD is dropping, write the checkpoint one last time with the current encoder value.
+ * The speed is the one of the last cycle, so a cablecam moving at power loss is not resumed.
+ *
+ * \return void
+ *
+ */
+void HAL_PWR_PVDCallback(void)
+{
+    writeCheckpoint((int32_t) ENCODER_VALUE, lastcheckpointspeed);
+}
@@ -0,0 +1,289 @@
+#include "postrigger.h"
+#include "config.h"
+#include "protocol.h"
+#include "servo.h"
+
+/*
+ * The trigger list, sorted by position ascending.
+ */
+static postrigger_t triggers[POSTRIGGER_MAX_COUNT];
+static volatile uint8_t triggercount = 0;
+
+/*
+ * The encoder value at the time the triggers were evaluated the last time. All triggers between
+ * this position and the current position have been passed since.
+ */
+static int32_t lastpos = 0;
+
+static volatile uint32_t firedcount = 0;
+static volatile uint32_t skippedcount = 0;
+
+static void armPosTriggers(void);
+static void firePulse(const postrigger_t * trigger);
+
+
+/** \brief Switch the output mode of the aux servo output TIM3 CH4
+ *
+ * \param ocmode uint32_t One of the TIM_OCMODE_xxx values as used for channel 1
+ * \return void
+ *
+ */
+static void setAuxOutputMode(uint32_t ocmode)
+{
+    TIM3->CCMR2 = (TIM3->CCMR2 & ~TIM_CCMR2_OC4M) | (ocmode << 8);
+}
+
+/** \brief Turn the aux output into a trigger output or back into a servo output
+ *
+ * As a servo output the TIM3 CH4 creates the 50Hz PWM signal. As trigger output it is low and
+ * firePulse() switches it to high for the pulse width. The CCR4 preload has to be off then
+ * as the end of the pulse is set within the current period.
+ *
+ * \param enable uint8_t 1 to use the output for triggers, 0 for the servo signal
+ * \return void
+ *
+ */
+static void setAuxTriggerOutput(uint8_t enable)
+{
+    if (enable)
+    {
+        setAuxOutputMode(TIM_OCMODE_FORCED_INACTIVE);
+        TIM3->CCMR2 &= ~TIM_CCMR2_OC4PE;
+        TIM3->SR = ~TIM_SR_CC4IF;
+    }
+    else
+    {
+        TIM3->CCR4 = activesettings.esc_neutral_pos;
+        TIM3->CCMR2 |= TIM_CCMR2_OC4PE;
+        setAuxOutputMode(TIM_OCMODE_PWM1);
+    }
+}
+
+/** \brief Prepare TIM5 CH3 and CH4 as compare units for the triggers
+ *
+ * The encoder uses CH1 and CH2 of TIM5 as inputs, CH3 and CH4 are free and used as output compare
+ * without any pin. CH3 holds the next trigger position above the current position, CH4 the next below.
+ * Hence no matter in which direction the cablecam moves, the interrupt fires the moment the encoder
+ * reaches the next trigger position.
+ *
+ * \return void
+ *
+ */
+void initPosTriggers()
+{
+    TIM5->DIER &= ~(TIM_DIER_CC3IE | TIM_DIER_CC4IE);
+    TIM5->CCMR2 = 0; // CH3 and CH4 are outputs in frozen mode, only the compare flags are used
+    TIM5->SR = ~(TIM_SR_CC3IF | TIM_SR_CC4IF);
+    triggercount = 0;
+    firedcount = 0;
+    skippedcount = 0;
+    lastpos = (int32_t) ENCODER_VALUE;
+}
+
+/** \brief Add a trigger to the list
+ *
+ * The compare units are armed with the triggers above and below the current position only, hence a trigger
+ * added at the current position would never fire while moving away from it. As the cablecam is there, it fires at once.
+ *
+ * \param position int32_t Encoder position the trigger fires at
+ * \param direction int8_t POSTRIGGER_DIR_BOTH, POSTRIGGER_DIR_FORWARD or POSTRIGGER_DIR_REVERSE
+ * \param pulse_width uint16_t Pulse width in us, 1..POSTRIGGER_MAX_PULSE_WIDTH
+ * \param output uint8_t The output to pulse, only SERVO_AUX is supported
+ * \return int8_t 0 if the trigger was added, -1 if the list is full, a value is invalid or the servo outputs do not run at 50Hz
+ *
+ */
+int8_t addPosTrigger(int32_t position, int8_t direction, uint16_t pulse_width, uint8_t output)
+{
+    if (triggercount >= POSTRIGGER_MAX_COUNT ||
+            direction < POSTRIGGER_DIR_REVERSE || direction > POSTRIGGER_DIR_FORWARD ||
+            pulse_width == 0 || pulse_width > POSTRIGGER_MAX_PULSE_WIDTH ||
+            output != SERVO_AUX || getServoProtocol() != SERVO_PROTOCOL_PWM50)
+    {
+        return -1;
+    }
+
+    /*
+     * The interrupt must not see a half sorted list, hence it is disabled while the list is changed.
+     */
+    TIM5->DIER &= ~(TIM_DIER_CC3IE | TIM_DIER_CC4IE);
+
+    if (triggercount == 0)
+    {
+        setAuxTriggerOutput(1);
+    }
+
+    uint8_t i = triggercount;
+    while (i > 0 && triggers[i-1].position > position)
+    {
+        triggers[i] = triggers[i-1];
+        i--;
+    }
+    triggers[i].position = position;
+    triggers[i].direction = direction;
+    triggers[i].pulse_width = pulse_width;
+    triggers[i].output = output;
+    triggercount++;
+
+    lastpos = (int32_t) ENCODER_VALUE;
+    if (position == lastpos)
+    {
+        firePulse(&triggers[i]);
+    }
+    armPosTriggers();
+    return 0;
+}
+
+/** \brief Remove all triggers and turn the aux output back into a servo output
+ *
+ * \return void
+ *
+ */
+void clearPosTriggers()
+{
+    TIM5->DIER &= ~(TIM_DIER_CC3IE | TIM_DIER_CC4IE);
+    if (triggercount != 0)
+    {
+        triggercount = 0;
+        setAuxTriggerOutput(0);
+    }
+}
+
+uint8_t getPosTriggerCount()
+{
+    return triggercount;
+}
+
+const postrigger_t * getPosTrigger(uint8_t index)
+{
+    return &triggers[index];
+}
+
+uint32_t getPosTriggerFiredCount()
+{
+    return firedcount;
+}
+
+uint32_t getPosTriggerSkippedCount()
+{
+    return skippedcount;
+}
+
+/** \brief Load the compare registers with the next trigger positions around lastpos
+ *
+ * \return void
+ *
+ */
+static void armPosTriggers()
+{
+    uint32_t dier = TIM5->DIER & ~(TIM_DIER_CC3IE | TIM_DIER_CC4IE);
+    uint8_t i = 0;
+
+    while (i < triggercount && triggers[i].position <= lastpos)
+    {
+        i++;
+    }
+    /* i is the first trigger above lastpos, i-1 the last trigger at or below */
+    if (i < triggercount)
+    {
+        TIM5->CCR3 = (uint32_t) triggers[i].position;
+        dier |= TIM_DIER_CC3IE;
+    }
+    while (i > 0 && triggers[i-1].position >= lastpos)
+    {
+        i--;
+    }
+    if (i > 0)
+    {
+        TIM5->CCR4 = (uint32_t) triggers[i-1].position;
+        dier |= TIM_DIER_CC4IE;
+    }
+    TIM5->SR = ~(TIM_SR_CC3IF | TIM_SR_CC4IF);
+    TIM5->DIER = dier;
+}
+
+/** \brief Generate the trigger pulse on TIM3 CH4
+ *
+ * The output is forced high right away and the compare unit ends the pulse in hardware. As
+ * TIM3 counts in us with a period of 20ms, the end of the pulse is the current counter plus
+ * the pulse width, wrapped at the period.
+ * While a pulse is still active the CC4 flag is not set yet and the trigger is skipped.
+ *
+ * \param trigger const postrigger_t*
+ * \return void
+ *
+ */
+static void firePulse(const postrigger_t * trigger)
+{
+    if ((TIM3->SR & TIM_SR_CC4IF) == 0 && (TIM3->CCMR2 & TIM_CCMR2_OC4M) == (TIM_OCMODE_INACTIVE << 8))
+    {
+        skippedcount++;
+        return;
+    }
+
+    uint32_t end = TIM3->CNT + trigger->pulse_width;
+    if (end > TIM3->ARR)
+    {
+        end -= TIM3->ARR + 1;
+    }
+    TIM3->CCR4 = end;
+    TIM3->SR = ~TIM_SR_CC4IF;
+    setAuxOutputMode(TIM_OCMODE_FORCED_ACTIVE);
+    setAuxOutputMode(TIM_OCMODE_INACTIVE);
+    firedcount++;
+}
+
+/** \brief Interrupt handler of TIM5, called when the encoder reached a trigger position
+ *
+ * All triggers passed since the last evaluation are considered, hence even if the encoder moved
+ * over multiple triggers before the interrupt got served, none is lost. Of multiple triggers only
+ * one pulse is generated however.
+ *
+ * \return void
+ *
+ */
+void POSTRIGGER_IRQHandler()
+{
+    TIM5->SR = ~(TIM_SR_CC3IF | TIM_SR_CC4IF);
+
+    int32_t pos = (int32_t) ENCODER_VALUE;
+    uint8_t passed = 1;
+    while (passed)
+    {
+        uint8_t i;
+        const postrigger_t * trigger = NULL;
+        if (pos > lastpos)
+        {
+            for (i = 0; i < triggercount && triggers[i].position <= pos; i++)
+            {
+                if (triggers[i].position > lastpos && triggers[i].direction != POSTRIGGER_DIR_REVERSE)
+                {
+                    trigger = &triggers[i];
+                }
+            }
+        }
+        else
+        {
+            for (i = 0; i < triggercount && triggers[i].position < lastpos; i++)
+            {
+                if (triggers[i].position >= pos && triggers[i].direction != POSTRIGGER_DIR_FORWARD)
+                {
+                    trigger = &triggers[i];
+                }
+            }
+        }
+        if (trigger != NULL)
+        {
+            firePulse(trigger);
+        }
+        lastpos = pos;
+        armPosTriggers();
+
+        /*
+         * The encoder might have moved beyond the new compare values while arming them, then
+         * no interrupt would come. So check again.
+         */
+        pos = (int32_t) ENCODER_VALUE;
+        passed = ((TIM5->DIER & TIM_DIER_CC3IE) && pos >= (int32_t) TIM5->CCR3) ||
+                 ((TIM5->DIER & TIM_DIER_CC4IE) && pos <= (int32_t) TIM5->CCR4);
+    }
+}
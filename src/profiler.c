@@ -0,0 +1,125 @@
+#include "profiler.h"
+
+#ifdef PROFILER
+
+#include "string.h"
+
+/*
+ * A probe can be interrupted by an ISR containing another probe. As interrupts nest strictly, the running
+ * probes form a stack. Each frame knows when it started and how many cycles interrupts took meanwhile.
+ */
+typedef struct
+{
+    uint32_t start;
+    uint32_t inner;
+} probeframe_t;
+
+static probeframe_t stack[PROFILER_MAX_NESTING];
+static uint8_t depth = 0;
+
+static probestats_t stats[PROBE_COUNT];
+
+static char * probelabels[PROBE_COUNT] = {"controllercycle",
+                                          "serialCom",
+                                          "SBUS irq",
+                                          "PPM irq",
+                                          "USB irq",
+                                          "position trigger irq"
+                                         };
+
+/** \brief Start the measurement of a probe
+ *
+ * \return void
+ *
+ */
+void profilerEnter()
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (depth < PROFILER_MAX_NESTING)
+    {
+        stack[depth].inner = 0;
+        stack[depth].start = DWT->CYCCNT;
+    }
+    depth++;
+    __set_PRIMASK(primask);
+}
+
+/** \brief End the measurement started by the last profilerEnter() and account it to the probe
+ *
+ * \param probe PROBE_t
+ * \return void
+ *
+ */
+void profilerExit(PROBE_t probe)
+{
+    uint32_t now = DWT->CYCCNT;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    depth--;
+    if (depth < PROFILER_MAX_NESTING)
+    {
+        probeframe_t * frame = &stack[depth];
+        uint32_t cycles = now - frame->start;
+        probestats_t * s = &stats[probe];
+        uint8_t bucket = 31 - __CLZ(cycles | 1);
+
+        if (bucket >= PROFILER_HISTOGRAM_SIZE)
+        {
+            bucket = PROFILER_HISTOGRAM_SIZE - 1;
+        }
+        if (s->count == 0 || cycles < s->min)
+        {
+            s->min = cycles;
+        }
+        if (cycles > s->max)
+        {
+            s->max = cycles;
+        }
+        s->count++;
+        s->sum += cycles;
+        s->sum_exclusive += cycles - frame->inner;
+        if (frame->inner != 0)
+        {
+            s->preempted++;
+        }
+        s->histogram[bucket]++;
+
+        if (depth > 0)
+        {
+            /* the probe below was interrupted by this one */
+            stack[depth-1].inner += cycles;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+void resetProfiler()
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(stats, 0, sizeof(stats));
+    __set_PRIMASK(primask);
+}
+
+/** \brief Get a consistent copy of the statistics of one probe
+ *
+ * \param probe PROBE_t
+ * \param copy probestats_t* Buffer to copy the values into
+ * \return void
+ *
+ */
+void getProbeStats(PROBE_t probe, probestats_t * copy)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memcpy(copy, &stats[probe], sizeof(probestats_t));
+    __set_PRIMASK(primask);
+}
+
+char * getProbeLabel(PROBE_t probe)
+{
+    return probelabels[probe];
+}
+
+#endif
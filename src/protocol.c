@@ -8,9 +8,27 @@
 #include "errno.h"
 #include "serial_print.h"
 #include "controller.h"
+#include "controlplan.h"
 #include "sbus.h"
 #include "eeprom.h"
 #include "usbd_cdc_if.h"
+#include "postrigger.h"
+#include "boottime.h"
+#include "profiler.h"
+#include "scheduler.h"
+#include "job.h"
+#include "simulation.h"
+#include "imu.h"
+#include "shaper.h"
+#include "feedforward.h"
+#include "traction.h"
+#include "servo.h"
+#include "uart.h"
+#include "setpoint.h"
+#include "linkquality.h"
+#include "latency.h"
+#include "autotune.h"
+#include "string.h"
 
 #define COMMAND_START  '$'
 #define COMMAND_ARGUMENTS 'a'
@@ -36,6 +54,8 @@
 #define ERROR_BT_CONFIG_FAILED		 12
 #define ERROR_BT_NOT_FROM_USB		 13
 #define ERROR_INVALID_VALUE 		 14
+#define ERROR_JOB_ACTIVE             15
+#define ERROR_JOB_NOT_CANCELABLE     16
 
 static char * error_string[] = {"other errors",
                                 "max size of argument exceeded",
@@ -51,7 +71,9 @@ static char * error_string[] = {"other errors",
                                 "allowed modes are 0..absolute, 1..braking at endpoints, 2..passthrough",
                                 "configuration of the bluetooth module failed",
                                 "cannot configure serial bluetooth module from its own serial line",
-                                "invalid value for provided argument(s)"
+                                "invalid value for provided argument(s)",
+                                "another command is still running, see $j",
+                                "the running command cannot be cancelled"
                                };
 
 settings_t activesettings;
@@ -61,7 +83,6 @@ controllerstatus_t controllerstatus;
 char commandline[81]; // one extra char for the null termination
 uint8_t commandlinepos = 0;
 
-extern char commandlinebuffer[APP_TX_BUF_SIZE];
 
 extern TIM_HandleTypeDef htim1;
 
@@ -69,6 +90,25 @@ static uint8_t checksum;
 static uint8_t checksum_received;
 static uint8_t checksum_response;
 
+/*
+ * The copy of the settings written by the $w job, so commands changing the activesettings meanwhile do not
+ * interfere with the write and verify.
+ */
+static settings_t settings_save_buffer;
+
+/*
+ * The $z job prints the cycle monitor starting with the oldest sample at the time the command was received
+ */
+static int16_t debugcycles_start;
+
+/*
+ * The tuning rule the $A job applies when the experiment succeeded, -1 to propose the gains only
+ */
+static int8_t autotune_rule = -1;
+
+#define DEBUG_CYCLES_PER_STEP   6       // each line is about 70 chars, stay below JOB_TX_RESERVE
+#define SETTINGS_SECTIONS       10      // printActiveSettingsStep() prints the settings in that many steps
+
 void evaluateCommand(Endpoints endpoint);
 void writeProtocolError(uint8_t, Endpoints endpoint);
 void writeProtocolErrorText(char *, Endpoints endpoint);
@@ -76,7 +116,14 @@ void writeProtocolOK(Endpoints endpoint);
 void writeProtocolInt(int16_t v, Endpoints endpoint);
 void writeProtocolLong(int32_t v, Endpoints endpoint);
 
-void printDebugCycles(Endpoints endpoint);
+static int8_t printActiveSettingsStep(job_t * job);
+static int8_t printDebugCyclesStep(job_t * job);
+static int8_t startSettingsSaveStep(job_t * job);
+static int8_t saveSettingsStep(job_t * job);
+static int8_t identifySwingStep(job_t * job);
+static int8_t calibrateESCStep(job_t * job);
+static int8_t autoTuneStep(job_t * job);
+static void printAutoTuneResult(Endpoints endpoint);
 
 
 uint8_t is_ok(uint8_t *btchar_string, uint8_t * btchar_string_length);
@@ -85,6 +132,123 @@ void initProtocol()
 {
 }
 
+/** \brief The system defaults of all settings, used when the eeprom does not contain valid settings
+ *
+ * \return void
+ *
+ */
+void setDefaultSettings()
+{
+    activesettings.esc_direction = 0;
+    activesettings.D = 0.0f;
+    activesettings.I = 0.0f;
+    activesettings.P = 0.0f;
+    activesettings.max_position_error = 100.0f;
+    activesettings.mode = MODE_PASSTHROUGH;
+    activesettings.pos_end = (double) POS_END_NOT_SET;
+    activesettings.pos_start = (double) -POS_END_NOT_SET;
+    activesettings.rc_channel_endpoint = 6;
+    activesettings.rc_channel_programming = 5;
+    activesettings.rc_channel_speed = 0;
+    activesettings.stick_max_accel = 20;
+    activesettings.stick_max_accel_safemode = 10;
+    activesettings.stick_max_speed = 500;
+    activesettings.stick_max_speed_safemode = 100;
+    activesettings.stick_neutral_pos = 992;
+    activesettings.stick_neutral_range = 30;
+    strcpy(activesettings.version, "20170830");
+    activesettings.stick_speed_factor = 0.01f;
+    activesettings.receivertype = RECEIVER_TYPE_SUMPPM;
+
+    // 20170815
+    activesettings.esc_neutral_pos = 1500;
+    activesettings.esc_neutral_range = 30;
+
+    // 20170817
+    activesettings.rc_channel_max_accel = 255;
+    activesettings.rc_channel_max_speed = 255;
+
+    // 20170820
+    activesettings.hall_steps_per_meter = 100.0f;
+
+    // 20170822
+    activesettings.shaper_type = SHAPER_OFF;
+    activesettings.shaper_frequency = 0.5f;
+    activesettings.shaper_damping = 0.0f;
+
+    // 20170823
+    activesettings.esc_table_active = 0;
+    activesettings.esc_table_range = 0;
+
+    // 20170824
+    activesettings.feedforward_active = 0;
+
+    // 20170825
+    activesettings.traction_slip_threshold = 0.0f;
+
+    // 20170826
+    activesettings.zone_count = 0;
+    activesettings.rc_channel_zone = 255;
+
+    // 20170827
+    activesettings.stick_curve[0].type = STICKCURVE_LINEAR;
+    activesettings.stick_curve[0].expo = 0.0f;
+    activesettings.stick_curve[1] = activesettings.stick_curve[0];
+    activesettings.stick_curve_range = STICKCURVE_DEFAULT_RANGE;
+
+    // 20170828
+    activesettings.tracking_active = 0;
+    activesettings.tracking_target = 0;
+    activesettings.tracking_distance = 0.0f;
+    activesettings.tracking_us_per_degree = TRACKING_DEFAULT_US_PER_DEGREE;
+    activesettings.tracking_max_rate = TRACKING_DEFAULT_MAX_RATE;
+    activesettings.rc_channel_yaw = 255;
+
+    // 20170829
+    setDefaultServoOutputs();
+
+    // 20170830
+    activesettings.gain_count[0] = 0;
+    activesettings.gain_count[1] = 0;
+}
+
+/** \brief Set the servo outputs to the standard 50Hz servo signal within SERVO_MIN..SERVO_MAX and no failsafe
+ *
+ * Without failsafe the ESC keeps being driven by the controller, which brakes the cablecam when the RC signal is lost.
+ * The ESC channel is limited to its neutral point plus/minus the neutral range and the full scale instead, else the
+ * full stick and the ESC calibration would be cut off.
+ *
+ * \return void
+ *
+ */
+void setDefaultServoOutputs()
+{
+    uint8_t i;
+    activesettings.servo_protocol = SERVO_PROTOCOL_PWM50;
+    for (i = 0; i < SERVO_CHANNELS; i++)
+    {
+        activesettings.servo_outputs[i].min = SERVO_MIN;
+        activesettings.servo_outputs[i].max = SERVO_MAX;
+        activesettings.servo_outputs[i].failsafe_mode = SERVO_FAILSAFE_NONE;
+        activesettings.servo_outputs[i].failsafe = SERVO_CENTER;
+    }
+    setDefaultESCOutputLimits();
+    activesettings.servo_outputs[SERVO_ESC].failsafe = activesettings.esc_neutral_pos;
+}
+
+/** \brief Derive the ESC channel limits from the ESC neutral point and range of $N
+ *
+ * \return void
+ *
+ */
+void setDefaultESCOutputLimits()
+{
+    int32_t range = activesettings.esc_neutral_range + ESC_FULL_SCALE;
+    int32_t min = activesettings.esc_neutral_pos - range;
+    activesettings.servo_outputs[SERVO_ESC].min = (min < 1) ? 1 : min;
+    activesettings.servo_outputs[SERVO_ESC].max = activesettings.esc_neutral_pos + range;
+}
+
 void writeProtocolError(uint8_t e, Endpoints endpoint)
 {
     PrintSerial_string("$ERROR: ", endpoint);
@@ -174,14 +338,14 @@ void writeProtocolLong(int32_t v, Endpoints endpoint)
 
 uint8_t c_state = COMMAND_IDLE;
 
-void serialCom(Endpoints endpoint)
+void serialCom(char * line, Endpoints endpoint)
 {
     char c;
     uint16_t pos = 0;
 
     while (pos < RXBUFFERSIZE)
     {
-        c = commandlinebuffer[pos++];
+        c = line[pos++];
 
         if (c == 0)
         {
@@ -391,6 +555,57 @@ void evaluateCommand(Endpoints endpoint)
         }
         break;
     }
+    case PROTOCOL_AUTOTUNE:
+    {
+        int16_t p[2];
+        int32_t pos = (int32_t) ENCODER_VALUE;
+        const controlplan_t * plan = getControlPlan();
+        argument_index = sscanf(commandline, "%c %hd %hd", &command, &p[0], &p[1]);
+        if (argument_index == 1)
+        {
+            writeProtocolHead(PROTOCOL_AUTOTUNE, endpoint);
+            printAutoTuneResult(endpoint);
+            writeProtocolOK(endpoint);
+        }
+        else if (argument_index != 2 && argument_index != 3)
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        else if (p[0] <= 0 || p[0] > AUTOTUNE_MAX_AMPLITUDE || (argument_index == 3 && (p[1] < 0 || p[1] >= AUTOTUNE_RULES)) ||
+                 activesettings.pos_end == (double) POS_END_NOT_SET || activesettings.pos_start == (double) -POS_END_NOT_SET ||
+                 pos <= plan->pos_start || pos >= plan->pos_end ||
+                 getStick() != 0 || getServoOutput(SERVO_ESC) != activesettings.esc_neutral_pos ||
+                 getDuty(activesettings.rc_channel_speed) == 0)
+        {
+            writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+        }
+        else if (getJob()->active)
+        {
+            writeProtocolError(ERROR_JOB_ACTIVE, endpoint);
+        }
+        else
+        {
+            /*
+             * The cablecam may oscillate within the max position error around its current position, but never past the end points.
+             * The experiment stops as soon as the cablecam could not brake within these limits anymore, with the max accel.
+             */
+            int32_t min_pos = pos - (int32_t) plan->max_position_error;
+            int32_t max_pos = pos + (int32_t) plan->max_position_error;
+            double brake = ((double) plan->limits[controllerstatus.safemode != OPERATIONAL].max_accel) * plan->stick_speed_factor;
+            if (min_pos < plan->pos_start)
+            {
+                min_pos = (int32_t) plan->pos_start;
+            }
+            if (max_pos > plan->pos_end)
+            {
+                max_pos = (int32_t) plan->pos_end;
+            }
+            autotune_rule = (argument_index == 3) ? p[1] : -1;
+            startAutoTune((activesettings.esc_scale > 1) ? p[0] * activesettings.esc_scale : p[0], pos, min_pos, max_pos, brake);
+            startJob("pid auto-tune", autoTuneStep, AUTOTUNE_SETTLE_PERIODS + AUTOTUNE_MEASURE_PERIODS, 1, endpoint);
+        }
+        break;
+    }
     case PROTOCOL_MAX_ACCEL:
     {
         int16_t p[2];
@@ -401,6 +616,7 @@ void evaluateCommand(Endpoints endpoint)
             {
                 activesettings.stick_max_accel = p[0];
                 activesettings.stick_max_accel_safemode = p[1];
+                requestControlPlan();
                 writeProtocolHead(PROTOCOL_MAX_ACCEL, endpoint);
                 writeProtocolOK(endpoint);
             }
@@ -431,6 +647,7 @@ void evaluateCommand(Endpoints endpoint)
             if (d > 0.0f)
             {
                 activesettings.max_position_error = d;
+                requestControlPlan();
                 writeProtocolHead(PROTOCOL_MAX_ERROR_DIST, endpoint);
                 writeProtocolOK(endpoint);
             }
@@ -454,6 +671,7 @@ void evaluateCommand(Endpoints endpoint)
         if (argument_index == 2)
         {
             activesettings.stick_speed_factor = d;
+            requestControlPlan();
             writeProtocolHead(PROTOCOL_SPEED_FACTOR, endpoint);
             writeProtocolOK(endpoint);
         }
@@ -475,6 +693,10 @@ void evaluateCommand(Endpoints endpoint)
         {
             writeProtocolLong(getTargetPos(), endpoint);
         }
+        if (controllerstatus.position_degraded)
+        {
+            writeProtocolText("degraded by wheel slip, see $k", endpoint);
+        }
         writeProtocolOK(endpoint);
         break;
     case PROTOCOL_MAX_SPEED:
@@ -488,6 +710,7 @@ void evaluateCommand(Endpoints endpoint)
             {
                 activesettings.stick_max_speed = p[0];
                 activesettings.stick_max_speed_safemode = p[1];
+                requestControlPlan();
                 writeProtocolHead(PROTOCOL_MAX_SPEED, endpoint);
                 writeProtocolOK(endpoint);
             }
@@ -511,17 +734,8 @@ void evaluateCommand(Endpoints endpoint)
     }
     case PROTOCOL_EEPROM_WRITE:
     {
-        uint32_t write_errors = eeprom_write_sector_safe((uint8_t*) &activesettings, sizeof(activesettings), EEPROM_SECTOR_FOR_SETTINGS);
-        writeProtocolHead(PROTOCOL_EEPROM_WRITE, endpoint);
-        if (write_errors == 0)
-        {
-            writeProtocolText("\r\nSettings saved successfully", endpoint);
-            writeProtocolOK(endpoint);
-        }
-        else
-        {
-            writeProtocolError(ERROR_EEPROM_SAVE, endpoint);
-        }
+        /* Erasing and writing the flash takes long, hence it is done by the storage task */
+        requestSettingsSave(endpoint);
         break;
     }
     case PROTOCOL_INPUT_CHANNELS:
@@ -529,8 +743,8 @@ void evaluateCommand(Endpoints endpoint)
         /*
          * Note, the protocol does remap channel1 to chan0
          */
-        int16_t p[5];
-        argument_index = sscanf(commandline, "%c %hd %hd %hd %hd %hd", &command, &p[0], &p[1], &p[2], &p[3], &p[4]);
+        int16_t p[7];
+        argument_index = sscanf(commandline, "%c %hd %hd %hd %hd %hd %hd %hd", &command, &p[0], &p[1], &p[2], &p[3], &p[4], &p[5], &p[6]);
 
         if (argument_index >= 4)
         {
@@ -570,6 +784,30 @@ void evaluateCommand(Endpoints endpoint)
                         activesettings.rc_channel_max_speed = 255; // not used
                     }
                 }
+                if (argument_index >= 7)
+                {
+                    if (p[5] > 0 && p[5] <= SBUS_MAX_CHANNEL)
+                    {
+                        activesettings.rc_channel_zone = p[5]-1;
+                        writeProtocolInt(activesettings.rc_channel_zone+1, endpoint);
+                    }
+                    else
+                    {
+                        activesettings.rc_channel_zone = 255; // not used
+                    }
+                }
+                if (argument_index >= 8)
+                {
+                    if (p[6] > 0 && p[6] <= SBUS_MAX_CHANNEL)
+                    {
+                        activesettings.rc_channel_yaw = p[6]-1;
+                        writeProtocolInt(activesettings.rc_channel_yaw+1, endpoint);
+                    }
+                    else
+                    {
+                        activesettings.rc_channel_yaw = 255; // not used
+                    }
+                }
                 writeProtocolOK(endpoint);
             }
             else
@@ -585,6 +823,8 @@ void evaluateCommand(Endpoints endpoint)
             writeProtocolInt(activesettings.rc_channel_endpoint+1, endpoint);
             writeProtocolInt(activesettings.rc_channel_max_accel+1, endpoint);
             writeProtocolInt(activesettings.rc_channel_max_speed+1, endpoint);
+            writeProtocolInt(activesettings.rc_channel_zone+1, endpoint);
+            writeProtocolInt(activesettings.rc_channel_yaw+1, endpoint);
             writeProtocolText("\r\n", endpoint);
 
             int i = 0;
@@ -614,6 +854,14 @@ void evaluateCommand(Endpoints endpoint)
                 {
                     writeProtocolText(" (used as max speed selector)", endpoint);
                 }
+                else if (i == activesettings.rc_channel_zone)
+                {
+                    writeProtocolText(" (used as speed zone switch)", endpoint);
+                }
+                else if (i == activesettings.rc_channel_yaw)
+                {
+                    writeProtocolText(" (used as yaw override)", endpoint);
+                }
                 writeProtocolText("\r\n", endpoint);
             }
             writeProtocolText("current ESC out signal Servo 1 = ", endpoint);
@@ -639,6 +887,7 @@ void evaluateCommand(Endpoints endpoint)
                 writeProtocolHead(PROTOCOL_NEUTRAL, endpoint);
                 activesettings.stick_neutral_pos = p[0];
                 activesettings.stick_neutral_range = p[1];
+                requestControlPlan();
                 writeProtocolOK(endpoint);
             }
             else
@@ -668,9 +917,32 @@ void evaluateCommand(Endpoints endpoint)
             if (p[0] > 500 && p[0] < 2000 &&
                     p[1] > 0 && p[1] < 100)
             {
+                /*
+                 * ESC limits and failsafe value still derived from the old neutral point move with it, values set via $O are kept
+                 */
+                servooutput_t * output = &activesettings.servo_outputs[SERVO_ESC];
+                uint16_t min = output->min;
+                uint16_t max = output->max;
+                uint8_t derived;
+                setDefaultESCOutputLimits();
+                derived = (output->min == min && output->max == max);
+                if (output->failsafe == activesettings.esc_neutral_pos)
+                {
+                    output->failsafe = p[0];
+                }
                 writeProtocolHead(PROTOCOL_ESC_NEUTRAL, endpoint);
                 activesettings.esc_neutral_pos = p[0];
                 activesettings.esc_neutral_range = p[1];
+                if (derived)
+                {
+                    setDefaultESCOutputLimits();
+                }
+                else
+                {
+                    output->min = min;
+                    output->max = max;
+                }
+                requestControlPlan();
                 writeProtocolOK(endpoint);
             }
             else
@@ -701,6 +973,7 @@ void evaluateCommand(Endpoints endpoint)
             {
                 writeProtocolHead(PROTOCOL_ROTATION_DIR, endpoint);
                 activesettings.esc_direction = p;
+                requestControlPlan();
                 writeProtocolOK(endpoint);
             }
             else
@@ -753,7 +1026,7 @@ void evaluateCommand(Endpoints endpoint)
             }
             writeProtocolText("\r\nStoring all settings to eeprom\r\nReboot device to make the new receiver type active.\r\n", endpoint);
             writeProtocolOK(endpoint);
-            evaluateCommand(PROTOCOL_EEPROM_WRITE);
+            requestSettingsSave(endpoint);
         }
         break;
     }
@@ -772,6 +1045,7 @@ void evaluateCommand(Endpoints endpoint)
                 activesettings.mode = p;
                 resetThrottle();
                 resetPosTarget();
+                requestControlPlan();
                 writeProtocolOK(endpoint);
             }
             else
@@ -791,269 +1065,1602 @@ void evaluateCommand(Endpoints endpoint)
     }
     case PROTOCOL_SETTINGS:
     {
-        writeProtocolHead(PROTOCOL_SETTINGS, endpoint);
-        writeProtocolOK(endpoint);
-        printActiveSettings(endpoint);
+        if (startJob("settings", printActiveSettingsStep, SETTINGS_SECTIONS, 1, endpoint) == 0)
+        {
+            writeProtocolHead(PROTOCOL_SETTINGS, endpoint);
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_JOB_ACTIVE, endpoint);
+        }
         break;
     }
     case PROTOCOL_D_CYCLES:
     {
-        printDebugCycles(endpoint);
-        break;
-    }
-    default:  // we do not know how to handle the (valid) message, indicate error MSP $M!
-        writeProtocolError(ERROR_UNKNOWN_COMMAND, endpoint);
+        debugcycles_start = controllerstatus.cyclemonitor_position;
+        if (startJob("debug cycles", printDebugCyclesStep, CYCLEMONITOR_SAMPLE_COUNT, 1, endpoint) != 0)
+        {
+            writeProtocolError(ERROR_JOB_ACTIVE, endpoint);
+        }
         break;
     }
-}
-
-void printHelp(Endpoints endpoint)
-{
-    PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
-
-    PrintlnSerial_string(controllerstatus.boottext_eeprom, endpoint);
-
-    PrintSerial_string("Current Mode: ", endpoint);
-    PrintlnSerial_string(getCurrentModeLabel(activesettings.mode), endpoint);
-
-    PrintSerial_string("Current Receiver type: ", endpoint);
-    if (activesettings.receivertype == RECEIVER_TYPE_SUMPPM)
-    {
-        PrintlnSerial_string("Sum-PPM", endpoint);
-    }
-    else
-    {
-        PrintlnSerial_string("SBus", endpoint);
-    }
-
-    PrintSerial_string("Current CableCam operation mode: ", endpoint);
-    PrintSerial_string(getSafeModeLabel(), endpoint);
-
-    PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
-    PrintlnSerial_string("Possible commands are", endpoint);
-    PrintlnSerial(endpoint);
-
-    PrintlnSerial_string("$a [<int> <int>]                        set or print maximum allowed acceleration in normal and programming mode", endpoint);
-    PrintlnSerial_string("$g [<double>]                           set or print the max positional error -> exceeding it causes an emergency stop", endpoint);
-    PrintlnSerial_string("$i [[[<int> <int> <int>] <int>] <int>]  set or print input channels for Speed, Programming Switch, Endpoint Switch, Max Accel, Max Speed", endpoint);
-    PrintlnSerial_string("$I [<int>]                              set or print input source 0..SumPPM", endpoint);
-    PrintlnSerial_string("                                                                  1..SBus", endpoint);
-    PrintlnSerial_string("$m [<int>]                              set or print the mode 0..positional", endpoint);
-    PrintlnSerial_string("                                                              1..passthrough", endpoint);
-    PrintlnSerial_string("                                                              2..passthrough with speed limits", endpoint);
-    PrintlnSerial_string("                                                              3..passthough with speed limits & end points", endpoint);
-    PrintlnSerial_string("$n [<int> <int>]                        set or print receiver neutral pos and +-range", endpoint);
-    PrintlnSerial_string("$N [<int> <int>]                        set or print ESC output neutral pos and +-range", endpoint);
-    PrintlnSerial_string("$p                                      print positions", endpoint);
-    PrintlnSerial_string("$r [<int>]                              set or print rotation direction of the ESC output, either +1 or -1", endpoint);
-    PrintlnSerial_string("$S                                      print all settings", endpoint);
-    PrintlnSerial_string("$v [<int> <int>]                        set or print maximum allowed speed in normal and programming mode", endpoint);
-    PrintlnSerial_string("$w                                      write settings to eeprom", endpoint);
-
-    PrintlnSerial(endpoint);
-    PrintlnSerial_string("$1 [<double>]                           set or print Kp for PID controller", endpoint);
-    PrintlnSerial_string("$2 [<double>]                           set or print Ki for PID controller", endpoint);
-    PrintlnSerial_string("$3 [<double>]                           set or print Kd for PID controller", endpoint);
-    PrintlnSerial_string("$c [<double> <double> <double>]         set or print all three PID values", endpoint);
-    PrintlnSerial_string("$f [<double>]                           set or print stick-to-hall-speed factor", endpoint);
-    PrintlnSerial(endpoint);
-}
-
-void printActiveSettings(Endpoints endpoint)
-{
-    PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
-    PrintlnSerial_string("Active settings", endpoint);
-    PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
-
-    PrintSerial_string("Version of the stored settings: ", endpoint);
-    PrintlnSerial_string(activesettings.version, endpoint);
-    PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
-
-    PrintSerial_string("Controller status: ", endpoint);
-    switch (controllerstatus.monitor)
+    case PROTOCOL_SIMULATION:
     {
-    case EMERGENCYBRAKE:
-        PrintlnSerial_string("Emergency brake on", endpoint);
-        break;
-    case FREE:
-        PrintlnSerial_string("Free running", endpoint);
-        break;
-    case ENDPOINTBRAKE:
-        PrintlnSerial_string("Endpoint brake on", endpoint);
+        double p[6];
+        plantparams_t * params = getSimulationParams();
+        argument_index = sscanf(commandline, "%c %lf %lf %lf %lf %lf %lf", &command, &p[0], &p[1], &p[2], &p[3], &p[4], &p[5]);
+        if (argument_index == 7)
+        {
+            if (!isSimulationActive() && p[0] > 0.0f && p[3] >= 0.0f && p[4] >= 0.0f && p[5] > 0.0f)
+            {
+                params->mass = (float) p[0];
+                params->slope = (float) p[1];
+                params->slope_gradient = (float) p[2];
+                params->max_thrust = (float) p[3];
+                params->esc_lag = (float) p[4];
+                params->steps_per_meter = (float) p[5];
+                writeProtocolHead(PROTOCOL_SIMULATION, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 2 && (p[0] == 0.0f || p[0] == 1.0f))
+        {
+            if (setSimulation((uint8_t) p[0]) == 0)
+            {
+                writeProtocolHead(PROTOCOL_SIMULATION, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 1)
+        {
+            const plantstate_t * state = getSimulationState();
+            writeProtocolHead(PROTOCOL_SIMULATION, endpoint);
+            writeProtocolInt(isSimulationActive(), endpoint);
+            writeProtocolDouble(params->mass, endpoint);
+            writeProtocolDouble(params->slope, endpoint);
+            writeProtocolDouble(params->slope_gradient, endpoint);
+            writeProtocolDouble(params->max_thrust, endpoint);
+            writeProtocolDouble(params->esc_lag, endpoint);
+            writeProtocolDouble(params->steps_per_meter, endpoint);
+            if (isSimulationActive())
+            {
+                writeProtocolText("\r\nposition speed thrust counter", endpoint);
+                writeProtocolDouble(state->position, endpoint);
+                writeProtocolDouble(state->speed, endpoint);
+                writeProtocolDouble(state->thrust, endpoint);
+                writeProtocolLong(state->counter, endpoint);
+            }
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
         break;
     }
-    PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
-
-    PrintlnSerial_string("Currently the endpoint limits are configured as ", endpoint);
-    int32_t pos = ENCODER_VALUE;
-
-    if (activesettings.pos_start > activesettings.pos_end)
+    case PROTOCOL_IMU:
     {
-        /* start is always smaller than end anyway but below prints rely on that, hence doublecheck. */
-        int32_t tmp = activesettings.pos_start;
-        activesettings.pos_start = activesettings.pos_end;
-        activesettings.pos_end = tmp;
+        double p;
+        argument_index = sscanf(commandline, "%c %lf", &command, &p);
+        if (argument_index == 2)
+        {
+            if (p > 0.0f)
+            {
+                activesettings.hall_steps_per_meter = p;
+                requestControlPlan();
+                writeProtocolHead(PROTOCOL_IMU, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 1)
+        {
+            const imustate_t * imu = getIMUState();
+            writeProtocolHead(PROTOCOL_IMU, endpoint);
+            writeProtocolDouble(activesettings.hall_steps_per_meter, endpoint);
+            if (imu->present)
+            {
+                writeProtocolText("\r\nsamples overflows", endpoint);
+                writeProtocolLong(imu->samples, endpoint);
+                writeProtocolLong(imu->overflows, endpoint);
+                writeProtocolText("\r\naccel m/s2", endpoint);
+                writeProtocolDouble(imu->accel[0], endpoint);
+                writeProtocolDouble(imu->accel[1], endpoint);
+                writeProtocolDouble(imu->accel[2], endpoint);
+                writeProtocolText("\r\ngyro rad/s", endpoint);
+                writeProtocolDouble(imu->gyro[0], endpoint);
+                writeProtocolDouble(imu->gyro[1], endpoint);
+                writeProtocolDouble(imu->gyro[2], endpoint);
+                writeProtocolText("\r\npitch roll deg, swing rad/s", endpoint);
+                writeProtocolDouble(imu->pitch * 57.2958f, endpoint);
+                writeProtocolDouble(imu->roll * 57.2958f, endpoint);
+                writeProtocolDouble(imu->roll_rate, endpoint);
+                writeProtocolText("\r\nrope accel m/s2, position, velocity steps/s, slip m/s2", endpoint);
+                writeProtocolDouble(imu->accel_rope, endpoint);
+                writeProtocolDouble(imu->position, endpoint);
+                writeProtocolDouble(imu->velocity, endpoint);
+                writeProtocolDouble(imu->slip, endpoint);
+            }
+            else
+            {
+                writeProtocolText("\r\nno MPU6000 found", endpoint);
+            }
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        break;
     }
-
-    PrintSerial_string(" ", endpoint);
-    if (pos < activesettings.pos_start)
+    case PROTOCOL_ESC_TABLE:
     {
-        PrintSerial_long(pos, endpoint);
-        PrintSerial_string("--- ", endpoint);
+        int16_t p;
+        argument_index = sscanf(commandline, "%c %hd", &command, &p);
+        if (argument_index == 2)
+        {
+            if (p == 0 || (p == 1 && activesettings.esc_table_range > 0))
+            {
+                activesettings.esc_table_active = (uint8_t) p;
+                requestControlPlan();
+                writeProtocolHead(PROTOCOL_ESC_TABLE, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 1)
+        {
+            uint8_t direction, i;
+            writeProtocolHead(PROTOCOL_ESC_TABLE, endpoint);
+            writeProtocolInt(activesettings.esc_table_active, endpoint);
+            writeProtocolInt(activesettings.esc_table_range, endpoint);
+            for (direction = ESC_TABLE_FORWARD; direction <= ESC_TABLE_REVERSE; direction++)
+            {
+                writeProtocolText((direction == ESC_TABLE_FORWARD) ? "\r\nforward us" : "\r\nreverse us", endpoint);
+                for (i = 0; i < ESC_TABLE_POINTS; i++)
+                {
+                    writeProtocolInt(activesettings.esc_table[direction][i], endpoint);
+                }
+            }
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        break;
     }
-    PrintSerial_long((int32_t) activesettings.pos_start, endpoint);
-    PrintSerial_string(" <--------- ", endpoint);
-    if (activesettings.pos_start <= pos && pos <= activesettings.pos_end)
+    case PROTOCOL_ESC_CALIBRATION:
     {
-        PrintSerial_long(pos, endpoint);
+        int16_t p;
+        argument_index = sscanf(commandline, "%c %hd", &command, &p);
+        if (argument_index != 2)
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        else if (p <= activesettings.esc_neutral_range || p > ESC_CAL_MAX_RANGE || getStick() != 0 ||
+                 TIM3->CCR3 != activesettings.esc_neutral_pos ||
+                 activesettings.esc_neutral_pos + p > activesettings.servo_outputs[SERVO_ESC].max ||
+                 activesettings.esc_neutral_pos - p < activesettings.servo_outputs[SERVO_ESC].min)
+        {
+            writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+        }
+        else if (getJob()->active)
+        {
+            writeProtocolError(ERROR_JOB_ACTIVE, endpoint);
+        }
+        else
+        {
+            /*
+             * With the wheel off the rope the Hall sensor position is meaningless. In OPERATIONAL mode the wheel might be
+             * on the rope nevertheless, so the cablecam has to stop within the end points then, braking with the max accel.
+             */
+            const controlplan_t * plan = getControlPlan();
+            int32_t min_pos = INT32_MIN;
+            int32_t max_pos = INT32_MAX;
+            if (controllerstatus.safemode == OPERATIONAL)
+            {
+                min_pos = (int32_t) plan->pos_start;
+                max_pos = (int32_t) plan->pos_end;
+            }
+            startESCCalibration(p, min_pos, max_pos, ((double) plan->limits[0].max_accel) * plan->stick_speed_factor);
+            startJob("esc calibration", calibrateESCStep, 2 * ESC_CAL_STEPS, 1, endpoint);
+        }
+        break;
     }
-    PrintSerial_string(" ---------> ", endpoint);
-    PrintSerial_long((int32_t) activesettings.pos_end, endpoint);
-    if (pos > activesettings.pos_end)
+    case PROTOCOL_FEEDFORWARD:
     {
-        PrintSerial_string("--- ", endpoint);
-        PrintSerial_long(pos, endpoint);
-    }
-    PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
-
+        int16_t p;
+        argument_index = sscanf(commandline, "%c %hd", &command, &p);
+        if (argument_index == 2)
+        {
+            if (p == 0 || p == 1)
+            {
+                activesettings.feedforward_active = (uint8_t) p;
+                requestControlPlan();
+                writeProtocolHead(PROTOCOL_FEEDFORWARD, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else if (p == 2)
+            {
+                clearFeedForward();
+                writeProtocolHead(PROTOCOL_FEEDFORWARD, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 1)
+        {
+            uint8_t direction, i;
+            writeProtocolHead(PROTOCOL_FEEDFORWARD, endpoint);
+            writeProtocolInt(activesettings.feedforward_active, endpoint);
+            for (direction = FEEDFORWARD_FORWARD; direction <= FEEDFORWARD_REVERSE; direction++)
+            {
+                const float * map = getFeedForwardMap(direction);
+                writeProtocolText((direction == FEEDFORWARD_FORWARD) ? "\r\nforward" : "\r\nreverse", endpoint);
+                for (i = 0; i < FEEDFORWARD_BINS; i++)
+                {
+                    writeProtocolInt((int16_t) map[i], endpoint);
+                }
+            }
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        break;
+    }
+    case PROTOCOL_TRACTION:
+    {
+        double p;
+        argument_index = sscanf(commandline, "%c %lf", &command, &p);
+        if (argument_index == 2)
+        {
+            if (p >= 0.0f)
+            {
+                activesettings.traction_slip_threshold = p;
+                writeProtocolHead(PROTOCOL_TRACTION, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 1)
+        {
+            const tractionstate_t * traction = getTractionState();
+            uint8_t i;
+            writeProtocolHead(PROTOCOL_TRACTION, endpoint);
+            writeProtocolDouble(activesettings.traction_slip_threshold, endpoint);
+            writeProtocolText("\r\nslip m/s2, accel limit %, events, position degraded", endpoint);
+            writeProtocolDouble(traction->slip, endpoint);
+            writeProtocolInt((int16_t) (traction->scale * 100.0f), endpoint);
+            writeProtocolLong(traction->events, endpoint);
+            writeProtocolInt(controllerstatus.position_degraded, endpoint);
+            writeProtocolText("\r\n", endpoint);
+            for (i = 0; i < TRACTION_LOG_SIZE; i++)
+            {
+                /* oldest first */
+                const slipevent_t * event = &traction->log[(traction->log_position + i) % TRACTION_LOG_SIZE];
+                if (event->tick != 0)
+                {
+                    writeProtocolText("tick", endpoint);
+                    writeProtocolLong(event->tick, endpoint);
+                    writeProtocolText("pos", endpoint);
+                    writeProtocolLong(event->pos, endpoint);
+                    writeProtocolText("slip", endpoint);
+                    writeProtocolDouble(event->slip, endpoint);
+                    writeProtocolText("\r\n", endpoint);
+                }
+            }
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        break;
+    }
+    case PROTOCOL_TRACTION_CLEAR:
+    {
+        clearTraction();
+        writeProtocolHead(PROTOCOL_TRACTION_CLEAR, endpoint);
+        writeProtocolOK(endpoint);
+        break;
+    }
+    case PROTOCOL_SPEED_ZONES:
+    {
+        int32_t pos;
+        int16_t p[2];
+        argument_index = sscanf(commandline, "%c %ld %hd %hd", &command, &pos, &p[0], &p[1]);
+        if (argument_index == 4)
+        {
+            if (p[0] > 0 && p[1] > 0 && addSpeedZone(pos, p[0], p[1]) == 0)
+            {
+                requestControlPlan();
+                writeProtocolHead(PROTOCOL_SPEED_ZONES, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 2 && pos == 0)
+        {
+            clearSpeedZones();
+            requestControlPlan();
+            writeProtocolHead(PROTOCOL_SPEED_ZONES, endpoint);
+            writeProtocolOK(endpoint);
+        }
+        else if (argument_index == 1)
+        {
+            uint8_t i;
+            writeProtocolHead(PROTOCOL_SPEED_ZONES, endpoint);
+            writeProtocolText("\r\n", endpoint);
+            for (i = 0; i < activesettings.zone_count; i++)
+            {
+                writeProtocolText("position", endpoint);
+                writeProtocolLong(activesettings.zones[i].pos, endpoint);
+                writeProtocolText("max speed", endpoint);
+                writeProtocolInt(activesettings.zones[i].max_speed, endpoint);
+                writeProtocolText("max accel", endpoint);
+                writeProtocolInt(activesettings.zones[i].max_accel, endpoint);
+                writeProtocolText("\r\n", endpoint);
+            }
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        break;
+    }
+    case PROTOCOL_GAIN_SCHEDULE:
+    {
+        int16_t direction;
+        int32_t speed;
+        double g[3];
+        argument_index = sscanf(commandline, "%c %hd %ld %lf %lf %lf", &command, &direction, &speed, &g[0], &g[1], &g[2]);
+        if (argument_index == 6)
+        {
+            if ((direction == FEEDFORWARD_FORWARD || direction == FEEDFORWARD_REVERSE) && speed >= 0 &&
+                g[0] >= 0.0 && g[1] >= 0.0 && g[2] >= 0.0 &&
+                addGainPoint(direction, speed, (float) g[0], (float) g[1], (float) g[2]) == 0)
+            {
+                requestControlPlan();
+                writeProtocolHead(PROTOCOL_GAIN_SCHEDULE, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 2)
+        {
+            if (direction == FEEDFORWARD_FORWARD || direction == FEEDFORWARD_REVERSE)
+            {
+                clearGainSchedule(direction);
+                requestControlPlan();
+                writeProtocolHead(PROTOCOL_GAIN_SCHEDULE, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 1)
+        {
+            uint8_t d;
+            uint8_t i;
+            writeProtocolHead(PROTOCOL_GAIN_SCHEDULE, endpoint);
+            writeProtocolText("\r\n", endpoint);
+            for (d = 0; d < 2; d++)
+            {
+                for (i = 0; i < activesettings.gain_count[d]; i++)
+                {
+                    const gainpoint_t * point = &activesettings.gain_schedule[d][i];
+                    writeProtocolText((d == FEEDFORWARD_FORWARD) ? "forward" : "reverse", endpoint);
+                    writeProtocolText("speed", endpoint);
+                    writeProtocolLong(point->speed, endpoint);
+                    writeProtocolText("P", endpoint);
+                    writeProtocolDouble(point->p, endpoint);
+                    writeProtocolText("I", endpoint);
+                    writeProtocolDouble(point->i, endpoint);
+                    writeProtocolText("D", endpoint);
+                    writeProtocolDouble(point->d, endpoint);
+                    writeProtocolText("\r\n", endpoint);
+                }
+            }
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        break;
+    }
+    case PROTOCOL_SERVO_OUTPUT:
+    {
+        int16_t p[5];
+        argument_index = sscanf(commandline, "%c %hd %hd %hd %hd %hd", &command, &p[0], &p[1], &p[2], &p[3], &p[4]);
+        if (argument_index == 2)
+        {
+            /* the position triggers need the 20ms period */
+            if (p[0] >= SERVO_PROTOCOL_PWM50 && p[0] <= SERVO_PROTOCOL_ONESHOT125 &&
+                (p[0] == SERVO_PROTOCOL_PWM50 || getPosTriggerCount() == 0))
+            {
+                activesettings.servo_protocol = p[0];
+                setServoProtocol(p[0]);
+                requestControlPlan();
+                writeProtocolHead(PROTOCOL_SERVO_OUTPUT, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 5 || argument_index == 6)
+        {
+            if (argument_index < 6)
+            {
+                p[4] = (p[0] >= 0 && p[0] < SERVO_CHANNELS) ? activesettings.servo_outputs[p[0]].failsafe : 0;
+            }
+            if (p[0] >= 0 && p[0] < SERVO_CHANNELS && p[1] > 0 && p[1] < p[2] &&
+                p[3] >= SERVO_FAILSAFE_NONE && p[3] <= SERVO_FAILSAFE_OFF && p[4] >= p[1] && p[4] <= p[2])
+            {
+                servooutput_t * output = &activesettings.servo_outputs[p[0]];
+                output->min = p[1];
+                output->max = p[2];
+                output->failsafe_mode = p[3];
+                output->failsafe = p[4];
+                requestControlPlan();
+                writeProtocolHead(PROTOCOL_SERVO_OUTPUT, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 1)
+        {
+            uint8_t i;
+            writeProtocolHead(PROTOCOL_SERVO_OUTPUT, endpoint);
+            writeProtocolText(getServoProtocolLabel(activesettings.servo_protocol), endpoint);
+            writeProtocolText("\r\nchannel, min, max, failsafe mode, failsafe, current\r\n", endpoint);
+            for (i = 0; i < SERVO_CHANNELS; i++)
+            {
+                const servooutput_t * output = &activesettings.servo_outputs[i];
+                writeProtocolInt(i, endpoint);
+                writeProtocolInt(output->min, endpoint);
+                writeProtocolInt(output->max, endpoint);
+                writeProtocolInt(output->failsafe_mode, endpoint);
+                writeProtocolInt(output->failsafe, endpoint);
+                writeProtocolInt(getServoOutput(i), endpoint);
+                if (!hasServoPin(i))
+                {
+                    writeProtocolText("(no pin)", endpoint);
+                }
+                writeProtocolText("\r\n", endpoint);
+            }
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        break;
+    }
+    case PROTOCOL_SETPOINT_STREAM:
+    {
+        int p[2];
+        argument_index = sscanf(commandline, "%c %d %d", &command, &p[0], &p[1]);
+        if (argument_index >= 2 && (p[0] == 0 || p[0] == 1))
+        {
+            if (argument_index < 3)
+            {
+                p[1] = getSetpointDelay();
+            }
+            if (p[1] >= 0 && p[1] <= SETPOINT_MAX_DELAY)
+            {
+                enableSetpointStream(p[0], p[1]);
+                writeProtocolHead(PROTOCOL_SETPOINT_STREAM, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 1)
+        {
+            const setpointstats_t * stats = getSetpointStats();
+            writeProtocolHead(PROTOCOL_SETPOINT_STREAM, endpoint);
+            writeProtocolInt(isSetpointStreamActive(), endpoint);
+            writeProtocolInt(getSetpointDelay(), endpoint);
+            writeProtocolText("\r\nframes", endpoint);
+            writeProtocolLong(stats->frames, endpoint);
+            writeProtocolText("checksum errors", endpoint);
+            writeProtocolLong(stats->checksum_errors, endpoint);
+            writeProtocolText("late", endpoint);
+            writeProtocolLong(stats->late, endpoint);
+            writeProtocolText("overflows", endpoint);
+            writeProtocolLong(stats->overflows, endpoint);
+            writeProtocolText("underruns", endpoint);
+            writeProtocolLong(stats->underruns, endpoint);
+            writeProtocolText("\r\njitter ms", endpoint);
+            writeProtocolLong(stats->jitter, endpoint);
+            writeProtocolText("buffered", endpoint);
+            writeProtocolInt(stats->level, endpoint);
+            writeProtocolText("\r\n", endpoint);
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        break;
+    }
+    case PROTOCOL_TRACKING:
+    {
+        int32_t pos;
+        double p[3];
+        argument_index = sscanf(commandline, "%c %ld %lf %lf %lf", &command, &pos, &p[0], &p[1], &p[2]);
+        if (argument_index == 2 && (pos == 0 || pos == 1))
+        {
+            activesettings.tracking_active = pos;
+            requestControlPlan();
+            writeProtocolHead(PROTOCOL_TRACKING, endpoint);
+            writeProtocolOK(endpoint);
+        }
+        else if (argument_index == 3 || argument_index == 5)
+        {
+            if (argument_index < 5)
+            {
+                p[1] = activesettings.tracking_us_per_degree;
+                p[2] = activesettings.tracking_max_rate;
+            }
+            if (p[0] != 0.0f && p[0] >= -1000.0f && p[0] <= 1000.0f && p[1] != 0.0f && p[1] >= -50.0f && p[1] <= 50.0f && p[2] > 0.0f)
+            {
+                activesettings.tracking_target = pos;
+                activesettings.tracking_distance = p[0];
+                activesettings.tracking_us_per_degree = p[1];
+                activesettings.tracking_max_rate = p[2];
+                activesettings.tracking_active = 1;
+                requestControlPlan();
+                writeProtocolHead(PROTOCOL_TRACKING, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 1)
+        {
+            writeProtocolHead(PROTOCOL_TRACKING, endpoint);
+            writeProtocolInt(activesettings.tracking_active, endpoint);
+            writeProtocolLong(activesettings.tracking_target, endpoint);
+            writeProtocolDouble(activesettings.tracking_distance, endpoint);
+            writeProtocolDouble(activesettings.tracking_us_per_degree, endpoint);
+            writeProtocolDouble(activesettings.tracking_max_rate, endpoint);
+            writeProtocolText("\r\nyaw servo", endpoint);
+            writeProtocolInt(TIM3->CCR4, endpoint);
+            if (getPosTriggerCount() != 0)
+            {
+                writeProtocolText("(used by the position triggers)", endpoint);
+            }
+            writeProtocolText("\r\n", endpoint);
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        break;
+    }
+    case PROTOCOL_STICK_CURVE:
+    {
+        double p[2 + STICKCURVE_POINTS];
+        argument_index = sscanf(commandline, "%c %lf %lf %lf %lf %lf %lf %lf %lf %lf", &command,
+                                &p[0], &p[1], &p[2], &p[3], &p[4], &p[5], &p[6], &p[7], &p[8]);
+        if (argument_index == 2)
+        {
+            if (p[0] >= 1.0f && p[0] <= 2000.0f)
+            {
+                activesettings.stick_curve_range = (int16_t) p[0];
+                requestControlPlan();
+                writeProtocolHead(PROTOCOL_STICK_CURVE, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 3 || argument_index == 4 || argument_index == 3 + STICKCURVE_POINTS)
+        {
+            uint8_t mode = (uint8_t) p[0];
+            uint8_t type = (uint8_t) p[1];
+            uint8_t valid = (p[0] == 0.0f || p[0] == 1.0f) && p[1] >= STICKCURVE_LINEAR && p[1] <= STICKCURVE_CUSTOM;
+            uint8_t i;
+            if (valid && type == STICKCURVE_CUSTOM)
+            {
+                /* the breakpoints have to be rising from 0 to 1000 permille */
+                valid = (argument_index == 3 + STICKCURVE_POINTS);
+                for (i = 0; valid && i < STICKCURVE_POINTS; i++)
+                {
+                    valid = p[2 + i] >= ((i == 0) ? 0.0f : p[1 + i]) && p[2 + i] <= 1000.0f;
+                }
+            }
+            else if (valid && type == STICKCURVE_EXPO)
+            {
+                valid = (argument_index == 4) && p[2] >= 0.0f && p[2] <= 1.0f;
+            }
+            else if (valid)
+            {
+                valid = (argument_index == 3);
+            }
+            if (valid)
+            {
+                stickcurve_t * curve = &activesettings.stick_curve[mode];
+                curve->type = type;
+                if (type == STICKCURVE_EXPO)
+                {
+                    curve->expo = (float) p[2];
+                }
+                else if (type == STICKCURVE_CUSTOM)
+                {
+                    for (i = 0; i < STICKCURVE_POINTS; i++)
+                    {
+                        curve->points[i] = (int16_t) p[2 + i];
+                    }
+                }
+                requestControlPlan();
+                writeProtocolHead(PROTOCOL_STICK_CURVE, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 1)
+        {
+            uint8_t mode;
+            uint8_t i;
+            writeProtocolHead(PROTOCOL_STICK_CURVE, endpoint);
+            writeProtocolInt(activesettings.stick_curve_range, endpoint);
+            writeProtocolText("\r\n", endpoint);
+            for (mode = 0; mode < 2; mode++)
+            {
+                const stickcurve_t * curve = &activesettings.stick_curve[mode];
+                writeProtocolText((mode == 0) ? "operational" : "safemode", endpoint);
+                writeProtocolText(getStickCurveLabel(curve->type), endpoint);
+                if (curve->type == STICKCURVE_EXPO)
+                {
+                    writeProtocolDouble(curve->expo, endpoint);
+                }
+                else if (curve->type == STICKCURVE_CUSTOM)
+                {
+                    for (i = 0; i < STICKCURVE_POINTS; i++)
+                    {
+                        writeProtocolInt(curve->points[i], endpoint);
+                    }
+                }
+                writeProtocolText("\r\n", endpoint);
+            }
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        break;
+    }
+    case PROTOCOL_SHAPER:
+    {
+        int16_t type;
+        double p[2];
+        argument_index = sscanf(commandline, "%c %hd %lf %lf", &command, &type, &p[0], &p[1]);
+        if (argument_index >= 2)
+        {
+            if (argument_index < 3)
+            {
+                p[0] = activesettings.shaper_frequency;
+            }
+            if (argument_index < 4)
+            {
+                p[1] = activesettings.shaper_damping;
+            }
+            if (type >= SHAPER_OFF && type <= SHAPER_EI && p[0] >= SHAPER_MIN_FREQUENCY && p[0] <= SHAPER_MAX_FREQUENCY &&
+                p[1] >= 0.0f && p[1] < 1.0f)
+            {
+                activesettings.shaper_type = (uint8_t) type;
+                activesettings.shaper_frequency = p[0];
+                activesettings.shaper_damping = p[1];
+                requestControlPlan();
+                writeProtocolHead(PROTOCOL_SHAPER, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else
+        {
+            const shaperplan_t * shaper = &getControlPlan()->shaper;
+            uint8_t i;
+            writeProtocolHead(PROTOCOL_SHAPER, endpoint);
+            writeProtocolInt(activesettings.shaper_type, endpoint);
+            writeProtocolText(getShaperLabel(activesettings.shaper_type), endpoint);
+            writeProtocolDouble(activesettings.shaper_frequency, endpoint);
+            writeProtocolDouble(activesettings.shaper_damping, endpoint);
+            writeProtocolText("\r\nimpulses amplitude, delay s", endpoint);
+            for (i = 0; i < shaper->count; i++)
+            {
+                writeProtocolDouble(shaper->amplitude[i], endpoint);
+                writeProtocolDouble((shaper->delay[i] + shaper->fraction[i]) * Ta, endpoint);
+            }
+            writeProtocolOK(endpoint);
+        }
+        break;
+    }
+    case PROTOCOL_SWING_IDENT:
+    {
+        if (getJob()->active)
+        {
+            writeProtocolError(ERROR_JOB_ACTIVE, endpoint);
+        }
+        else
+        {
+            startSwingIdentification();
+            startJob("swing identification", identifySwingStep, SHAPER_IDENT_SAMPLES + SHAPER_IDENT_MAX_LAG + 1, 1, endpoint);
+        }
+        break;
+    }
+    case PROTOCOL_JOB:
+    {
+        int16_t p;
+        const job_t * job = getJob();
+        argument_index = sscanf(commandline, "%c %hd", &command, &p);
+        if (argument_index == 2 && p == 0)
+        {
+            if (cancelJob() == 0)
+            {
+                writeProtocolHead(PROTOCOL_JOB, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_JOB_NOT_CANCELABLE, endpoint);
+            }
+        }
+        else if (argument_index == 1)
+        {
+            writeProtocolHead(PROTOCOL_JOB, endpoint);
+            if (job->active)
+            {
+                writeProtocolText(job->name, endpoint);
+                writeProtocolLong(job->position, endpoint);
+                writeProtocolLong(job->total, endpoint);
+                writeProtocolInt((int16_t) (job->position * 100 / job->total), endpoint);
+                writeProtocolText("%", endpoint);
+            }
+            else
+            {
+                writeProtocolText("idle", endpoint);
+            }
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        break;
+    }
+    case PROTOCOL_POS_TRIGGER:
+    {
+        int32_t pos;
+        int16_t p[3];
+        p[2] = SERVO_AUX;
+        argument_index = sscanf(commandline, "%c %ld %hd %hd %hd", &command, &pos, &p[0], &p[1], &p[2]);
+        if (argument_index == 4 || argument_index == 5)
+        {
+            if (p[0] >= -1 && p[0] <= 1 && p[1] > 0 && p[2] >= 0 && addPosTrigger(pos, p[0], p[1], p[2]) == 0)
+            {
+                writeProtocolHead(PROTOCOL_POS_TRIGGER, endpoint);
+                writeProtocolOK(endpoint);
+            }
+            else
+            {
+                writeProtocolError(ERROR_INVALID_VALUE, endpoint);
+            }
+        }
+        else if (argument_index == 1)
+        {
+            uint8_t i;
+            writeProtocolHead(PROTOCOL_POS_TRIGGER, endpoint);
+            writeProtocolText("\r\n", endpoint);
+            for (i = 0; i < getPosTriggerCount(); i++)
+            {
+                const postrigger_t * trigger = getPosTrigger(i);
+                writeProtocolText("position ", endpoint);
+                writeProtocolLong(trigger->position, endpoint);
+                writeProtocolText("direction ", endpoint);
+                writeProtocolInt(trigger->direction, endpoint);
+                writeProtocolText("pulse us ", endpoint);
+                writeProtocolInt(trigger->pulse_width, endpoint);
+                writeProtocolText("output ", endpoint);
+                writeProtocolInt(trigger->output, endpoint);
+                writeProtocolText("\r\n", endpoint);
+            }
+            writeProtocolText("fired ", endpoint);
+            writeProtocolLong(getPosTriggerFiredCount(), endpoint);
+            writeProtocolText("skipped ", endpoint);
+            writeProtocolLong(getPosTriggerSkippedCount(), endpoint);
+            writeProtocolOK(endpoint);
+        }
+        else
+        {
+            writeProtocolError(ERROR_NUMBER_OF_ARGUMENTS, endpoint);
+        }
+        break;
+    }
+    case PROTOCOL_BOOT_TIME:
+    {
+        BOOT_STAGE_t stage;
+        writeProtocolHead(PROTOCOL_BOOT_TIME, endpoint);
+        writeProtocolText("\r\n", endpoint);
+        for (stage = BOOT_STAGE_MAIN; stage < BOOT_STAGE_COUNT; stage++)
+        {
+            writeProtocolText(getBootStageLabel(stage), endpoint);
+            writeProtocolText(" done after us ", endpoint);
+            writeProtocolLong(getBootStageTime(stage), endpoint);
+            writeProtocolText("\r\n", endpoint);
+        }
+        writeProtocolOK(endpoint);
+        break;
+    }
+#ifdef PROFILER
+    case PROTOCOL_PROFILER:
+    {
+        int16_t reset = 0;
+        PROBE_t probe;
+        probestats_t s;
+        uint8_t i;
+
+        sscanf(commandline, "%c %hd", &command, &reset);
+        writeProtocolHead(PROTOCOL_PROFILER, endpoint);
+        writeProtocolText("\r\n", endpoint);
+        for (probe = PROBE_CONTROLLERCYCLE; probe < PROBE_COUNT; probe++)
+        {
+            getProbeStats(probe, &s);
+            writeProtocolText(getProbeLabel(probe), endpoint);
+            writeProtocolText(": count", endpoint);
+            writeProtocolLong(s.count, endpoint);
+            writeProtocolText("min", endpoint);
+            writeProtocolLong(s.min, endpoint);
+            writeProtocolText("max", endpoint);
+            writeProtocolLong(s.max, endpoint);
+            writeProtocolText("mean", endpoint);
+            writeProtocolLong(s.count != 0 ? (int32_t) (s.sum / s.count) : 0, endpoint);
+            writeProtocolText("mean excl. irqs", endpoint);
+            writeProtocolLong(s.count != 0 ? (int32_t) (s.sum_exclusive / s.count) : 0, endpoint);
+            writeProtocolText("preempted", endpoint);
+            writeProtocolLong(s.preempted, endpoint);
+            writeProtocolText("\r\n    cycles 2^n:", endpoint);
+            for (i = 0; i < PROFILER_HISTOGRAM_SIZE; i++)
+            {
+                if (s.histogram[i] != 0)
+                {
+                    writeProtocolInt(i, endpoint);
+                    writeProtocolChar('=', endpoint);
+                    writeProtocolLong(s.histogram[i], endpoint);
+                }
+            }
+            writeProtocolText("\r\n", endpoint);
+            USBPeriodElapsed();
+        }
+        if (reset == 1)
+        {
+            resetProfiler();
+        }
+        writeProtocolOK(endpoint);
+        break;
+    }
+#endif
+    case PROTOCOL_LATENCY:
+    {
+        int16_t reset = 0;
+        LATENCYSEGMENT_t segment;
+        latencystats_t s;
+        uint8_t i;
+
+        sscanf(commandline, "%c %hd", &command, &reset);
+        writeProtocolHead(PROTOCOL_LATENCY, endpoint);
+        writeProtocolText("\r\n", endpoint);
+        for (segment = LATENCY_DECODE; segment < LATENCY_SEGMENT_COUNT; segment++)
+        {
+            getLatencyStats(segment, &s);
+            writeProtocolText(getLatencySegmentLabel(segment), endpoint);
+            writeProtocolText(": count", endpoint);
+            writeProtocolLong(s.count, endpoint);
+            writeProtocolText("min", endpoint);
+            writeProtocolLong(s.min, endpoint);
+            writeProtocolText("p50", endpoint);
+            writeProtocolLong(getLatencyPercentile(&s, 500), endpoint);
+            writeProtocolText("p90", endpoint);
+            writeProtocolLong(getLatencyPercentile(&s, 900), endpoint);
+            writeProtocolText("p99", endpoint);
+            writeProtocolLong(getLatencyPercentile(&s, 990), endpoint);
+            writeProtocolText("max", endpoint);
+            writeProtocolLong(s.max, endpoint);
+            writeProtocolText("mean", endpoint);
+            writeProtocolLong(s.count != 0 ? (int32_t) (s.sum / s.count) : 0, endpoint);
+            writeProtocolText("\r\n    from us:", endpoint);
+            for (i = 0; i < LATENCY_HISTOGRAM_SIZE; i++)
+            {
+                if (s.histogram[i] != 0)
+                {
+                    writeProtocolLong(getLatencyBucketStart(i), endpoint);
+                    writeProtocolChar('=', endpoint);
+                    writeProtocolLong(s.histogram[i], endpoint);
+                }
+            }
+            writeProtocolText("\r\n", endpoint);
+            USBPeriodElapsed();
+        }
+        if (reset == 1)
+        {
+            resetLatency();
+        }
+        writeProtocolOK(endpoint);
+        break;
+    }
+    case PROTOCOL_LINK_QUALITY:
+    {
+        int16_t reset = 0;
+        linkstats_t s;
+        uint8_t i;
+
+        sscanf(commandline, "%c %hd", &command, &reset);
+        getLinkStats(&s);
+        writeProtocolHead(PROTOCOL_LINK_QUALITY, endpoint);
+        writeProtocolText("\r\nframes", endpoint);
+        writeProtocolLong(s.frames, endpoint);
+        writeProtocolText("interval us", endpoint);
+        writeProtocolLong(s.nominal_interval, endpoint);
+        writeProtocolText("lost", endpoint);
+        writeProtocolLong(s.lost_frames, endpoint);
+        writeProtocolText("in runs", endpoint);
+        writeProtocolLong(s.lost_runs, endpoint);
+        writeProtocolText("longest run", endpoint);
+        writeProtocolLong(s.longest_run, endpoint);
+        writeProtocolText("longest gap us", endpoint);
+        writeProtocolLong(s.longest_gap, endpoint);
+        writeProtocolText("timeouts", endpoint);
+        writeProtocolLong(s.timeouts, endpoint);
+        writeProtocolText("\r\nsignal loss 0.1%", endpoint);
+        writeProtocolLong(s.frames != 0 ? (int32_t) (((uint64_t) s.signalloss_frames) * 1000 / s.frames) : 0, endpoint);
+        writeProtocolText("failsafe frames", endpoint);
+        writeProtocolLong(s.failsafe_frames, endpoint);
+        writeProtocolText("episodes", endpoint);
+        writeProtocolLong(s.failsafe_episodes, endpoint);
+        writeProtocolText("longest ms", endpoint);
+        writeProtocolLong(s.failsafe_longest, endpoint);
+        writeProtocolText("\r\n    interval ms:", endpoint);
+        for (i = 0; i < LINKQUALITY_HISTOGRAM_SIZE; i++)
+        {
+            if (s.histogram[i] != 0)
+            {
+                writeProtocolInt(i, endpoint);
+                writeProtocolChar('=', endpoint);
+                writeProtocolLong(s.histogram[i], endpoint);
+            }
+        }
+        writeProtocolText("\r\n", endpoint);
+        if (reset == 1)
+        {
+            resetLinkStats();
+        }
+        writeProtocolOK(endpoint);
+        break;
+    }
+    case PROTOCOL_TASKS:
+    {
+        TASK_t id;
+        writeProtocolHead(PROTOCOL_TASKS, endpoint);
+        writeProtocolText("\r\n", endpoint);
+        for (id = TASK_CONTROL; id < TASK_COUNT; id++)
+        {
+            const task_t * task = getTask(id);
+            writeProtocolText(task->name, endpoint);
+            writeProtocolText(": runs", endpoint);
+            writeProtocolLong(task->runs, endpoint);
+            writeProtocolText("max us", endpoint);
+            writeProtocolLong(task->maxcycles / (SystemCoreClock / 1000000), endpoint);
+            if (task->period != 0)
+            {
+                writeProtocolText("max late us", endpoint);
+                writeProtocolLong(task->maxlate, endpoint);
+            }
+            writeProtocolText("load 0.1%", endpoint);
+            writeProtocolInt(task->load, endpoint);
+            writeProtocolText("\r\n", endpoint);
+        }
+        writeProtocolText("stack used bytes", endpoint);
+        writeProtocolLong(getStackUsage(), endpoint);
+        writeProtocolText("\r\n", endpoint);
+        for (id = 0; id < 2; id++)
+        {
+            const uartstats_t * stats = getUARTStats((id == 0) ? EndPoint_UART3 : EndPoint_UART2);
+            writeProtocolText((id == 0) ? "uart3: received" : "uart2: received", endpoint);
+            writeProtocolLong(stats->bytes_received, endpoint);
+            writeProtocolText("sent", endpoint);
+            writeProtocolLong(stats->bytes_sent, endpoint);
+            writeProtocolText("dropped", endpoint);
+            writeProtocolLong(stats->bytes_dropped, endpoint);
+            writeProtocolText("lines dropped", endpoint);
+            writeProtocolLong(stats->lines_dropped, endpoint);
+            writeProtocolText("errors", endpoint);
+            writeProtocolLong(stats->errors, endpoint);
+            writeProtocolText("\r\n", endpoint);
+        }
+        writeProtocolOK(endpoint);
+        break;
+    }
+    case PROTOCOL_POS_TRIGGER_CLEAR:
+    {
+        clearPosTriggers();
+        writeProtocolHead(PROTOCOL_POS_TRIGGER_CLEAR, endpoint);
+        writeProtocolOK(endpoint);
+        break;
+    }
+    default:  // we do not know how to handle the (valid) message, indicate error MSP $M!
+        writeProtocolError(ERROR_UNKNOWN_COMMAND, endpoint);
+        break;
+    }
+}
 
-    PrintlnSerial_string("Neutral position and range of the RC:", endpoint);
-    PrintSerial_string("  Neutral point:", endpoint);
-    PrintSerial_int(activesettings.stick_neutral_pos, endpoint);
-    PrintSerial_string(" +-", endpoint);
-    PrintlnSerial_int(activesettings.stick_neutral_range, endpoint);
-    PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
+/** \brief Start writing the activesettings to the eeprom as a job
+ *
+ * \param endpoint Endpoints Where to write the result to
+ * \return void
+ *
+ */
+void requestSettingsSave(Endpoints endpoint)
+{
+    if (getJob()->active)
+    {
+        writeProtocolError(ERROR_JOB_ACTIVE, endpoint);
+        return;
+    }
+    memcpy(&settings_save_buffer, &activesettings, sizeof(settings_save_buffer));
+    /* The erase is started by the first step, until then the job can be cancelled */
+    startJob("settings save", startSettingsSaveStep, 100, 1, endpoint);
+}
 
+/** \brief The first step of the $w job, starting to erase the sector
+ *
+ * Once the sector is erased the write has to be completed, else the settings would be lost, hence the job
+ * is not cancelable from now on and continues with saveSettingsStep().
+ *
+ * \param job job_t*
+ * \return int8_t JOB_RUNNING if the erase got started
+ *
+ */
+static int8_t startSettingsSaveStep(job_t * job)
+{
+    if (eeprom_write_sector_start((uint8_t*) &settings_save_buffer, sizeof(settings_save_buffer), EEPROM_SECTOR_FOR_SETTINGS) != 0)
+    {
+        writeProtocolError(ERROR_EEPROM_SAVE, job->endpoint);
+        return JOB_FAILED;
+    }
+    job->cancelable = 0;
+    job->step = saveSettingsStep;
+    return JOB_RUNNING;
+}
 
-    PrintlnSerial_string("Ramp filter:", endpoint);
-    PrintSerial_string("  Operational mode ", endpoint);
-    if (controllerstatus.safemode == OPERATIONAL)
+/** \brief One step of the $w job, waiting for the erase, writing or verifying a page
+ *
+ * \param job job_t*
+ * \return int8_t JOB_RUNNING until the write is verified
+ *
+ */
+static int8_t saveSettingsStep(job_t * job)
+{
+    int8_t result = eeprom_write_sector_step();
+    job->position = eeprom_write_sector_progress();
+    if (result == EEPROM_WRITE_BUSY)
+    {
+        return JOB_RUNNING;
+    }
+    writeProtocolHead(PROTOCOL_EEPROM_WRITE, job->endpoint);
+    if (result == EEPROM_WRITE_DONE)
     {
-        PrintlnSerial_string("(active)", endpoint);
+        writeProtocolText("\r\nSettings saved successfully", job->endpoint);
+        writeProtocolOK(job->endpoint);
+        return JOB_DONE;
     }
     else
     {
-        PrintlnSerial(endpoint);
+        writeProtocolError(ERROR_EEPROM_SAVE, job->endpoint);
+        return JOB_FAILED;
     }
-    if (activesettings.mode != MODE_LIMITER && activesettings.mode != MODE_LIMITER_ENDPOINTS && activesettings.mode != MODE_ABSOLUTE_POSITION)
+}
+
+/** \brief One step of the $x job, recording the swing and finding its frequency
+ *
+ * \param job job_t*
+ * \return int8_t JOB_RUNNING until the swing frequency is found
+ *
+ */
+static int8_t identifySwingStep(job_t * job)
+{
+    float frequency;
+    int8_t result = stepSwingIdentification(&job->position, &frequency);
+    if (result == JOB_RUNNING)
     {
-        PrintSerial_string("Current mode ", endpoint);
-        PrintSerial_string(getSafeModeLabel(), endpoint);
-        PrintlnSerial_string(" does not use the accel and speed limits", endpoint);
+        return JOB_RUNNING;
     }
-    PrintSerial_string("  Limit stick value changes to ", endpoint);
-    PrintSerial_int(activesettings.stick_max_accel, endpoint);
-    PrintSerial_string("* 5 every second at max", endpoint);
-    PrintSerial_string(" and the max value is +-", endpoint);
-    PrintSerial_int(activesettings.stick_max_speed, endpoint);
-    PrintlnSerial_string(" around its neutral range", endpoint);
-    PrintlnSerial(endpoint);
+    if (result == JOB_DONE)
+    {
+        activesettings.shaper_frequency = frequency;
+        requestControlPlan();
+        writeProtocolHead(PROTOCOL_SWING_IDENT, job->endpoint);
+        writeProtocolDouble(frequency, job->endpoint);
+        writeProtocolOK(job->endpoint);
+    }
+    else
+    {
+        writeProtocolErrorText("no periodic swing found", job->endpoint);
+    }
+    return result;
+}
 
-    PrintSerial_string("  Programming mode ", endpoint);
-    if (controllerstatus.safemode == PROGRAMMING)
+/** \brief One step of the $E job, waiting for the calibration to finish
+ *
+ * \param job job_t*
+ * \return int8_t JOB_RUNNING until the ESC table is calibrated
+ *
+ */
+static int8_t calibrateESCStep(job_t * job)
+{
+    int8_t result = stepESCCalibration(&job->position);
+    if (result == JOB_RUNNING)
+    {
+        return JOB_RUNNING;
+    }
+    if (result == JOB_DONE)
     {
-        PrintlnSerial_string("(active)", endpoint);
+        requestControlPlan();
+        writeProtocolHead(PROTOCOL_ESC_CALIBRATION, job->endpoint);
+        writeProtocolText("\r\nESC table calibrated and active, see $e", job->endpoint);
+        writeProtocolOK(job->endpoint);
     }
     else
     {
-        PrintlnSerial(endpoint);
+        writeProtocolErrorText("ESC calibration aborted or no movement measured", job->endpoint);
     }
-    PrintSerial_string("  Limit stick value changes to ", endpoint);
-    PrintSerial_int(activesettings.stick_max_accel_safemode, endpoint);
-    PrintSerial_string(" * 5 every second at max", endpoint);
-    PrintSerial_string(" and the max value is +-", endpoint);
-    PrintSerial_int(activesettings.stick_max_speed_safemode, endpoint);
-    PrintlnSerial_string(" around its neutral range", endpoint);
-    PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
+    return result;
+}
 
+/** \brief Print the ultimate gain and period of the last auto-tune and the PID gains each tuning rule proposes
+ *
+ * \param endpoint Endpoints
+ * \return void
+ *
+ */
+static void printAutoTuneResult(Endpoints endpoint)
+{
+    const autotuneresult_t * result = getAutoTuneResult();
+    double p, i, d;
+    uint8_t rule;
+
+    if (!result->valid)
+    {
+        writeProtocolText("no result", endpoint);
+        return;
+    }
+    writeProtocolText("\r\nKu", endpoint);
+    writeProtocolDouble(result->ku, endpoint);
+    writeProtocolText("Tu s", endpoint);
+    writeProtocolDouble(result->tu, endpoint);
+    writeProtocolText("oscillation steps", endpoint);
+    writeProtocolDouble(result->oscillation, endpoint);
+    writeProtocolText("\r\n", endpoint);
+    for (rule = 0; rule < AUTOTUNE_RULES; rule++)
+    {
+        getAutoTuneGains(rule, &p, &i, &d);
+        writeProtocolInt(rule, endpoint);
+        writeProtocolText(getAutoTuneRuleLabel(rule), endpoint);
+        writeProtocolDouble(p, endpoint);
+        writeProtocolDouble(i, endpoint);
+        writeProtocolDouble(d, endpoint);
+        writeProtocolText("\r\n", endpoint);
+    }
+}
+
+/** \brief One step of the $A job, waits for the relay experiment and prints the proposed gains
+ *
+ * \param job job_t*
+ * \return int8_t JOB_RUNNING until the experiment finished
+ *
+ */
+static int8_t autoTuneStep(job_t * job)
+{
+    int8_t result = stepAutoTune(&job->position);
+    if (result == JOB_RUNNING)
+    {
+        return JOB_RUNNING;
+    }
+    if (result == JOB_DONE)
+    {
+        writeProtocolHead(PROTOCOL_AUTOTUNE, job->endpoint);
+        printAutoTuneResult(job->endpoint);
+        if (autotune_rule >= 0)
+        {
+            double p, i, d;
+            getAutoTuneGains(autotune_rule, &p, &i, &d);
+            setPIDValues(p, i, d);
+            writeProtocolText("applied", job->endpoint);
+            writeProtocolText(getAutoTuneRuleLabel(autotune_rule), job->endpoint);
+        }
+        writeProtocolOK(job->endpoint);
+    }
+    else
+    {
+        writeProtocolErrorText("PID auto-tune aborted or no oscillation", job->endpoint);
+    }
+    return result;
+}
 
-    PrintlnSerial_string("ESC output signal is generated around the neutral position with range", endpoint);
-    PrintSerial_string("  Neutral point:", endpoint);
-    PrintSerial_int(activesettings.esc_neutral_pos, endpoint);
-    PrintSerial_string(" +-", endpoint);
-    PrintlnSerial_int(activesettings.esc_neutral_range, endpoint);
+void printHelp(Endpoints endpoint)
+{
     PrintlnSerial(endpoint);
     PrintlnSerial(endpoint);
 
+    PrintlnSerial_string(controllerstatus.boottext_eeprom, endpoint);
+    PrintlnSerial_string(controllerstatus.boottext_position, endpoint);
+
+    PrintSerial_string("Current Mode: ", endpoint);
+    PrintlnSerial_string(getCurrentModeLabel(activesettings.mode), endpoint);
 
-    PrintlnSerial_string("The sensor direction and the motor direction might not be the same. If the CableCam", endpoint);
-    PrintlnSerial_string("overshot the end point, pulling the stick in reverse direction to get the CableCam back between", endpoint);
-    PrintlnSerial_string("the end points should be allowed, moving it further out should not. But which direction is it?", endpoint);
-    PrintSerial_string("  Motor/ESC direction:", endpoint);
-    PrintSerial_int(activesettings.esc_direction, endpoint);
-    switch (activesettings.esc_direction)
+    PrintSerial_string("Current Receiver type: ", endpoint);
+    if (activesettings.receivertype == RECEIVER_TYPE_SUMPPM)
+    {
+        PrintlnSerial_string("Sum-PPM", endpoint);
+    }
+    else
     {
-        case 1: PrintSerial_string("(positive stick = hall sensor counts up)", endpoint); break;
-        case -1: PrintSerial_string("(positive stick = hall sensor counts down)", endpoint); break;
-        default: PrintSerial_string("(not yet decided, drive to pos>500 on a horizontal rope to set it automatically)", endpoint); break;
+        PrintlnSerial_string("SBus", endpoint);
     }
+
+    PrintSerial_string("Current CableCam operation mode: ", endpoint);
+    PrintSerial_string(getSafeModeLabel(), endpoint);
+
     PrintlnSerial(endpoint);
     PrintlnSerial(endpoint);
     PrintlnSerial(endpoint);
+    PrintlnSerial(endpoint);
+    PrintlnSerial_string("Possible commands are", endpoint);
+    PrintlnSerial(endpoint);
 
-
-    PrintlnSerial_string("The controller mode.", endpoint);
-    PrintSerial_string("  Mode", endpoint);
-    PrintSerial_int(activesettings.mode, endpoint);
-    PrintSerial_string("...", endpoint);
-    PrintlnSerial_string(getCurrentModeLabel(activesettings.mode), endpoint);
+    PrintlnSerial_string("$A [<int> [<int>]]                      PID auto-tune with the relay amplitude in us and the rule to apply, or print the result", endpoint);
+    PrintlnSerial_string("$a [<int> <int>]                        set or print maximum allowed acceleration in normal and programming mode", endpoint);
+    PrintlnSerial_string("$b                                      print the time each boot stage took to complete", endpoint);
+    PrintlnSerial_string("$D [1]                                  print the input to output latencies in us, 1 to reset them afterwards", endpoint);
+    PrintlnSerial_string("$e [<int>]                              print the ESC table or stop (0) and start (1) using it", endpoint);
+    PrintlnSerial_string("$E <int>                                calibrate the ESC table up to the given pulse width offset in us, requires the wheel off the rope", endpoint);
+    PrintlnSerial_string("$g [<double>]                           set or print the max positional error -> exceeding it causes an emergency stop", endpoint);
+    PrintlnSerial_string("$H [<int>]                              start (1), stop (0) or print the simulation of the cablecam on the bench", endpoint);
+    PrintlnSerial_string("$H <double> x6                          set the simulated mass, slope, slope change, max thrust, esc lag, steps/m", endpoint);
+    PrintlnSerial_string("$i [<int> <int> <int> [<int> [<int> [<int> [<int>]]]]] set or print input channels for Speed, Programming Switch, Endpoint Switch, Max Accel, Max Speed, Zone Switch, Yaw", endpoint);
+    PrintlnSerial_string("$I [<int>]                              set or print input source 0..SumPPM", endpoint);
+    PrintlnSerial_string("                                                                  1..SBus", endpoint);
+    PrintlnSerial_string("$j [0]                                  print the progress of the running $S, $w or $z command, 0 to cancel it", endpoint);
+    PrintlnSerial_string("$k [<double>]                           set the wheel slip threshold in m/s^2, 0 to disable traction control, or print the slip log", endpoint);
+    PrintlnSerial_string("$K                                      clear the slip log and the degraded position flag", endpoint);
+    PrintlnSerial_string("$l                                      print the cpu load and runtime of the tasks", endpoint);
+    PrintlnSerial_string("$L [1]                                  print the RC link statistics, 1 to reset them afterwards", endpoint);
+    PrintlnSerial_string("$m [<int>]                              set or print the mode 0..positional", endpoint);
+    PrintlnSerial_string("                                                              1..passthrough", endpoint);
+    PrintlnSerial_string("                                                              2..passthrough with speed limits", endpoint);
+    PrintlnSerial_string("                                                              3..passthough with speed limits & end points", endpoint);
+    PrintlnSerial_string("$n [<int> <int>]                        set or print receiver neutral pos and +-range", endpoint);
+    PrintlnSerial_string("$N [<int> <int>]                        set or print ESC output neutral pos and +-range", endpoint);
+    PrintlnSerial_string("$O [<int>]                              set or print the servo output protocol: 0 PWM 50Hz, 1 PWM 400Hz, 2 OneShot125", endpoint);
+    PrintlnSerial_string("$O <ch> <min> <max> <mode> [<int>]      set a servo output's limits and failsafe: 0 none, 1 hold, 2 value, 3 off", endpoint);
+    PrintlnSerial_string("$p                                      print positions", endpoint);
+    PrintlnSerial_string("$q [0|1 [<int>]]                        print the setpoint stream statistics or stop/start it with the playout delay in ms", endpoint);
+    PrintlnSerial_string("$r [<int>]                              set or print rotation direction of the ESC output, either +1 or -1", endpoint);
+    PrintlnSerial_string("$s [<int> [<double> [<double>]]]        set or print the input shaper 0..off 1..ZV 2..ZVD 3..EI, swing frequency Hz, damping", endpoint);
+#ifdef PROFILER
+    PrintlnSerial_string("$P [<int>]                              print the profiler statistics in cpu cycles, 1 to reset them afterwards", endpoint);
+#endif
+    PrintlnSerial_string("$S                                      print all settings", endpoint);
+    PrintlnSerial_string("$t [<long> <int> <int> [<int>]]         add or print position triggers: position, direction -1/0/+1, pulse width us, output", endpoint);
+    PrintlnSerial_string("$T                                      remove all position triggers", endpoint);
+    PrintlnSerial_string("$u [<double>]                           set the hall sensor steps per meter or print it with the IMU values", endpoint);
+    PrintlnSerial_string("$v [<int> <int>]                        set or print maximum allowed speed in normal and programming mode", endpoint);
+    PrintlnSerial_string("$w                                      write settings to eeprom", endpoint);
+    PrintlnSerial_string("$y [<int>]                              print the stick curves or set the stick value at full deflection", endpoint);
+    PrintlnSerial_string("$y <mode> <type> [<double>|<7 x int>]   set the stick curve of mode 0 operational/1 safemode: 0 linear, 1 expo, 2 custom", endpoint);
+    PrintlnSerial_string("$Y [0|1]                                print the yaw tracking or turn it off/on", endpoint);
+    PrintlnSerial_string("$Y <long> <double> [<double> <double>]  aim the yaw servo at a target: position, distance in m, us per degree, degrees/s", endpoint);
+    PrintlnSerial_string("$Z [<long> <int> <int>]                 add or print speed zone breakpoints: position, max speed, max accel", endpoint);
+    PrintlnSerial_string("$Z 0                                    remove all speed zones", endpoint);
+    PrintlnSerial_string("$G [<int> <long> <float> <float> <float>] add or print gain schedule breakpoints: direction, speed, P, I, D", endpoint);
+    PrintlnSerial_string("$G <int>                                remove the gain schedule of a direction, 0 forward, 1 reverse", endpoint);
+    PrintlnSerial_string("$x                                      identify the swing frequency of the camera for the input shaper", endpoint);
 
     PrintlnSerial(endpoint);
-    PrintlnSerial(endpoint);
+    PrintlnSerial_string("$1 [<double>]                           set or print Kp for PID controller", endpoint);
+    PrintlnSerial_string("$2 [<double>]                           set or print Ki for PID controller", endpoint);
+    PrintlnSerial_string("$3 [<double>]                           set or print Kd for PID controller", endpoint);
+    PrintlnSerial_string("$c [<double> <double> <double>]         set or print all three PID values", endpoint);
+    PrintlnSerial_string("$f [<double>]                           set or print stick-to-hall-speed factor", endpoint);
+    PrintlnSerial_string("$F [<int>]                              print the feed forward map, stop (0), start (1) using it or clear it (2)", endpoint);
     PrintlnSerial(endpoint);
 }
 
-void printDebugCycles(Endpoints endpoint)
+/** \brief One step of the $S job, printing one section of the settings summary
+ *
+ * \param job job_t* position is the number of sections printed so far
+ * \return int8_t JOB_RUNNING until all SETTINGS_SECTIONS are printed
+ *
+ */
+static int8_t printActiveSettingsStep(job_t * job)
 {
-    /*
-     * Oldest values first, if there are any
-     */
-     int16_t last = controllerstatus.cyclemonitor_position;
-    for (int i=last; i < CYCLEMONITOR_SAMPLE_COUNT; i++)
+    switch (job->position)
     {
-        cyclemonitor_t * sample = & controllerstatus.cyclemonitor[i];
-        if (sample->tick != 0)
+    case 0:
+    {
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial_string("Active settings", job->endpoint);
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+
+        PrintSerial_string("Version of the stored settings: ", job->endpoint);
+        PrintlnSerial_string(activesettings.version, job->endpoint);
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        break;
+    }
+    case 1:
+    {
+        PrintSerial_string("Controller status: ", job->endpoint);
+        switch (controllerstatus.monitor)
         {
-            PrintSerial_long(sample->tick, endpoint);
-            PrintSerial_int(sample->stick, endpoint);
-            PrintSerial_int(sample->esc, endpoint);
-            PrintSerial_double(sample->speed, endpoint);
-            PrintSerial_double(sample->pos, endpoint);
-            PrintlnSerial_double(sample->distance_to_stop, endpoint);
-            if (i % 20 == 0)
-            {
-                USBPeriodElapsed(); // it is too much data, we need to flush once a while
-            }
+        case EMERGENCYBRAKE:
+            PrintlnSerial_string("Emergency brake on", job->endpoint);
+            break;
+        case FREE:
+            PrintlnSerial_string("Free running", job->endpoint);
+            break;
+        case ENDPOINTBRAKE:
+            PrintlnSerial_string("Endpoint brake on", job->endpoint);
+            break;
+        }
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        break;
+    }
+    case 2:
+    {
+        PrintlnSerial_string("Currently the endpoint limits are configured as ", job->endpoint);
+        int32_t pos = ENCODER_VALUE;
+
+        /* The plan has the endpoints sorted already, start is always smaller than end and below prints rely on that. */
+        const controlplan_t * plan = getControlPlan();
+
+        PrintSerial_string(" ", job->endpoint);
+        if (pos < plan->pos_start)
+        {
+            PrintSerial_long(pos, job->endpoint);
+            PrintSerial_string("--- ", job->endpoint);
+        }
+        PrintSerial_long((int32_t) plan->pos_start, job->endpoint);
+        PrintSerial_string(" <--------- ", job->endpoint);
+        if (plan->pos_start <= pos && pos <= plan->pos_end)
+        {
+            PrintSerial_long(pos, job->endpoint);
+        }
+        PrintSerial_string(" ---------> ", job->endpoint);
+        PrintSerial_long((int32_t) plan->pos_end, job->endpoint);
+        if (pos > plan->pos_end)
+        {
+            PrintSerial_string("--- ", job->endpoint);
+            PrintSerial_long(pos, job->endpoint);
+        }
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        break;
+    }
+    case 3:
+    {
+        PrintlnSerial_string("Neutral position and range of the RC:", job->endpoint);
+        PrintSerial_string("  Neutral point:", job->endpoint);
+        PrintSerial_int(activesettings.stick_neutral_pos, job->endpoint);
+        PrintSerial_string(" +-", job->endpoint);
+        PrintlnSerial_int(activesettings.stick_neutral_range, job->endpoint);
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        break;
+    }
+    case 4:
+    {
+        PrintlnSerial_string("Ramp filter:", job->endpoint);
+        PrintSerial_string("  Operational mode ", job->endpoint);
+        if (controllerstatus.safemode == OPERATIONAL)
+        {
+            PrintlnSerial_string("(active)", job->endpoint);
+        }
+        else
+        {
+            PrintlnSerial(job->endpoint);
+        }
+        if (activesettings.mode != MODE_LIMITER && activesettings.mode != MODE_LIMITER_ENDPOINTS && activesettings.mode != MODE_ABSOLUTE_POSITION)
+        {
+            PrintSerial_string("Current mode ", job->endpoint);
+            PrintSerial_string(getSafeModeLabel(), job->endpoint);
+            PrintlnSerial_string(" does not use the accel and speed limits", job->endpoint);
         }
+        PrintSerial_string("  Limit stick value changes to ", job->endpoint);
+        PrintSerial_int(activesettings.stick_max_accel, job->endpoint);
+        PrintSerial_string("* 5 every second at max", job->endpoint);
+        PrintSerial_string(" and the max value is +-", job->endpoint);
+        PrintSerial_int(activesettings.stick_max_speed, job->endpoint);
+        PrintlnSerial_string(" around its neutral range", job->endpoint);
+        PrintlnSerial(job->endpoint);
+        break;
+    }
+    case 5:
+    {
+        PrintSerial_string("  Programming mode ", job->endpoint);
+        if (controllerstatus.safemode == PROGRAMMING)
+        {
+            PrintlnSerial_string("(active)", job->endpoint);
+        }
+        else
+        {
+            PrintlnSerial(job->endpoint);
+        }
+        PrintSerial_string("  Limit stick value changes to ", job->endpoint);
+        PrintSerial_int(activesettings.stick_max_accel_safemode, job->endpoint);
+        PrintSerial_string(" * 5 every second at max", job->endpoint);
+        PrintSerial_string(" and the max value is +-", job->endpoint);
+        PrintSerial_int(activesettings.stick_max_speed_safemode, job->endpoint);
+        PrintlnSerial_string(" around its neutral range", job->endpoint);
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        break;
+    }
+    case 6:
+    {
+        PrintlnSerial_string("ESC output signal is generated around the neutral position with range", job->endpoint);
+        PrintSerial_string("  Neutral point:", job->endpoint);
+        PrintSerial_int(activesettings.esc_neutral_pos, job->endpoint);
+        PrintSerial_string(" +-", job->endpoint);
+        PrintlnSerial_int(activesettings.esc_neutral_range, job->endpoint);
+        if (activesettings.esc_table_active == 1)
+        {
+            PrintlnSerial_string("  The neutral range is replaced by the calibrated ESC table, see $e", job->endpoint);
+        }
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        break;
+    }
+    case 7:
+    {
+        PrintlnSerial_string("The sensor direction and the motor direction might not be the same. If the CableCam", job->endpoint);
+        PrintlnSerial_string("overshot the end point, pulling the stick in reverse direction to get the CableCam back between", job->endpoint);
+        PrintlnSerial_string("the end points should be allowed, moving it further out should not. But which direction is it?", job->endpoint);
+        PrintSerial_string("  Motor/ESC direction:", job->endpoint);
+        PrintSerial_int(activesettings.esc_direction, job->endpoint);
+        switch (activesettings.esc_direction)
+        {
+            case 1: PrintSerial_string("(positive stick = hall sensor counts up)", job->endpoint); break;
+            case -1: PrintSerial_string("(positive stick = hall sensor counts down)", job->endpoint); break;
+            default: PrintSerial_string("(not yet decided, drive to pos>500 on a horizontal rope to set it automatically)", job->endpoint); break;
+        }
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        break;
+    }
+    case 8:
+    {
+        PrintlnSerial_string("The controller mode.", job->endpoint);
+        PrintSerial_string("  Mode", job->endpoint);
+        PrintSerial_int(activesettings.mode, job->endpoint);
+        PrintSerial_string("...", job->endpoint);
+        PrintlnSerial_string(getCurrentModeLabel(activesettings.mode), job->endpoint);
+
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        break;
+    }
+    case 9:
+    {
+        PrintlnSerial_string("The input shaper against the swing of the camera.", job->endpoint);
+        PrintSerial_string("  Shaper ", job->endpoint);
+        PrintSerial_string(getShaperLabel(activesettings.shaper_type), job->endpoint);
+        PrintSerial_string(" for a swing of ", job->endpoint);
+        PrintSerial_double(activesettings.shaper_frequency, job->endpoint);
+        PrintSerial_string("Hz with a damping of ", job->endpoint);
+        PrintlnSerial_double(activesettings.shaper_damping, job->endpoint);
+        PrintlnSerial(job->endpoint);
+        PrintlnSerial(job->endpoint);
+        break;
+    }
     }
+    job->position++;
+    return (job->position < SETTINGS_SECTIONS) ? JOB_RUNNING : JOB_DONE;
+}
 
-    for (int i=0; i<last; i++)
+/** \brief One step of the $z job, printing DEBUG_CYCLES_PER_STEP samples of the cycle monitor
+ *
+ * The controller keeps adding samples while the job runs, but the job reads faster than one sample per
+ * cycle, so it is always ahead of the samples being overwritten.
+ *
+ * \param job job_t* position is the number of samples printed so far
+ * \return int8_t JOB_RUNNING until all samples are printed
+ *
+ */
+static int8_t printDebugCyclesStep(job_t * job)
+{
+    uint8_t lines = 0;
+    /*
+     * Oldest values first, if there are any
+     */
+    while (lines < DEBUG_CYCLES_PER_STEP && job->position < CYCLEMONITOR_SAMPLE_COUNT)
     {
-        cyclemonitor_t * sample = & controllerstatus.cyclemonitor[i];
-        PrintSerial_long(sample->tick, endpoint);
-        PrintSerial_int(sample->stick, endpoint);
-        PrintSerial_int(sample->esc, endpoint);
-        PrintSerial_double(sample->speed, endpoint);
-        PrintSerial_double(sample->pos, endpoint);
-        PrintlnSerial_double(sample->distance_to_stop, endpoint);
-        if (i % 20 == 0)
+        cyclemonitor_t * sample = & controllerstatus.cyclemonitor[(debugcycles_start + job->position) % CYCLEMONITOR_SAMPLE_COUNT];
+        job->position++;
+        if (sample->tick != 0)
         {
-            USBPeriodElapsed(); // it is too much data, we need to flush once a while
+            PrintSerial_long(sample->tick, job->endpoint);
+            PrintSerial_int(sample->stick, job->endpoint);
+            PrintSerial_int(sample->esc, job->endpoint);
+            PrintSerial_double(sample->speed, job->endpoint);
+            PrintSerial_double(sample->pos, job->endpoint);
+            PrintSerial_double(sample->distance_to_stop, job->endpoint);
+            PrintlnSerial_long(sample->rc_age, job->endpoint);
+            lines++;
         }
     }
+    return (job->position < CYCLEMONITOR_SAMPLE_COUNT) ? JOB_RUNNING : JOB_DONE;
 }
 
 uint8_t is_ok(uint8_t *btchar_string, uint8_t * btchar_string_length)
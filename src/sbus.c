@@ -4,6 +4,11 @@
 #include "config.h"
 #include "sbus.h"
 #include "protocol.h"
+#include "scheduler.h"
+#include "linkquality.h"
+#include "latency.h"
+#include "timebase.h"
+#include "string.h"
 
 
 /*
@@ -16,9 +21,12 @@
  * Futaba R6208SB/R6303SB
  * time between frames: 11ms.
  * time to send frame: 3ms.
+ *
+ * Within a frame the bytes follow each other every 120us, hence a longer pause means
+ * the frame got interrupted and the next byte is the start of a new one.
  */
 
-#define SBUS_TIME_NEEDED_PER_FRAME 3
+#define SBUS_MAX_BYTE_GAP 500   // us
 
 
 #define SBUS_STATE_FAILSAFE (1 << 0)
@@ -37,39 +45,54 @@
 
 
 
-void setServoValues(void);
-
 static sbusFrame_t sbusFrame;
+static sbusFrame_t sbusFrameReceived;     // copy of the last complete frame, decoded by the receiver task
 static int8_t current_virtual_channel = 0;
 static uint16_t lastrising = 0;
 
 sbusData_t sbusdata;
 
-void setServoValues()
+/** \brief Receiver task decoding the last complete SBus frame into the servo values
+ *
+ * Signalled by the SBUS_IRQHandler() whenever a frame is complete.
+ *
+ * \return void
+ *
+ */
+void processSBUSFrame()
 {
-    if (sbusFrame.frame.syncByte == SBUS_FRAME_BEGIN_BYTE && sbusFrame.frame.endByte == SBUS_FRAME_END_BYTE)
+    sbusFrame_t received;
+
+    /* The interrupt might store the next frame meanwhile */
+    HAL_NVIC_DisableIRQ(USART1_IRQn);
+    memcpy(&received, &sbusFrameReceived, sizeof(received));
+    HAL_NVIC_EnableIRQ(USART1_IRQn);
+
+    if (received.frame.syncByte == SBUS_FRAME_BEGIN_BYTE && received.frame.endByte == SBUS_FRAME_END_BYTE)
     {
-        sbusdata.sbusLastValidFrame = HAL_GetTick();
-        sbusdata.servovalues[0].duty = (sbusFrame.frame.chan0);
-        sbusdata.servovalues[1].duty = (sbusFrame.frame.chan1);
-        sbusdata.servovalues[2].duty = (sbusFrame.frame.chan2);
-        sbusdata.servovalues[3].duty = (sbusFrame.frame.chan3);
-        sbusdata.servovalues[4].duty = (sbusFrame.frame.chan4);
-        sbusdata.servovalues[5].duty = (sbusFrame.frame.chan5);
-        sbusdata.servovalues[6].duty = (sbusFrame.frame.chan6);
-        sbusdata.servovalues[7].duty = (sbusFrame.frame.chan7);
-        sbusdata.servovalues[8].duty = (sbusFrame.frame.chan8);
-        sbusdata.servovalues[9].duty = (sbusFrame.frame.chan9);
-        sbusdata.servovalues[10].duty = (sbusFrame.frame.chan10);
-        sbusdata.servovalues[11].duty = (sbusFrame.frame.chan11);
-        sbusdata.servovalues[12].duty = (sbusFrame.frame.chan12);
-        sbusdata.servovalues[13].duty = (sbusFrame.frame.chan13);
-        sbusdata.servovalues[14].duty = (sbusFrame.frame.chan14);
-        sbusdata.servovalues[15].duty = (sbusFrame.frame.chan15);
-        sbusdata.channel16 = (sbusFrame.frame.flags & SBUS_FLAG_CHANNEL_16);
-        sbusdata.channel17 = (sbusFrame.frame.flags & SBUS_FLAG_CHANNEL_17);
-        sbusdata.signalloss = sbusFrame.frame.flags & SBUS_FLAG_SIGNAL_LOSS;
-        sbusdata.failsafeactive = sbusFrame.frame.flags & SBUS_FLAG_FAILSAFE_ACTIVE;
+        traceLatency(LATENCY_SNAPSHOT);
+        sbusdata.sbusLastValidFrame = MICROS();
+        sbusdata.timeout = 0;
+        sbusdata.servovalues[0].duty = (received.frame.chan0);
+        sbusdata.servovalues[1].duty = (received.frame.chan1);
+        sbusdata.servovalues[2].duty = (received.frame.chan2);
+        sbusdata.servovalues[3].duty = (received.frame.chan3);
+        sbusdata.servovalues[4].duty = (received.frame.chan4);
+        sbusdata.servovalues[5].duty = (received.frame.chan5);
+        sbusdata.servovalues[6].duty = (received.frame.chan6);
+        sbusdata.servovalues[7].duty = (received.frame.chan7);
+        sbusdata.servovalues[8].duty = (received.frame.chan8);
+        sbusdata.servovalues[9].duty = (received.frame.chan9);
+        sbusdata.servovalues[10].duty = (received.frame.chan10);
+        sbusdata.servovalues[11].duty = (received.frame.chan11);
+        sbusdata.servovalues[12].duty = (received.frame.chan12);
+        sbusdata.servovalues[13].duty = (received.frame.chan13);
+        sbusdata.servovalues[14].duty = (received.frame.chan14);
+        sbusdata.servovalues[15].duty = (received.frame.chan15);
+        sbusdata.channel16 = (received.frame.flags & SBUS_FLAG_CHANNEL_16);
+        sbusdata.channel17 = (received.frame.flags & SBUS_FLAG_CHANNEL_17);
+        sbusdata.signalloss = received.frame.flags & SBUS_FLAG_SIGNAL_LOSS;
+        sbusdata.failsafeactive = received.frame.flags & SBUS_FLAG_FAILSAFE_ACTIVE;
         sbusdata.counter_sbus_valid_data++;
     }
 }
@@ -77,10 +100,15 @@ void setServoValues()
 /*
  * getDuty() returns the current duty value, that is 172...992...1811.
  * It returns 0 in case the value is too old or the RC does not send a valid channel value or a wrong channel is requested.
+ * The timeout is latched, else a frame older than the wrap around of the microsecond counter would look recent again.
  */
 int16_t getDuty(uint8_t channel)
 {
-    if (HAL_GetTick() - sbusdata.sbusLastValidFrame > 3000L || sbusdata.failsafeactive)
+    if (!sbusdata.timeout && TIME_ELAPSED(MICROS(), sbusdata.sbusLastValidFrame) > SBUS_TIMEOUT)
+    {
+        sbusdata.timeout = 1;
+    }
+    if (sbusdata.timeout || sbusdata.failsafeactive)
     {
         return 0;
     }
@@ -133,16 +161,16 @@ void SBUS_IRQHandler(UART_HandleTypeDef *huart)
         /* UART in mode Receiver -------------------------------------------------*/
         if(((isrflags & USART_SR_RXNE) != RESET) && ((cr1its & USART_CR1_RXNEIE) != RESET))
         {
-            uint32_t now = HAL_GetTick();
-            uint32_t sbusFrameTime = now - sbusdata.sbusFrameStartTime;
+            uint32_t now = MICROS();
 
-            if (sbusFrameTime > SBUS_TIME_NEEDED_PER_FRAME)
+            if (TIME_ELAPSED(now, sbusdata.sbusLastByteTime) > SBUS_MAX_BYTE_GAP && huart->RxXferCount != SBUS_FRAME_SIZE)
             {
+                /* the frame is incomplete, start over */
                 huart->pRxBuffPtr = &sbusFrame.bytes[0];
                 huart->RxXferCount = SBUS_FRAME_SIZE;
-                sbusdata.sbusFrameStartTime = now;
                 sbusdata.counter_sbus_frame_errors++;
             }
+            sbusdata.sbusLastByteTime = now;
 
             if (huart->RxXferCount > 0)
             {
@@ -156,16 +184,19 @@ void SBUS_IRQHandler(UART_HandleTypeDef *huart)
                 }
                 else
                 {
-                    if (huart->RxXferCount == SBUS_FRAME_SIZE)
-                    {
-                        sbusdata.sbusFrameStartTime = now;
-                    }
                     huart->RxXferCount--;
                     huart->pRxBuffPtr += 1U;
                     if (huart->RxXferCount == 0)
                     {
-                        /* Last byte of the frame */
-                        setServoValues();
+                        /* Last byte of the frame, the decoding is done by the receiver task */
+                        memcpy(&sbusFrameReceived, &sbusFrame, sizeof(sbusFrameReceived));
+                        signalTask(TASK_RECEIVER);
+                        if (sbusFrame.frame.endByte == SBUS_FRAME_END_BYTE)
+                        {
+                            traceLatency(LATENCY_FRAME);
+                            recordReceiverFrame(((sbusFrame.frame.flags & SBUS_FLAG_SIGNAL_LOSS) ? LINKQUALITY_FLAG_SIGNALLOSS : 0) |
+                                                ((sbusFrame.frame.flags & SBUS_FLAG_FAILSAFE_ACTIVE) ? LINKQUALITY_FLAG_FAILSAFE : 0));
+                        }
                         huart->pRxBuffPtr = &sbusFrame.bytes[0];
                         huart->RxXferCount = SBUS_FRAME_SIZE;
                         sbusdata.counter_sbus_frames++;
@@ -227,14 +258,14 @@ void printSBUSChannels(Endpoints endpoint)
     PrintSerial_long(sbusdata.sbusLastValidFrame, endpoint);
     PrintSerial_string("  SBUS Errors: ", endpoint);
     PrintSerial_long(sbusdata.counter_sbus_errors, endpoint);
-    uint32_t age = HAL_GetTick() - sbusdata.sbusLastValidFrame;
+    uint32_t age = TIME_ELAPSED(MICROS(), sbusdata.sbusLastValidFrame) / 1000;
     if (sbusdata.counter_sbus_frames == 0)
     {
         PrintlnSerial_string("Never received any SBUS data", endpoint);
     }
     else
     {
-        if (age > 3000L)
+        if (sbusdata.timeout || age > SBUS_TIMEOUT / 1000)
         {
             PrintSerial_string("Data too old: ", endpoint);
             PrintlnSerial_long(age, endpoint);
@@ -289,9 +320,13 @@ void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim)
             if (duty > 4000)   // a long duty signal is the packet-end of a sum ppm
             {
                 current_virtual_channel = 0; // Hence the next duty signal will be for the first channel
-                sbusdata.sbusLastValidFrame = HAL_GetTick(); // and we got a valid frame, so set the timestamp to now
+                sbusdata.sbusLastValidFrame = MICROS(); // and we got a valid frame, so set the timestamp to now
+                sbusdata.timeout = 0;
                 sbusdata.counter_sbus_valid_data++;
                 sbusdata.receivertype = RECEIVER_TYPE_SUMPPM;
+                recordReceiverFrame(0);
+                traceLatency(LATENCY_FRAME);
+                traceLatency(LATENCY_SNAPSHOT); // the values are used as they come in
             }
             else     // everything else is the duty signal
             {
@@ -313,9 +348,13 @@ void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim)
             else if (pause > 10000)     // no sum ppm
             {
                 current_virtual_channel = 0;
-                sbusdata.sbusLastValidFrame = HAL_GetTick();
+                sbusdata.sbusLastValidFrame = MICROS();
+                sbusdata.timeout = 0;
                 sbusdata.counter_sbus_valid_data++;
                 sbusdata.receivertype = RECEIVER_TYPE_SERVO;
+                recordReceiverFrame(0);
+                traceLatency(LATENCY_FRAME);
+                traceLatency(LATENCY_SNAPSHOT); // the values are used as they come in
             }
 
             lastrising = HAL_TIM_ReadCapturedValue(htim, TIM_CHANNEL_3);
@@ -0,0 +1,214 @@
+#include "scheduler.h"
+#include "stm32f4xx_hal.h"
+#include "timebase.h"
+
+/*
+ * Bounds of the RAM area the stack can grow into, provided by the linker script.
+ */
+extern uint32_t __HeapLimit;
+extern uint32_t __StackTop;
+
+#define STACK_PAINT_PATTERN 0xA5A5A5A5
+
+static task_t tasks[TASK_COUNT];
+
+/*
+ * One bit per task, set when the task is ready to run. Set by signalTask() from
+ * interrupts as well, hence all changes are done with interrupts disabled.
+ */
+static volatile uint32_t pending = 0;
+
+static uint32_t windowstart = 0;
+static uint32_t windowstartcycles = 0;
+static uint32_t * stackpaintstart = 0;
+
+/** \brief Fill the unused stack area with a pattern to find the max stack usage later
+ *
+ * \return void
+ *
+ */
+static void paintStack(void)
+{
+    uint32_t * sp = (uint32_t *) (uintptr_t) __get_MSP();
+    uint32_t * p = sp - (SCHEDULER_STACK_PAINT / 4);
+
+    if (p < &__HeapLimit)
+    {
+        p = &__HeapLimit;
+    }
+    stackpaintstart = p;
+    /* leave some space below the stack pointer for the interrupts happening meanwhile */
+    while (p < sp - 32)
+    {
+        *p++ = STACK_PAINT_PATTERN;
+    }
+}
+
+void initScheduler()
+{
+    uint8_t i;
+    for (i = 0; i < TASK_COUNT; i++)
+    {
+        tasks[i].name = "";
+        tasks[i].function = 0;
+    }
+    paintStack();
+}
+
+/** \brief Register the function for a task
+ *
+ * \param id TASK_t The task, which defines the priority as well
+ * \param name char* Name for the statistics
+ * \param function taskfunction_t Function to call whenever the task is ready
+ * \param period uint32_t Period in ms the task is ready, 0 if it is run when signalled only
+ * \return void
+ *
+ */
+void addTask(TASK_t id, char * name, taskfunction_t function, uint32_t period)
+{
+    tasks[id].name = name;
+    tasks[id].function = function;
+    tasks[id].period = period * 1000;
+    tasks[id].nextrun = MICROS();
+}
+
+/** \brief Make a task ready, e.g. because an interrupt received data to be processed
+ *
+ * Can be called from interrupts.
+ *
+ * \param id TASK_t
+ * \return void
+ *
+ */
+void signalTask(TASK_t id)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    pending |= (1UL << id);
+    __set_PRIMASK(primask);
+}
+
+const task_t * getTask(TASK_t id)
+{
+    return &tasks[id];
+}
+
+/** \brief The deepest the stack ever reached since boot
+ *
+ * \return uint32_t bytes of stack used, the monitored area is SCHEDULER_STACK_PAINT bytes only
+ *
+ */
+uint32_t getStackUsage()
+{
+    uint32_t * p = stackpaintstart;
+    while (p < &__StackTop && *p == STACK_PAINT_PATTERN)
+    {
+        p++;
+    }
+    return (uint32_t) ((uint8_t *) &__StackTop - (uint8_t *) p);
+}
+
+/** \brief Make all periodic tasks ready whose time has come
+ *
+ * \param now uint32_t current time in us
+ * \return void
+ *
+ */
+static void checkPeriodicTasks(uint32_t now)
+{
+    uint8_t i;
+    for (i = 0; i < TASK_COUNT; i++)
+    {
+        task_t * task = &tasks[i];
+        if (task->period != 0 && TIME_REACHED(now, task->nextrun))
+        {
+            if (!task->waiting)
+            {
+                task->due = task->nextrun;
+                task->waiting = 1;
+            }
+            task->nextrun += task->period;
+            if (TIME_REACHED(now, task->nextrun))
+            {
+                /* the task is late by more than a period, do not try to catch up, restart the period */
+                task->nextrun = now + task->period;
+            }
+            signalTask(i);
+        }
+    }
+}
+
+/** \brief Calculate the cpu load of all tasks once per load window
+ *
+ * \param now uint32_t current time in us
+ * \return void
+ *
+ */
+static void checkLoadWindow(uint32_t now)
+{
+    if (TIME_ELAPSED(now, windowstart) >= SCHEDULER_LOAD_WINDOW * 1000)
+    {
+        uint32_t windowcycles = DWT->CYCCNT - windowstartcycles;
+        uint8_t i;
+        for (i = 0; i < TASK_COUNT; i++)
+        {
+            tasks[i].load = (uint16_t) (((uint64_t) tasks[i].windowcycles) * 1000 / windowcycles);
+            tasks[i].windowcycles = 0;
+        }
+        windowstart = now;
+        windowstartcycles = DWT->CYCCNT;
+    }
+}
+
+/** \brief Run the tasks forever
+ *
+ * Every time a task finished, the search for the next task starts with the highest priority again.
+ *
+ * \return void
+ *
+ */
+void runScheduler()
+{
+    windowstart = MICROS();
+    windowstartcycles = DWT->CYCCNT;
+
+    while (1)
+    {
+        uint32_t now = MICROS();
+        checkPeriodicTasks(now);
+        checkLoadWindow(now);
+
+        uint32_t ready = pending;
+        if (ready != 0)
+        {
+            uint8_t id = __CLZ(__RBIT(ready)); // lowest bit set is the task with the highest priority
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            pending &= ~(1UL << id);
+            __set_PRIMASK(primask);
+
+            task_t * task = &tasks[id];
+            if (task->waiting)
+            {
+                uint32_t late = TIME_ELAPSED(MICROS(), task->due);
+                if (late > task->maxlate)
+                {
+                    task->maxlate = late;
+                }
+                task->waiting = 0;
+            }
+            if (task->function != 0)
+            {
+                uint32_t start = DWT->CYCCNT;
+                task->function();
+                uint32_t cycles = DWT->CYCCNT - start;
+                task->runs++;
+                task->windowcycles += cycles;
+                if (cycles > task->maxcycles)
+                {
+                    task->maxcycles = cycles;
+                }
+            }
+        }
+    }
+}
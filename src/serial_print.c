@@ -3,6 +3,7 @@
 #include "string.h"
 #include "stdio.h"
 #include "usbd_cdc_if.h"
+#include "uart.h"
 
 char printbuf[80];
 
@@ -98,10 +99,46 @@ void SendString(char * ptr, Endpoints endpoint)
 {
     if (endpoint == EndPoint_UART3 || endpoint == EndPoint_All)
     {
-        // Uart_SendString(ptr);
+        UART_TransmitString(EndPoint_UART3, ptr);
+    }
+    if (endpoint == EndPoint_UART2 || endpoint == EndPoint_All)
+    {
+        UART_TransmitString(EndPoint_UART2, ptr);
     }
     if (endpoint == EndPoint_USB || endpoint == EndPoint_All)
     {
         CDC_TransmitString(ptr);
     }
 }
+
+/** \brief Free space in the transmit buffer of the endpoint, the smallest one for EndPoint_All
+ *
+ * Every endpoint has its own buffer, hence a slow uart does not limit the USB output unless the output goes to all.
+ *
+ * \param endpoint Endpoints
+ * \return uint32_t number of bytes that can be written without loss
+ *
+ */
+uint32_t getTxFree(Endpoints endpoint)
+{
+    uint32_t free;
+    switch (endpoint)
+    {
+    case EndPoint_USB:
+        return CDC_GetTxFree();
+    case EndPoint_UART3:
+    case EndPoint_UART2:
+        return UART_GetTxFree(endpoint);
+    default:
+        free = CDC_GetTxFree();
+        if (UART_GetTxFree(EndPoint_UART3) < free)
+        {
+            free = UART_GetTxFree(EndPoint_UART3);
+        }
+        if (UART_GetTxFree(EndPoint_UART2) < free)
+        {
+            free = UART_GetTxFree(EndPoint_UART2);
+        }
+        return free;
+    }
+}
@@ -0,0 +1,183 @@
+#include "servo.h"
+#include "config.h"
+#include "stddef.h"
+
+/** \brief The timer compare register a servo channel is output with
+ */
+typedef struct
+{
+    volatile uint32_t * ccr;        // NULL if the board has no pin for that channel
+    uint32_t preload;               // the CCMR2 preload bit, if cleared the channel is used for something else currently
+} servopin_t;
+
+/*
+ * Servo1 (TIM3 CH3) drives the ESC, Servo2 (TIM3 CH4) the yaw servo unless the position triggers use it.
+ * Servo3/4 are the USART2 pins and Servo5/6 the encoder, hence there is no pin for pitch and aux.
+ */
+static const servopin_t pins[SERVO_CHANNELS] =
+{
+    {&TIM3->CCR3, TIM_CCMR2_OC3PE},
+    {NULL, 0},
+    {&TIM3->CCR4, TIM_CCMR2_OC4PE},
+    {NULL, 0}
+};
+
+static char * servoprotocol_labels[] = {"PWM 50Hz", "PWM 400Hz", "OneShot125"};
+
+static uint16_t shadow[SERVO_CHANNELS];     // the values staged within the current cycle
+static uint16_t committed[SERVO_CHANNELS];  // the values output
+static uint8_t staged = 0;                  // bit mask of the channels set within the current cycle
+static uint8_t servoprotocol = SERVO_PROTOCOL_PWM50;
+
+/** \brief Change the timing of all TIM3 outputs
+ *
+ * The ESC and Servo2 share TIM3, hence the protocol is the same for both. For OneShot125 the timer runs
+ * eight times faster, so the pulse widths keep their values: 1000..2000 results in 125..250us.
+ *
+ * \param protocol uint8_t SERVO_PROTOCOL_PWM50, SERVO_PROTOCOL_PWM400 or SERVO_PROTOCOL_ONESHOT125
+ * \return void
+ *
+ */
+void setServoProtocol(uint8_t protocol)
+{
+    switch (protocol)
+    {
+    case SERVO_PROTOCOL_PWM400:
+        TIM3->PSC = 16-1;
+        TIM3->ARR = 2500;
+        break;
+    case SERVO_PROTOCOL_ONESHOT125:
+        TIM3->PSC = 2-1;
+        TIM3->ARR = 4000;
+        break;
+    default:
+        protocol = SERVO_PROTOCOL_PWM50;
+        TIM3->PSC = 16-1;
+        TIM3->ARR = 20000;
+        break;
+    }
+    TIM3->EGR = TIM_EGR_UG;
+    servoprotocol = protocol;
+}
+
+uint8_t getServoProtocol()
+{
+    return servoprotocol;
+}
+
+char * getServoProtocolLabel(uint8_t protocol)
+{
+    if (protocol > SERVO_PROTOCOL_ONESHOT125)
+    {
+        return "???";
+    }
+    return servoprotocol_labels[protocol];
+}
+
+/** \brief Stage the pulse width of a channel, it is output by the next commitServoOutputs()
+ *
+ * \param channel uint8_t SERVO_ESC, SERVO_PITCH, SERVO_YAW or SERVO_AUX
+ * \param pulse uint16_t pulse width in us
+ * \return void
+ *
+ */
+void setServoOutput(uint8_t channel, uint16_t pulse)
+{
+    if (channel < SERVO_CHANNELS)
+    {
+        shadow[channel] = pulse;
+        staged |= (1 << channel);
+    }
+}
+
+/** \brief Output all channels staged within this cycle so they change with the same PWM period
+ *
+ * The compare registers are preloaded, the timer copies them into the active ones at its update event.
+ * While the registers are written the update event is disabled, hence either all channels change at
+ * the next period or none, never the ESC in one period and the servo in the next.
+ *
+ * \param outputs const servooutput_t* the limits and failsafe of each channel
+ * \param signalloss uint8_t 1 if no valid RC signal is received, the channels switch to their failsafe
+ * \return void
+ *
+ */
+void commitServoOutputs(const servooutput_t * outputs, uint8_t signalloss)
+{
+    uint8_t i;
+
+    TIM3->CR1 |= TIM_CR1_UDIS;
+    for (i = 0; i < SERVO_CHANNELS; i++)
+    {
+        const servooutput_t * output = &outputs[i];
+        uint16_t pulse = shadow[i];
+
+        if (!(staged & (1 << i)))
+        {
+            continue;
+        }
+        if (signalloss)
+        {
+            switch (output->failsafe_mode)
+            {
+            case SERVO_FAILSAFE_HOLD:
+                if (committed[i] != 0)
+                {
+                    pulse = committed[i];
+                }
+                break;
+            case SERVO_FAILSAFE_VALUE:
+                pulse = output->failsafe;
+                break;
+            case SERVO_FAILSAFE_OFF:
+                pulse = 0;
+                break;
+            }
+        }
+        if (pulse != 0)
+        {
+            if (pulse < output->min)
+            {
+                pulse = output->min;
+            }
+            else if (pulse > output->max)
+            {
+                pulse = output->max;
+            }
+        }
+        committed[i] = pulse;
+        if (pins[i].ccr != NULL && (TIM3->CCMR2 & pins[i].preload))
+        {
+            *pins[i].ccr = pulse;
+        }
+    }
+    TIM3->CR1 &= ~TIM_CR1_UDIS;
+    staged = 0;
+}
+
+/** \brief The pulse width last output on the channel
+ *
+ * \param channel uint8_t
+ * \return uint16_t pulse width in us, 0 if the channel is off
+ *
+ */
+uint16_t getServoOutput(uint8_t channel)
+{
+    return (channel < SERVO_CHANNELS) ? committed[channel] : 0;
+}
+
+uint8_t hasServoPin(uint8_t channel)
+{
+    return (channel < SERVO_CHANNELS) && pins[channel].ccr != NULL;
+}
+
+/** \brief The time until the next update event, when the committed pulse widths start to be output
+ *
+ * TIM3 runs with the core clock, hence the timer ticks times the prescaler are cpu cycles.
+ *
+ * \return uint32_t cpu cycles
+ *
+ */
+uint32_t getServoUpdateDelay()
+{
+    return (TIM3->ARR + 1 - TIM3->CNT) * (TIM3->PSC + 1);
+}
@@ -0,0 +1,270 @@
+#include "setpoint.h"
+#include "stm32f4xx_hal.h"
+#include "string.h"
+
+/*
+ * The jitter buffer, a ring of the received setpoints ordered by their timestamp. tail is the oldest one,
+ * the setpoint the playout position is currently past.
+ */
+static setpoint_t buffer[SETPOINT_BUFFER_SIZE];
+static uint8_t tail = 0;
+static uint8_t count = 0;
+
+static uint8_t active = 0;
+static uint16_t delay = SETPOINT_DEFAULT_DELAY;
+static uint8_t underrun = 0;
+
+/*
+ * The sender's clock is mapped onto HAL_GetTick() with the smallest transit time seen, arrival - timestamp.
+ * Every SETPOINT_OFFSET_WINDOW frames the offset is set to the minimum of that window, so it follows a drift of the clocks.
+ */
+static int32_t offset;
+static int32_t window_min;
+static int32_t window_max;
+static uint16_t window_frames = 0;
+
+static setpointstats_t stats;
+
+/** \brief Start or stop the setpoint stream, starting clears the buffer and the statistics
+ *
+ * \param enable uint8_t 1 to let the stream drive the target position in the absolute position mode
+ * \param playout_delay uint16_t ms the setpoints are delayed to even out the jitter of their arrival
+ * \return void
+ *
+ */
+void enableSetpointStream(uint8_t enable, uint16_t playout_delay)
+{
+    active = 0;
+    count = 0;
+    tail = 0;
+    underrun = 0;
+    window_frames = 0;
+    memset(&stats, 0, sizeof(stats));
+    delay = playout_delay;
+    active = enable;
+}
+
+uint8_t isSetpointStreamActive()
+{
+    return active;
+}
+
+uint16_t getSetpointDelay()
+{
+    return delay;
+}
+
+const setpointstats_t * getSetpointStats()
+{
+    return &stats;
+}
+
+/** \brief Add a received setpoint to the jitter buffer
+ *
+ * A setpoint out of order is dropped. One arriving after its playout time, as it took longer than the delay more than
+ * the fastest one, is counted as late as well, but still buffered, the playout interpolates towards it then.
+ *
+ * \param setpoint const setpoint_t*
+ * \return void
+ *
+ */
+static void pushSetpoint(const setpoint_t * setpoint)
+{
+    int32_t transit = (int32_t) (HAL_GetTick() - setpoint->timestamp);
+
+    stats.frames++;
+    if (window_frames == 0)
+    {
+        if (stats.frames == 1)
+        {
+            offset = transit;
+        }
+        window_min = transit;
+        window_max = transit;
+    }
+    if (transit < offset)
+    {
+        offset = transit;
+    }
+    if (transit < window_min)
+    {
+        window_min = transit;
+    }
+    if (transit > window_max)
+    {
+        window_max = transit;
+    }
+    if (++window_frames >= SETPOINT_OFFSET_WINDOW)
+    {
+        offset = window_min;
+        stats.jitter = window_max - window_min;
+        window_frames = 0;
+    }
+
+    if (count > 0 && (int32_t) (setpoint->timestamp - buffer[(tail + count - 1) % SETPOINT_BUFFER_SIZE].timestamp) <= 0)
+    {
+        stats.late++;
+        return;
+    }
+    if (transit - offset > (int32_t) delay)
+    {
+        stats.late++;
+    }
+    if (count >= SETPOINT_BUFFER_SIZE)
+    {
+        stats.overflows++;
+        return;
+    }
+    buffer[(tail + count) % SETPOINT_BUFFER_SIZE] = *setpoint;
+    count++;
+}
+
+/** \brief Look for the next sync byte in a frame that failed the checksum, e.g. because a byte got lost
+ *
+ * The bytes from the sync on are kept as the start of the next frame. Without a sync the rest of the broken frame
+ * is still to come, up to SETPOINT_FRAME_SIZE - 1 bytes are dropped until a sync arrives.
+ *
+ * \param decoder setpointdecoder_t*
+ * \return void
+ *
+ */
+static void resyncSetpointDecoder(setpointdecoder_t * decoder)
+{
+    uint8_t i;
+    for (i = 1; i < SETPOINT_FRAME_SIZE; i++)
+    {
+        if (decoder->buffer[i] == SETPOINT_SYNC)
+        {
+            decoder->length = SETPOINT_FRAME_SIZE - i;
+            memmove(decoder->buffer, &decoder->buffer[i], decoder->length);
+            return;
+        }
+    }
+    decoder->length = 0;
+    decoder->skip = SETPOINT_FRAME_SIZE - 1;
+}
+
+/** \brief Feed one received byte into the frame decoder of the endpoint
+ *
+ * A frame starts with SETPOINT_SYNC at the beginning of a line, a character no text command contains. All bytes of the
+ * frame are consumed here, the text command parser never sees them.
+ * Frames follow each other, so after a frame the bytes up to the next sync are dropped as well, in case the sync of
+ * the next frame got lost, but no more than a frame and only within SETPOINT_RESYNC_TIMEOUT. A frame failing the
+ * checksum is searched for the sync of the next one. Hence a lost byte costs one or two frames, not the stream.
+ *
+ * \param decoder setpointdecoder_t* the state of the endpoint
+ * \param c uint8_t the received byte
+ * \param line_empty uint8_t 1 if no text has been received since the last line end
+ * \return uint8_t 1 if the byte was part of a frame
+ *
+ */
+uint8_t decodeSetpointByte(setpointdecoder_t * decoder, uint8_t c, uint8_t line_empty)
+{
+    uint32_t now = HAL_GetTick();
+
+    if (decoder->skip > 0 && now - decoder->tick > SETPOINT_RESYNC_TIMEOUT)
+    {
+        decoder->skip = 0;
+    }
+    if (decoder->length == 0)
+    {
+        if (c != SETPOINT_SYNC || (!line_empty && decoder->skip == 0))
+        {
+            if (decoder->skip == 0)
+            {
+                return 0;
+            }
+            decoder->skip--;
+            decoder->tick = now;
+            return 1;
+        }
+        decoder->skip = 0;
+    }
+    decoder->tick = now;
+    decoder->buffer[decoder->length++] = c;
+    if (decoder->length == SETPOINT_FRAME_SIZE)
+    {
+        uint8_t checksum = 0;
+        uint8_t i;
+        for (i = 0; i < SETPOINT_FRAME_SIZE - 1; i++)
+        {
+            checksum ^= decoder->buffer[i];
+        }
+        if (checksum != decoder->buffer[SETPOINT_FRAME_SIZE - 1])
+        {
+            stats.checksum_errors++;
+            resyncSetpointDecoder(decoder);
+            return 1;
+        }
+        decoder->length = 0;
+        decoder->skip = SETPOINT_FRAME_SIZE - 1;
+        if (active)
+        {
+            setpoint_t setpoint;
+            memcpy(&setpoint.timestamp, &decoder->buffer[1], 4); // little endian like the STM32
+            memcpy(&setpoint.pos, &decoder->buffer[5], 4);
+            memcpy(&setpoint.velocity, &decoder->buffer[9], 2);
+            pushSetpoint(&setpoint);
+        }
+    }
+    return 1;
+}
+
+/** \brief The setpoint for the current time, interpolated between the buffered ones, called every controller cycle
+ *
+ * The playout position is the current time mapped to the sender's clock minus the delay. When the playout runs past
+ * the newest setpoint, the buffer underruns and the last setpoint is extrapolated with its velocity for at most
+ * SETPOINT_MAX_EXTRAPOLATION ms and held afterwards.
+ *
+ * \param now uint32_t HAL_GetTick()
+ * \param pos double* the setpoint position
+ * \return int8_t 1 for an interpolated setpoint, 0 if extrapolated or held, -1 if there is none
+ *
+ */
+int8_t getStreamSetpoint(uint32_t now, double * pos)
+{
+    if (!active || count == 0)
+    {
+        stats.level = 0;
+        return -1;
+    }
+    uint32_t playout = now - (uint32_t) offset - delay;
+
+    /* setpoints both older than the playout position are not needed anymore */
+    while (count >= 2 && (int32_t) (playout - buffer[(tail + 1) % SETPOINT_BUFFER_SIZE].timestamp) >= 0)
+    {
+        tail = (tail + 1) % SETPOINT_BUFFER_SIZE;
+        count--;
+    }
+    const setpoint_t * a = &buffer[tail];
+    int32_t dt = (int32_t) (playout - a->timestamp);
+    stats.level = count - 1;
+
+    if (dt < 0)
+    {
+        /* the stream just started, wait at the first setpoint */
+        *pos = a->pos;
+        return 1;
+    }
+    else if (count >= 2)
+    {
+        const setpoint_t * b = &buffer[(tail + 1) % SETPOINT_BUFFER_SIZE];
+        *pos = a->pos + ((double) (b->pos - a->pos)) * dt / (int32_t) (b->timestamp - a->timestamp);
+        underrun = 0;
+        return 1;
+    }
+    else
+    {
+        if (!underrun)
+        {
+            stats.underruns++;
+            underrun = 1;
+        }
+        if (dt > SETPOINT_MAX_EXTRAPOLATION)
+        {
+            dt = SETPOINT_MAX_EXTRAPOLATION;
+        }
+        *pos = a->pos + ((double) a->velocity) * dt / 1000.0;
+        return 0;
+    }
+}
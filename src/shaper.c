@@ -0,0 +1,233 @@
+#include "shaper.h"
+#include "controller.h"
+#include "arm_math.h"
+#include "math.h"
+
+/*
+ * The stick values of the last SHAPER_RING_SIZE cycles, head is where the next one goes.
+ */
+static int16_t ring[SHAPER_RING_SIZE];
+static uint8_t head = 0;
+
+/*
+ * The swing signal recorded for the identification and its autocorrelation, calculated by the job
+ */
+static float32_t ident_samples[SHAPER_IDENT_SAMPLES];
+static float32_t ident_correlation[SHAPER_IDENT_MAX_LAG + 1];
+static uint16_t ident_count = SHAPER_IDENT_SAMPLES;
+static uint16_t ident_lag = 0;
+
+static char * shaper_labels[] = {"off", "ZV", "ZVD", "EI"};
+
+char * getShaperLabel(uint8_t type)
+{
+    if (type > SHAPER_EI)
+    {
+        return "???";
+    }
+    return shaper_labels[type];
+}
+
+static void setImpulse(shaperplan_t * shaper, uint8_t index, float amplitude, float delay)
+{
+    shaper->amplitude[index] = amplitude;
+    shaper->delay[index] = (uint8_t) delay;
+    shaper->fraction[index] = delay - floorf(delay);
+    shaper->lag += amplitude * delay;
+}
+
+/** \brief Calculate the impulses of the shaper for the given swing
+ *
+ * The first impulse is applied right away, the others half a swing period and a full swing period later,
+ * so the swing the later impulses excite cancels the one of the first.
+ * The frequency is the one the camera actually swings with, hence the damped frequency. The EI shaper
+ * uses the impulses of the undamped case, its tolerance covers the small damping of a camera on a rope.
+ *
+ * \param shaper shaperplan_t* The shaper to compile into
+ * \param type uint8_t SHAPER_OFF, SHAPER_ZV, SHAPER_ZVD or SHAPER_EI
+ * \param frequency double Hz, between SHAPER_MIN_FREQUENCY and SHAPER_MAX_FREQUENCY
+ * \param damping double damping ratio 0..1
+ * \return void
+ *
+ */
+void compileShaper(shaperplan_t * shaper, uint8_t type, double frequency, double damping)
+{
+    shaper->count = 0;
+    shaper->lag = 0.0f;
+    if (type == SHAPER_OFF || type > SHAPER_EI || frequency < SHAPER_MIN_FREQUENCY || frequency > SHAPER_MAX_FREQUENCY ||
+        damping < 0.0 || damping >= 1.0)
+    {
+        return;
+    }
+
+    float half_period = (float) (0.5 / (frequency * Ta)); // in cycles
+    float k = expf((float) (-damping * M_PI / sqrt(1.0 - damping * damping)));
+
+    switch (type)
+    {
+    case SHAPER_ZV:
+        setImpulse(shaper, 0, 1.0f / (1.0f + k), 0.0f);
+        setImpulse(shaper, 1, k / (1.0f + k), half_period);
+        shaper->count = 2;
+        break;
+    case SHAPER_ZVD:
+    {
+        float sum = (1.0f + k) * (1.0f + k);
+        setImpulse(shaper, 0, 1.0f / sum, 0.0f);
+        setImpulse(shaper, 1, 2.0f * k / sum, half_period);
+        setImpulse(shaper, 2, k * k / sum, 2.0f * half_period);
+        shaper->count = 3;
+        break;
+    }
+    case SHAPER_EI:
+        setImpulse(shaper, 0, (1.0f + SHAPER_EI_TOLERANCE) / 4.0f, 0.0f);
+        setImpulse(shaper, 1, (1.0f - SHAPER_EI_TOLERANCE) / 2.0f, half_period);
+        setImpulse(shaper, 2, (1.0f + SHAPER_EI_TOLERANCE) / 4.0f, 2.0f * half_period);
+        shaper->count = 3;
+        break;
+    }
+}
+
+/** \brief Convolve the stick value with the impulses of the shaper, called once per controller cycle
+ *
+ * Every cycle costs the same, at most SHAPER_MAX_IMPULSES interpolated reads of the ring. The value is
+ * stored even with the shaper off, so switching it on does not start with a jump.
+ *
+ * \param shaper const shaperplan_t*
+ * \param value int16_t The filtered stick value of this cycle
+ * \return int16_t The shaped stick value
+ *
+ */
+int16_t shapeStick(const shaperplan_t * shaper, int16_t value)
+{
+    uint8_t i;
+    float output = 0.0f;
+
+    ring[head] = value;
+    for (i = 0; i < shaper->count; i++)
+    {
+        int16_t newer = ring[(head - shaper->delay[i]) & (SHAPER_RING_SIZE - 1)];
+        int16_t older = ring[(head - shaper->delay[i] - 1) & (SHAPER_RING_SIZE - 1)];
+        output += shaper->amplitude[i] * ((float) newer + shaper->fraction[i] * (float) (older - newer));
+    }
+    head = (head + 1) & (SHAPER_RING_SIZE - 1);
+
+    if (shaper->count == 0)
+    {
+        return value;
+    }
+    return (int16_t) ((output >= 0.0f) ? output + 0.5f : output - 0.5f);
+}
+
+/** \brief Forget the history, as if the stick had been at value all the time
+ *
+ * Used when the stick value has to be applied without delay, e.g. by an emergency brake.
+ *
+ * \param value int16_t
+ * \return void
+ *
+ */
+void resetShaper(int16_t value)
+{
+    uint8_t i;
+    for (i = 0; i < SHAPER_RING_SIZE; i++)
+    {
+        ring[i] = value;
+    }
+}
+
+/** \brief Record the swing signal of one controller cycle while an identification is running
+ *
+ * \param sample float e.g. the acceleration along the rope, any signal oscillating with the swing will do
+ * \return void
+ *
+ */
+void recordSwing(float sample)
+{
+    if (ident_count < SHAPER_IDENT_SAMPLES)
+    {
+        ident_samples[ident_count++] = sample;
+    }
+}
+
+void startSwingIdentification()
+{
+    ident_lag = 0;
+    ident_count = 0;
+}
+
+/** \brief One step of the swing identification, meant to be run as a job
+ *
+ * First it waits for SHAPER_IDENT_SAMPLES cycles to be recorded, then it calculates the autocorrelation of the
+ * recording a few lags per step. The swing period is where the autocorrelation has its largest peak after
+ * it crossed zero the first time, interpolated between the cycles with a parabola.
+ *
+ * \param progress uint32_t* set to the samples recorded plus the lags calculated
+ * \param frequency float* set to the swing frequency in Hz when done
+ * \return int8_t JOB_RUNNING, JOB_DONE or JOB_FAILED if no periodic swing was found
+ *
+ */
+int8_t stepSwingIdentification(uint32_t * progress, float * frequency)
+{
+    uint8_t i;
+
+    *progress = ident_count + ident_lag;
+    if (ident_count < SHAPER_IDENT_SAMPLES)
+    {
+        return JOB_RUNNING;
+    }
+    if (ident_lag == 0)
+    {
+        float32_t mean;
+        arm_mean_f32(ident_samples, SHAPER_IDENT_SAMPLES, &mean);
+        arm_offset_f32(ident_samples, -mean, ident_samples, SHAPER_IDENT_SAMPLES);
+    }
+    for (i = 0; i < SHAPER_IDENT_LAGS_PER_STEP && ident_lag <= SHAPER_IDENT_MAX_LAG; i++)
+    {
+        arm_dot_prod_f32(ident_samples, &ident_samples[ident_lag], SHAPER_IDENT_SAMPLES - ident_lag, &ident_correlation[ident_lag]);
+        ident_lag++;
+    }
+    *progress = ident_count + ident_lag;
+    if (ident_lag <= SHAPER_IDENT_MAX_LAG)
+    {
+        return JOB_RUNNING;
+    }
+
+    if (ident_correlation[0] <= 0.0f)
+    {
+        return JOB_FAILED;
+    }
+    uint16_t lag = 1;
+    while (lag < SHAPER_IDENT_MAX_LAG && ident_correlation[lag] > 0.0f)
+    {
+        lag++;
+    }
+    uint16_t peak = lag;
+    for (; lag < SHAPER_IDENT_MAX_LAG; lag++)
+    {
+        if (ident_correlation[lag] > ident_correlation[peak])
+        {
+            peak = lag;
+        }
+    }
+    if (peak < SHAPER_IDENT_MIN_LAG || peak >= SHAPER_IDENT_MAX_LAG ||
+        ident_correlation[peak] < SHAPER_IDENT_MIN_CORRELATION * ident_correlation[0])
+    {
+        return JOB_FAILED;
+    }
+
+    float before = ident_correlation[peak - 1];
+    float after = ident_correlation[peak + 1];
+    float curvature = before - 2.0f * ident_correlation[peak] + after;
+    float period = (float) peak;
+    if (curvature < 0.0f)
+    {
+        period += 0.5f * (before - after) / curvature;
+    }
+    *frequency = 1.0f / (period * (float) Ta);
+    if (*frequency < SHAPER_MIN_FREQUENCY || *frequency > SHAPER_MAX_FREQUENCY)
+    {
+        return JOB_FAILED;
+    }
+    return JOB_DONE;
+}
@@ -0,0 +1,101 @@
+#include "simulation.h"
+#include "config.h"
+#include "controller.h"
+#include "protocol.h"
+
+/*
+ * Hardware-in-the-loop mode: the real receiver input and ESC output are used, but the position is
+ * the one of the plant model instead of the Hall sensor.
+ */
+static plantparams_t params;
+static plantstate_t state;
+static uint8_t active = 0;
+
+/*
+ * The Hall sensor position when the simulation got started, restored when it ends
+ */
+static uint32_t encoder_saved;
+
+void initSimulation()
+{
+    initPlantParams(&params);
+    active = 0;
+}
+
+/** \brief Start or stop the simulation
+ *
+ * While the simulation is active, the encoder does not count the Hall sensor signals. Instead the counter is
+ * set to the plant position every cycle, so the controller, the position triggers and all commands see the
+ * simulated position without knowing it is one.
+ * It can be started only while the ESC output is neutral, as the plant starts with the cablecam standing still.
+ * When stopped, the encoder continues from the position it had when the simulation was started.
+ *
+ * \param enable uint8_t 1 to start, 0 to stop
+ * \return int8_t 0 if ok, -1 if the ESC is not in neutral
+ *
+ */
+int8_t setSimulation(uint8_t enable)
+{
+    if (enable && !active)
+    {
+        if (TIM3->CCR3 != activesettings.esc_neutral_pos)
+        {
+            return -1;
+        }
+        TIM5->CR1 &= ~TIM_CR1_CEN;
+        encoder_saved = ENCODER_VALUE;
+        resetPlant(&state, &params, (int32_t) encoder_saved);
+        active = 1;
+    }
+    else if (!enable && active)
+    {
+        active = 0;
+        ENCODER_VALUE = encoder_saved;
+        TIM5->CR1 |= TIM_CR1_CEN;
+        resetPosition();
+    }
+    return 0;
+}
+
+uint8_t isSimulationActive()
+{
+    return active;
+}
+
+plantparams_t * getSimulationParams()
+{
+    return &params;
+}
+
+const plantstate_t * getSimulationState()
+{
+    return &state;
+}
+
+/** \brief Advance the plant by one controller cycle, called right before controllercycle()
+ *
+ * The plant is driven by the ESC value the previous cycle has set, just like the real ESC.
+ * As the counter is written and not counted, the compare units do not see the position passing a trigger.
+ * Hence the compare event is generated by software in that case.
+ *
+ * \return void
+ *
+ */
+void simulationCycle()
+{
+    if (!active)
+    {
+        return;
+    }
+    stepPlant(&state, &params, (int16_t) TIM3->CCR3, (float) Ta);
+    ENCODER_VALUE = (uint32_t) state.counter;
+
+    if ((TIM5->DIER & TIM_DIER_CC3IE) && state.counter >= (int32_t) TIM5->CCR3)
+    {
+        TIM5->EGR = TIM_EGR_CC3G;
+    }
+    else if ((TIM5->DIER & TIM_DIER_CC4IE) && state.counter <= (int32_t) TIM5->CCR4)
+    {
+        TIM5->EGR = TIM_EGR_CC4G;
+    }
+}
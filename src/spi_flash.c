@@ -62,6 +62,20 @@ uint8_t command[4];
  * @retval None
  */
 void sFLASH_EraseSector(uint32_t SectorAddr)
+{
+    sFLASH_StartEraseSector(SectorAddr);
+
+    /*!< Wait the end of Flash writing */
+    sFLASH_WaitForWriteEnd();
+}
+
+/**
+ * @brief  Starts the erase of the specified FLASH sector without waiting for its end.
+ * @note   The erase takes hundreds of ms, use sFLASH_IsWriteInProgress() to poll for its end.
+ * @param  SectorAddr: address of the sector to erase.
+ * @retval None
+ */
+void sFLASH_StartEraseSector(uint32_t SectorAddr)
 {
     /*!< Send write enable instruction */
     sFLASH_WriteEnable();
@@ -92,9 +106,6 @@ void sFLASH_EraseSector(uint32_t SectorAddr)
     }
     /*!< Deselect the FLASH: Chip Select high */
     sFLASH_CS_HIGH();
-
-    /*!< Wait the end of Flash writing */
-    sFLASH_WaitForWriteEnd();
 }
 
 /**
@@ -147,6 +158,24 @@ void sFLASH_EraseBulk(void)
  * @retval None
  */
 void sFLASH_WritePage(uint8_t* pBuffer, uint32_t WriteAddr,	uint16_t NumByteToWrite)
+{
+    sFLASH_StartWritePage(pBuffer, WriteAddr, NumByteToWrite);
+
+    /*!< Wait the end of Flash writing */
+    sFLASH_WaitForWriteEnd();
+}
+
+/**
+ * @brief  Same as sFLASH_WritePage() but returns without waiting for the page
+ *         program cycle to finish, use sFLASH_IsWriteInProgress() to poll for its end.
+ * @param  pBuffer: pointer to the buffer  containing the data to be written
+ *         to the FLASH.
+ * @param  WriteAddr: FLASH's internal address to write to.
+ * @param  NumByteToWrite: number of bytes to write to the FLASH, must be equal
+ *         or less than "sFLASH_PAGESIZE" value.
+ * @retval None
+ */
+void sFLASH_StartWritePage(uint8_t* pBuffer, uint32_t WriteAddr, uint16_t NumByteToWrite)
 {
 
     /*!< Enable the write access to the FLASH */
@@ -197,9 +226,6 @@ void sFLASH_WritePage(uint8_t* pBuffer, uint32_t WriteAddr,	uint16_t NumByteToWr
 
     /*!< Deselect the FLASH: Chip Select high */
     sFLASH_CS_HIGH();
-
-    /*!< Wait the end of Flash writing */
-    sFLASH_WaitForWriteEnd();
 }
 
 /**
@@ -388,11 +414,11 @@ void sFLASH_ReadBuffer(uint8_t* pBuffer, uint32_t ReadAddr,	uint32_t NumByteToRe
         break;
     }
 
-    command[0] = sFLASH_DUMMY_BYTE;
-    while (NumByteToRead--) /*!< while there is data to be read */
+    while (NumByteToRead > 0) /*!< while there is data to be read */
     {
-        /*!< Read a byte from the FLASH */
-        switch(HAL_SPI_TransmitReceive(&hspi3, &command[0], pBuffer, 1, 5000))
+        /*!< Read the data as one block, whatever is sent meanwhile is ignored by the FLASH */
+        uint16_t blocksize = (NumByteToRead > 0xFFFF ? 0xFFFF : NumByteToRead);
+        switch(HAL_SPI_Receive(&hspi3, pBuffer, blocksize, 5000))
         {
         case HAL_TIMEOUT:
             /* A Timeout Occur ______________________________________________________*/
@@ -407,8 +433,9 @@ void sFLASH_ReadBuffer(uint8_t* pBuffer, uint32_t ReadAddr,	uint32_t NumByteToRe
         default:
             break;
         }
-        /*!< Point to the next location where the byte read will be saved */
-        pBuffer++;
+        /*!< Point to the next location where the next block will be saved */
+        pBuffer += blocksize;
+        NumByteToRead -= blocksize;
     }
 
     /*!< Deselect the FLASH: Chip Select high */
@@ -573,3 +600,36 @@ void sFLASH_WaitForWriteEnd(void)
     /*!< Deselect the FLASH: Chip Select high */
     sFLASH_CS_HIGH();
 }
+
+/**
+ * @brief  Reads the Write In Progress (WIP) flag of the FLASH's status register once.
+ * @param  None
+ * @retval 1 if an erase or write operation is still running, 0 if the FLASH is ready
+ */
+uint8_t sFLASH_IsWriteInProgress(void)
+{
+    uint8_t flashstatus = 0;
+
+    /*!< Select the FLASH: Chip Select low */
+    sFLASH_CS_LOW();
+
+    /*!< Send "Read Status Register" instruction */
+    command[0] = sFLASH_CMD_RDSR;
+    if (HAL_SPI_Transmit(&hspi3, &command[0], 1, 5000) != HAL_OK)
+    {
+        sFLASH_CS_HIGH();
+        return 1;
+    }
+
+    command[0] = sFLASH_DUMMY_BYTE;
+    if (HAL_SPI_TransmitReceive(&hspi3, &command[0], &flashstatus, 1, 5000) != HAL_OK)
+    {
+        sFLASH_CS_HIGH();
+        return 1;
+    }
+
+    /*!< Deselect the FLASH: Chip Select high */
+    sFLASH_CS_HIGH();
+
+    return (flashstatus & sFLASH_WIP_FLAG) == SET;
+}
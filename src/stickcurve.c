@@ -0,0 +1,93 @@
+#include "stickcurve.h"
+
+static char * stickcurve_labels[] = {"linear", "expo", "custom"};
+
+char * getStickCurveLabel(uint8_t type)
+{
+    if (type > STICKCURVE_CUSTOM)
+    {
+        return "???";
+    }
+    return stickcurve_labels[type];
+}
+
+/** \brief The curve at stick position x as part of the full output
+ *
+ * \param curve const stickcurve_t*
+ * \param x float 0..1
+ * \return float 0..1
+ *
+ */
+static float evaluateCurve(const stickcurve_t * curve, float x)
+{
+    switch (curve->type)
+    {
+    case STICKCURVE_EXPO:
+        return x * (1.0f - curve->expo) + x * x * x * curve->expo;
+    case STICKCURVE_CUSTOM:
+    {
+        /* the breakpoints with the fixed 0 and 1000 permille at both ends */
+        float position = x * (STICKCURVE_POINTS + 1);
+        uint8_t i = (uint8_t) position;
+        if (i >= STICKCURVE_POINTS + 1)
+        {
+            return 1.0f;
+        }
+        float a = (i == 0) ? 0.0f : curve->points[i - 1];
+        float b = (i == STICKCURVE_POINTS) ? 1000.0f : curve->points[i];
+        return (a + (position - i) * (b - a)) / 1000.0f;
+    }
+    default:
+        return x;
+    }
+}
+
+/** \brief Calculate the lookup table for a curve, to be done whenever the curve or the range changes
+ *
+ * Evaluating the curve for the stick value every cycle would cost a cubic or a search, the table makes it
+ * a single interpolation. The table is made monotonic, so a curve can never reverse the stick direction.
+ *
+ * \param lut int16_t* STICKCURVE_LUT_SIZE + 1 output values in 0.1us units like all stick values within the controller
+ * \param curve const stickcurve_t*
+ * \param range int16_t stick value at full deflection
+ * \return void
+ *
+ */
+void compileStickCurve(int16_t * lut, const stickcurve_t * curve, int16_t range)
+{
+    uint8_t i;
+    lut[0] = 0;
+    for (i = 1; i <= STICKCURVE_LUT_SIZE; i++)
+    {
+        float y = evaluateCurve(curve, ((float) i) / STICKCURVE_LUT_SIZE);
+        lut[i] = (int16_t) (y * range * 10 + 0.5f);
+        if (lut[i] < lut[i - 1])
+        {
+            lut[i] = lut[i - 1];
+        }
+    }
+}
+
+/** \brief Apply the curve to the stick value, the same for both directions
+ *
+ * \param lut const int16_t* the table calculated by compileStickCurve()
+ * \param scale float STICKCURVE_LUT_SIZE / range
+ * \param range int16_t stick value at full deflection, values above are passed through unchanged
+ * \param value int16_t stick value as returned by getStickPositionRaw()
+ * \return int16_t the stick value in 0.1us units, so the flat part of a curve near neutral keeps its resolution
+ *
+ */
+int16_t applyStickCurve(const int16_t * lut, float scale, int16_t range, int16_t value)
+{
+    int16_t magnitude = (value < 0) ? -value : value;
+    int16_t output;
+
+    if (magnitude >= range)
+    {
+        return value * 10;
+    }
+    float x = magnitude * scale;
+    uint8_t i = (uint8_t) x;
+    output = lut[i] + (int16_t) ((x - i) * (lut[i + 1] - lut[i]) + 0.5f);
+    return (value < 0) ? -output : output;
+}
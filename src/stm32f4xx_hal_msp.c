@@ -48,12 +48,15 @@
   */
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f4xx_hal.h"
+#include "config.h"
 
 extern DMA_HandleTypeDef hdma_usart1_rx;
 extern DMA_HandleTypeDef hdma_usart2_rx;
 extern DMA_HandleTypeDef hdma_usart2_tx;
 extern DMA_HandleTypeDef hdma_usart3_rx;
 extern DMA_HandleTypeDef hdma_usart3_tx;
+extern DMA_HandleTypeDef hdma_spi1_rx;
+extern DMA_HandleTypeDef hdma_spi1_tx;
 extern void _Error_Handler(char *, int);
 
 /**
@@ -77,7 +80,7 @@ void HAL_MspInit(void)
     /* PendSV_IRQn interrupt configuration */
     HAL_NVIC_SetPriority(PendSV_IRQn, 0, 0);
     /* SysTick_IRQn interrupt configuration */
-    HAL_NVIC_SetPriority(SysTick_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(SysTick_IRQn, NVIC_PRIORITY_SYSTICK, 0);
 }
 
 void HAL_RTC_MspInit(RTC_HandleTypeDef* hrtc)
@@ -110,17 +113,61 @@ void HAL_SPI_MspInit(SPI_HandleTypeDef* hspi)
         __HAL_RCC_SPI1_CLK_ENABLE();
 
         /**SPI1 GPIO Configuration
-        PA4     ------> SPI1_NSS
+        PA4     ------> MPU6000 chip select, as GPIO
         PA5     ------> SPI1_SCK
         PA6     ------> SPI1_MISO
         PA7     ------> SPI1_MOSI
         */
-        GPIO_InitStruct.Pin = GPIO_PIN_4|GPIO_PIN_5|GPIO_PIN_6|GPIO_PIN_7;
+        HAL_GPIO_WritePin(GPIOA, GPIO_PIN_4, GPIO_PIN_SET);
+        GPIO_InitStruct.Pin = GPIO_PIN_4;
+        GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+        GPIO_InitStruct.Pull = GPIO_NOPULL;
+        GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+        HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+        GPIO_InitStruct.Pin = GPIO_PIN_5|GPIO_PIN_6|GPIO_PIN_7;
         GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
         GPIO_InitStruct.Pull = GPIO_NOPULL;
         GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
         GPIO_InitStruct.Alternate = GPIO_AF5_SPI1;
         HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+        /* SPI1 DMA Init, used for the FIFO bursts of the IMU */
+        /* SPI1_RX Init */
+        hdma_spi1_rx.Instance = DMA2_Stream0;
+        hdma_spi1_rx.Init.Channel = DMA_CHANNEL_3;
+        hdma_spi1_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+        hdma_spi1_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+        hdma_spi1_rx.Init.MemInc = DMA_MINC_ENABLE;
+        hdma_spi1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+        hdma_spi1_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+        hdma_spi1_rx.Init.Mode = DMA_NORMAL;
+        hdma_spi1_rx.Init.Priority = DMA_PRIORITY_LOW;
+        hdma_spi1_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+        if (HAL_DMA_Init(&hdma_spi1_rx) != HAL_OK)
+        {
+            _Error_Handler(__FILE__, __LINE__);
+        }
+
+        __HAL_LINKDMA(hspi,hdmarx,hdma_spi1_rx);
+
+        /* SPI1_TX Init */
+        hdma_spi1_tx.Instance = DMA2_Stream3;
+        hdma_spi1_tx.Init.Channel = DMA_CHANNEL_3;
+        hdma_spi1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+        hdma_spi1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+        hdma_spi1_tx.Init.MemInc = DMA_MINC_ENABLE;
+        hdma_spi1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+        hdma_spi1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+        hdma_spi1_tx.Init.Mode = DMA_NORMAL;
+        hdma_spi1_tx.Init.Priority = DMA_PRIORITY_LOW;
+        hdma_spi1_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+        if (HAL_DMA_Init(&hdma_spi1_tx) != HAL_OK)
+        {
+            _Error_Handler(__FILE__, __LINE__);
+        }
+
+        __HAL_LINKDMA(hspi,hdmatx,hdma_spi1_tx);
     }
     else if(hspi->Instance==SPI3)
     {
@@ -167,6 +214,9 @@ void HAL_SPI_MspDeInit(SPI_HandleTypeDef* hspi)
         PA7     ------> SPI1_MOSI
         */
         HAL_GPIO_DeInit(GPIOA, GPIO_PIN_4|GPIO_PIN_5|GPIO_PIN_6|GPIO_PIN_7);
+
+        HAL_DMA_DeInit(hspi->hdmarx);
+        HAL_DMA_DeInit(hspi->hdmatx);
     }
     else if(hspi->Instance==SPI3)
     {
@@ -214,6 +264,10 @@ void HAL_TIM_Encoder_MspInit(TIM_HandleTypeDef* htim_encoder)
         GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
         GPIO_InitStruct.Alternate = GPIO_AF2_TIM5;
         HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+        /* TIM5 interrupt Init, used by the position triggers */
+        HAL_NVIC_SetPriority(TIM5_IRQn, NVIC_PRIORITY_ENCODER, 0);
+        HAL_NVIC_EnableIRQ(TIM5_IRQn);
     }
 }
 
@@ -237,7 +291,7 @@ void HAL_TIM_Base_MspInit(TIM_HandleTypeDef* htim_base)
         HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
         /* TIM1 interrupt Init */
-        HAL_NVIC_SetPriority(TIM1_CC_IRQn, 0, 0);
+        HAL_NVIC_SetPriority(TIM1_CC_IRQn, NVIC_PRIORITY_RC_INPUT, 0);
         HAL_NVIC_EnableIRQ(TIM1_CC_IRQn);
     }
 }
@@ -328,7 +382,7 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
         __HAL_LINKDMA(huart,hdmarx,hdma_usart1_rx);
 
         /* USART1 interrupt Init */
-        HAL_NVIC_SetPriority(USART1_IRQn, 0, 0);
+        HAL_NVIC_SetPriority(USART1_IRQn, NVIC_PRIORITY_RC_INPUT, 0);
         HAL_NVIC_EnableIRQ(USART1_IRQn);
     }
     else if(huart->Instance==USART2)
@@ -356,7 +410,7 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
         hdma_usart2_rx.Init.MemInc = DMA_MINC_ENABLE;
         hdma_usart2_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
         hdma_usart2_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
-        hdma_usart2_rx.Init.Mode = DMA_NORMAL;
+        hdma_usart2_rx.Init.Mode = DMA_CIRCULAR;
         hdma_usart2_rx.Init.Priority = DMA_PRIORITY_LOW;
         hdma_usart2_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
         if (HAL_DMA_Init(&hdma_usart2_rx) != HAL_OK)
@@ -385,7 +439,7 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
         __HAL_LINKDMA(huart,hdmatx,hdma_usart2_tx);
 
         /* USART2 interrupt Init */
-        HAL_NVIC_SetPriority(USART2_IRQn, 0, 0);
+        HAL_NVIC_SetPriority(USART2_IRQn, NVIC_PRIORITY_SERIAL, 0);
         HAL_NVIC_EnableIRQ(USART2_IRQn);
     }
     else if(huart->Instance==USART3)
@@ -413,7 +467,7 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
         hdma_usart3_rx.Init.MemInc = DMA_MINC_ENABLE;
         hdma_usart3_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
         hdma_usart3_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
-        hdma_usart3_rx.Init.Mode = DMA_NORMAL;
+        hdma_usart3_rx.Init.Mode = DMA_CIRCULAR;
         hdma_usart3_rx.Init.Priority = DMA_PRIORITY_LOW;
         hdma_usart3_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
         if (HAL_DMA_Init(&hdma_usart3_rx) != HAL_OK)
@@ -442,7 +496,7 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
         __HAL_LINKDMA(huart,hdmatx,hdma_usart3_tx);
 
         /* USART3 interrupt Init */
-        HAL_NVIC_SetPriority(USART3_IRQn, 0, 0);
+        HAL_NVIC_SetPriority(USART3_IRQn, NVIC_PRIORITY_SERIAL, 0);
         HAL_NVIC_EnableIRQ(USART3_IRQn);
     }
 }
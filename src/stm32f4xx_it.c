@@ -37,6 +37,10 @@
 
 /* USER CODE BEGIN 0 */
 #include "sbus.h"
+#include "postrigger.h"
+#include "posbackup.h"
+#include "profiler.h"
+#include "uart.h"
 
 /* USER CODE END 0 */
 
@@ -47,6 +51,8 @@ extern DMA_HandleTypeDef hdma_usart2_rx;
 extern DMA_HandleTypeDef hdma_usart2_tx;
 extern DMA_HandleTypeDef hdma_usart3_rx;
 extern DMA_HandleTypeDef hdma_usart3_tx;
+extern DMA_HandleTypeDef hdma_spi1_rx;
+extern DMA_HandleTypeDef hdma_spi1_tx;
 extern UART_HandleTypeDef huart1;
 extern UART_HandleTypeDef huart2;
 extern UART_HandleTypeDef huart3;
@@ -257,7 +263,9 @@ void DMA1_Stream6_IRQHandler(void)
 void USART1_IRQHandler(void)
 {
     /* USER CODE BEGIN USART1_IRQn 0 */
+    PROFILER_ENTER();
     SBUS_IRQHandler(&huart1);
+    PROFILER_EXIT(PROBE_SBUS_IRQ);
     /* USER CODE END USART1_IRQn 0 */
     /* HAL_UART_IRQHandler(&huart1); */
     /* USER CODE BEGIN USART1_IRQn 1 */
@@ -271,6 +279,7 @@ void USART1_IRQHandler(void)
 void USART2_IRQHandler(void)
 {
     /* USER CODE BEGIN USART2_IRQn 0 */
+    UART_IdleHandler(&huart2);
 
     /* USER CODE END USART2_IRQn 0 */
     HAL_UART_IRQHandler(&huart2);
@@ -285,6 +294,7 @@ void USART2_IRQHandler(void)
 void USART3_IRQHandler(void)
 {
     /* USER CODE BEGIN USART3_IRQn 0 */
+    UART_IdleHandler(&huart3);
 
     /* USER CODE END USART3_IRQn 0 */
     HAL_UART_IRQHandler(&huart3);
@@ -293,6 +303,34 @@ void USART3_IRQHandler(void)
     /* USER CODE END USART3_IRQn 1 */
 }
 
+/**
+* @brief This function handles DMA2 stream0 global interrupt.
+*/
+void DMA2_Stream0_IRQHandler(void)
+{
+    /* USER CODE BEGIN DMA2_Stream0_IRQn 0 */
+
+    /* USER CODE END DMA2_Stream0_IRQn 0 */
+    HAL_DMA_IRQHandler(&hdma_spi1_rx);
+    /* USER CODE BEGIN DMA2_Stream0_IRQn 1 */
+
+    /* USER CODE END DMA2_Stream0_IRQn 1 */
+}
+
+/**
+* @brief This function handles DMA2 stream3 global interrupt.
+*/
+void DMA2_Stream3_IRQHandler(void)
+{
+    /* USER CODE BEGIN DMA2_Stream3_IRQn 0 */
+
+    /* USER CODE END DMA2_Stream3_IRQn 0 */
+    HAL_DMA_IRQHandler(&hdma_spi1_tx);
+    /* USER CODE BEGIN DMA2_Stream3_IRQn 1 */
+
+    /* USER CODE END DMA2_Stream3_IRQn 1 */
+}
+
 /**
 * @brief This function handles DMA2 stream2 global interrupt.
 */
@@ -314,9 +352,11 @@ void OTG_FS_IRQHandler(void)
 {
     /* USER CODE BEGIN OTG_FS_IRQn 0 */
 
+    PROFILER_ENTER();
     /* USER CODE END OTG_FS_IRQn 0 */
     HAL_PCD_IRQHandler(&hpcd_USB_OTG_FS);
     /* USER CODE BEGIN OTG_FS_IRQn 1 */
+    PROFILER_EXIT(PROBE_USB_IRQ);
 
     /* USER CODE END OTG_FS_IRQn 1 */
 }
@@ -328,12 +368,40 @@ void TIM1_CC_IRQHandler(void)
 {
     /* USER CODE BEGIN TIM1_CC_IRQn 0 */
 
+    PROFILER_ENTER();
     /* USER CODE END TIM1_CC_IRQn 0 */
     HAL_TIM_IRQHandler(&htim1);
     /* USER CODE BEGIN TIM1_CC_IRQn 1 */
+    PROFILER_EXIT(PROBE_PPM_IRQ);
 
     /* USER CODE END TIM1_CC_IRQn 1 */
 }
+
+/**
+* @brief This function handles TIM5 global interrupt.
+*/
+void TIM5_IRQHandler(void)
+{
+    /* USER CODE BEGIN TIM5_IRQn 0 */
+    PROFILER_ENTER();
+    POSTRIGGER_IRQHandler();
+    PROFILER_EXIT(PROBE_POSTRIGGER_IRQ);
+    /* USER CODE END TIM5_IRQn 0 */
+}
+
+/**
+* @brief This function handles PVD interrupt through EXTI line 16.
+*/
+void PVD_IRQHandler(void)
+{
+    /* USER CODE BEGIN PVD_IRQn 0 */
+
+    /* USER CODE END PVD_IRQn 0 */
+    HAL_PWR_PVD_IRQHandler();
+    /* USER CODE BEGIN PVD_IRQn 1 */
+
+    /* USER CODE END PVD_IRQn 1 */
+}
 /* USER CODE BEGIN 1 */
 
 /* USER CODE END 1 */
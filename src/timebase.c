@@ -0,0 +1,20 @@
+#include "timebase.h"
+#include "stm32f4xx_hal.h"
+
+/** \brief Start TIM2 counting microseconds over its full 32 bit range
+ *
+ * No interrupt is needed, reading the counter register is all it takes to get the time.
+ *
+ * \return void
+ *
+ */
+void initTimebase()
+{
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    TIM2->CR1 = 0;
+    TIM2->PSC = SystemCoreClock / 1000000 - 1;  // the APB1 timers run with the core clock, see SystemClock_Config()
+    TIM2->ARR = 0xFFFFFFFF;
+    TIM2->CNT = 0;
+    TIM2->EGR = TIM_EGR_UG;                     // load the prescaler
+    TIM2->CR1 = TIM_CR1_CEN;
+}
@@ -0,0 +1,132 @@
+#include "tracking.h"
+#include "config.h"
+#include "controller.h"
+#include "math.h"
+
+/*
+ * The pulse width output the previous cycle, the rate limiter moves it towards the wanted one.
+ */
+static float pulse = SERVO_CENTER;
+
+/** \brief Calculate the angle table for aiming the yaw servo at the target
+ *
+ * The target is at the position along the rope and the distance sideways. At a position x the camera has to
+ * turn by atan((target - x) / distance) from the perpendicular. All trigonometry happens here, whenever the
+ * settings change, the controller only interpolates within the table.
+ *
+ * \param tracking trackingplan_t* The plan to compile into
+ * \param active uint8_t 1 to track the target
+ * \param target int32_t Hall sensor position of the point on the rope next to the target
+ * \param distance double meters from the rope to the target, the sign selects the side
+ * \param steps_per_meter double Hall sensor steps per meter
+ * \param us_per_degree double servo pulse width change per degree, the sign selects the servo direction
+ * \param max_rate double degrees per second the servo turns at most
+ * \return void
+ *
+ */
+void compileTracking(trackingplan_t * tracking, uint8_t active, int32_t target, double distance, double steps_per_meter,
+                     double us_per_degree, double max_rate)
+{
+    uint16_t i;
+    float span = (float) (TRACKING_TABLE_SPAN * fabs(distance) * steps_per_meter);
+
+    tracking->active = active && distance != 0.0 && steps_per_meter > 0.0;
+    if (!tracking->active)
+    {
+        return;
+    }
+    tracking->start = target - (int32_t) span;
+    tracking->scale = TRACKING_TABLE_SIZE / (2.0f * span);
+    tracking->max_rate = (float) (max_rate * fabs(us_per_degree) * Ta);
+    for (i = 0; i <= TRACKING_TABLE_SIZE; i++)
+    {
+        /* (target - x) / distance at the table entry */
+        float ratio = TRACKING_TABLE_SPAN * (1.0f - 2.0f * i / TRACKING_TABLE_SIZE);
+        if (distance < 0.0)
+        {
+            ratio = -ratio;
+        }
+        float value = SERVO_CENTER + atanf(ratio) * (float) (180.0 / M_PI * us_per_degree);
+        if (value < SERVO_MIN)
+        {
+            value = SERVO_MIN;
+        }
+        else if (value > SERVO_MAX)
+        {
+            value = SERVO_MAX;
+        }
+        tracking->table[i] = (int16_t) value;
+    }
+}
+
+/** \brief The yaw servo pulse width for the current position, called every controller cycle
+ *
+ * \param tracking const trackingplan_t*
+ * \param pos int32_t current Hall sensor position
+ * \param override int16_t the manual yaw stick with the neutral range removed, when not 0 it turns the servo instead
+ * \return uint16_t servo pulse width in us, rate limited and within SERVO_MIN..SERVO_MAX
+ *
+ */
+uint16_t trackingCycle(const trackingplan_t * tracking, int32_t pos, int16_t override)
+{
+    float value;
+
+    if (override != 0)
+    {
+        value = SERVO_CENTER + override;
+    }
+    else
+    {
+        float x = (pos - tracking->start) * tracking->scale;
+        if (x <= 0.0f)
+        {
+            value = tracking->table[0];
+        }
+        else if (x >= TRACKING_TABLE_SIZE)
+        {
+            value = tracking->table[TRACKING_TABLE_SIZE];
+        }
+        else
+        {
+            uint16_t i = (uint16_t) x;
+            value = tracking->table[i] + (x - i) * (tracking->table[i + 1] - tracking->table[i]);
+        }
+    }
+
+    if (value > pulse + tracking->max_rate)
+    {
+        value = pulse + tracking->max_rate;
+    }
+    else if (value < pulse - tracking->max_rate)
+    {
+        value = pulse - tracking->max_rate;
+    }
+    if (value < SERVO_MIN)
+    {
+        value = SERVO_MIN;
+    }
+    else if (value > SERVO_MAX)
+    {
+        value = SERVO_MAX;
+    }
+    pulse = value;
+    return (uint16_t) (pulse + 0.5f);
+}
+
+/** \brief Start the rate limiter from the pulse width the servo output has currently, used while not tracking
+ *
+ * \param current uint16_t the servo pulse width, the center is used if it is no valid servo pulse
+ * \return void
+ *
+ */
+void resetTracking(uint16_t current)
+{
+    if (current >= SERVO_MIN && current <= SERVO_MAX)
+    {
+        pulse = current;
+    }
+    else
+    {
+        pulse = SERVO_CENTER;
+    }
+}
@@ -0,0 +1,136 @@
+#include "traction.h"
+#include "controller.h"
+#include "protocol.h"
+#include "simulation.h"
+#include "imu.h"
+#include "accelwindow.h"
+
+static tractionstate_t state = {.scale = 1.0f};
+
+/*
+ * Without an IMU the plant model predicts the acceleration the cablecam should have with the ESC output of the
+ * previous cycle, the difference to the acceleration of the wheel over the window is the slip.
+ */
+static plantstate_t model;
+static accelwindow_t window;
+
+/** \brief Detect the wheel slipping and adapt the acceleration limit, called every controller cycle
+ *
+ * With an IMU the slip is the difference between the acceleration of the wheel and the one of the carriage
+ * the IMU measures. Without, the acceleration of the wheel is compared with the one the plant model of the
+ * simulation ($H) expects for the ESC output, so the plant parameters should match the cablecam. Both are taken
+ * over ACCEL_WINDOW_CYCLES, within a single cycle one Hall sensor step would look like a slip already.
+ * Every cycle the slip exceeds the traction_slip_threshold, the acceleration limit is reduced, afterwards it
+ * slowly recovers. A wheel that slipped counted wrong, so the position is flagged as degraded then.
+ *
+ * \param pos int32_t current Hall sensor position
+ * \param esc uint16_t the ESC pulse width set by the previous cycle
+ * \return void
+ *
+ */
+void tractionCycle(int32_t pos, uint16_t esc)
+{
+    const imustate_t * imu = getIMUState();
+    const plantparams_t * params = getSimulationParams();
+    float steps_per_meter = (float) activesettings.hall_steps_per_meter;
+
+    if (imu->present)
+    {
+        state.slip = imu->slip;
+    }
+    else
+    {
+        /* the prediction starts from the measured state, the speed of the window is free of the Hall sensor steps */
+        float speed = getWindowSpeed(&window, steps_per_meter);
+        float wheel;
+        float expected;
+        model.position = ((float) pos) / steps_per_meter;
+        model.speed = speed;
+        stepPlant(&model, params, (int16_t) esc, (float) Ta);
+        addAccelWindow(&window, pos, (model.speed - speed) / (float) Ta);
+        if (getWindowAcceleration(&window, steps_per_meter, &wheel, &expected) == 0)
+        {
+            float slip = wheel - expected;
+            if (speed < 0.0f)
+            {
+                slip = -slip;
+            }
+            state.slip = TRACTION_SLIP_FILTER * state.slip + (1.0f - TRACTION_SLIP_FILTER) * slip;
+        }
+    }
+
+    if (activesettings.traction_slip_threshold > 0.0f &&
+        (state.slip > activesettings.traction_slip_threshold || state.slip < -activesettings.traction_slip_threshold))
+    {
+        if (!state.slipping)
+        {
+            slipevent_t * event = &state.log[state.log_position];
+            event->tick = HAL_GetTick();
+            event->pos = pos;
+            event->slip = state.slip;
+            state.log_position = (state.log_position + 1) % TRACTION_LOG_SIZE;
+            state.events++;
+            state.slipping = 1;
+            controllerstatus.position_degraded = 1;
+        }
+        state.scale *= TRACTION_REDUCE;
+        if (state.scale < TRACTION_MIN_SCALE)
+        {
+            state.scale = TRACTION_MIN_SCALE;
+        }
+    }
+    else
+    {
+        state.slipping = 0;
+        state.scale += TRACTION_RECOVER;
+        if (state.scale > 1.0f)
+        {
+            state.scale = 1.0f;
+        }
+    }
+}
+
+/** \brief Continue from a new position without seeing the jump as slip, e.g. after the encoder value got set
+ *
+ * \return void
+ *
+ */
+void resyncTraction()
+{
+    resetAccelWindow(&window);
+    state.slip = 0.0f;
+}
+
+/** \brief The acceleration limit reduced by the traction control
+ *
+ * \param max_accel int16_t The configured limit
+ * \return int16_t The limit to use this cycle, at least 1
+ *
+ */
+int16_t limitTractionAccel(int16_t max_accel)
+{
+    int16_t limit = (int16_t) (max_accel * state.scale);
+    return (limit < 1) ? 1 : limit;
+}
+
+const tractionstate_t * getTractionState()
+{
+    return &state;
+}
+
+/** \brief Clear the slip log and the degraded flag of the position, e.g. after the position was verified
+ *
+ * \return void
+ *
+ */
+void clearTraction()
+{
+    uint8_t i;
+    for (i = 0; i < TRACTION_LOG_SIZE; i++)
+    {
+        state.log[i].tick = 0;
+    }
+    state.log_position = 0;
+    state.events = 0;
+    controllerstatus.position_degraded = 0;
+}
@@ -0,0 +1,309 @@
+#include "uart.h"
+#include "scheduler.h"
+#include "setpoint.h"
+#include "string.h"
+
+extern UART_HandleTypeDef huart2;
+extern UART_HandleTypeDef huart3;
+
+/** \brief One uart endpoint with its receive and transmit buffers
+ *
+ * The DMA writes the received bytes into rxbuffer in circular mode, the command task picks them up from rx_read
+ * up to the DMA position. The output is collected in the txbuffer ring, bytes_written and bytes_sent are absolute
+ * counts like for the USB transmit buffer. bytes_sent is advanced by the interrupt once a DMA transfer completed.
+ */
+typedef struct
+{
+    UART_HandleTypeDef * huart;
+    uint8_t rxbuffer[UART_RX_BUFFER_SIZE];
+    uint16_t rx_read;
+    char line[UART_LINE_SIZE];
+    uint16_t line_pos;
+    uint8_t line_overflow;
+    setpointdecoder_t setpointdecoder;
+    uint8_t txbuffer[UART_TX_BUFFER_SIZE];
+    uint32_t bytes_written;
+    volatile uint32_t bytes_sent;
+    volatile uint32_t bytes_in_transfer;
+    uartstats_t stats;
+} uartport_t;
+
+static uartport_t ports[2]; // UART3 (Flexi port) and UART2 (Servo3/4)
+
+static uartport_t * getPort(Endpoints endpoint)
+{
+    if (endpoint == EndPoint_UART3)
+    {
+        return &ports[0];
+    }
+    else if (endpoint == EndPoint_UART2)
+    {
+        return &ports[1];
+    }
+    return NULL;
+}
+
+static uartport_t * findPort(UART_HandleTypeDef * huart)
+{
+    if (huart == ports[0].huart)
+    {
+        return &ports[0];
+    }
+    else if (huart == ports[1].huart)
+    {
+        return &ports[1];
+    }
+    return NULL;
+}
+
+static void startReception(uartport_t * port)
+{
+    port->rx_read = 0;
+    HAL_UART_Receive_DMA(port->huart, port->rxbuffer, UART_RX_BUFFER_SIZE);
+    __HAL_UART_ENABLE_IT(port->huart, UART_IT_IDLE);
+}
+
+/** \brief Hand the next contiguous part of the transmit buffer to the DMA, if no transfer is running
+ *
+ * Called by the tasks and by the transmit complete interrupt. The tasks only start a transfer when none is
+ * running, hence no interrupt of this port can happen meanwhile.
+ *
+ * \param port uartport_t*
+ * \return void
+ *
+ */
+static void startTransfer(uartport_t * port)
+{
+    uint32_t buffptr = port->bytes_sent % UART_TX_BUFFER_SIZE;
+    uint32_t buffsize = port->bytes_written - port->bytes_sent;
+
+    if (port->bytes_in_transfer != 0 || buffsize == 0)
+    {
+        return;
+    }
+    if (buffptr + buffsize > UART_TX_BUFFER_SIZE)
+    {
+        buffsize = UART_TX_BUFFER_SIZE - buffptr;
+    }
+    port->bytes_in_transfer = buffsize;
+    if (HAL_UART_Transmit_DMA(port->huart, &port->txbuffer[buffptr], (uint16_t) buffsize) != HAL_OK)
+    {
+        port->bytes_in_transfer = 0;
+    }
+}
+
+/** \brief Start the circular DMA reception of both uarts
+ *
+ * \return void
+ *
+ */
+void initUARTPorts()
+{
+    ports[0].huart = &huart3;
+    ports[1].huart = &huart2;
+    startReception(&ports[0]);
+    startReception(&ports[1]);
+}
+
+/** \brief Extract the next line received by the uart, the counterpart of USB_ReceiveString()
+ *
+ * \param endpoint Endpoints EndPoint_UART3 or EndPoint_UART2
+ * \return char* the null terminated line including the line terminator, NULL if no complete line was received yet
+ *
+ */
+char * UART_ReceiveString(Endpoints endpoint)
+{
+    uartport_t * port = getPort(endpoint);
+    if (port == NULL || port->huart == NULL)
+    {
+        return NULL;
+    }
+    uint16_t received = (UART_RX_BUFFER_SIZE - __HAL_DMA_GET_COUNTER(port->huart->hdmarx)) % UART_RX_BUFFER_SIZE;
+
+    while (port->rx_read != received)
+    {
+        char c = port->rxbuffer[port->rx_read];
+        port->rx_read = (port->rx_read + 1) % UART_RX_BUFFER_SIZE;
+        port->stats.bytes_received++;
+        if (decodeSetpointByte(&port->setpointdecoder, c, port->line_pos == 0 && !port->line_overflow))
+        {
+            continue;
+        }
+        if (c == '\n' || c == '\r')
+        {
+            if (port->line_overflow)
+            {
+                // in case the string does not fit into the line, the entire line is ignored
+                port->stats.lines_dropped++;
+                port->line_overflow = 0;
+                port->line_pos = 0;
+            }
+            else
+            {
+                port->line[port->line_pos++] = c;
+                port->line[port->line_pos] = 0;
+                port->line_pos = 0;
+                return port->line;
+            }
+        }
+        else if (c == 0x08) // backspace char
+        {
+            if (port->line_pos > 0)
+            {
+                port->line_pos--;
+            }
+        }
+        else if (port->line_pos < UART_LINE_SIZE - 2)
+        {
+            port->line[port->line_pos++] = c;
+        }
+        else
+        {
+            port->line_overflow = 1;
+        }
+    }
+    return NULL;
+}
+
+/** \brief Queue the text for sending, never waits
+ *
+ * If the transmit buffer has no space left, e.g. because a slow Bluetooth link cannot keep up, the text is dropped
+ * and counted, so neither the USB output nor the controller are delayed.
+ *
+ * \param endpoint Endpoints EndPoint_UART3 or EndPoint_UART2
+ * \param ptr char* null terminated text
+ * \return void
+ *
+ */
+void UART_TransmitString(Endpoints endpoint, char * ptr)
+{
+    uartport_t * port = getPort(endpoint);
+    uint32_t len = strlen(ptr);
+    uint32_t rel_pos;
+
+    if (port == NULL || port->huart == NULL)
+    {
+        return;
+    }
+    if (len > UART_TX_BUFFER_SIZE - (port->bytes_written - port->bytes_sent))
+    {
+        port->stats.bytes_dropped += len;
+        return;
+    }
+    rel_pos = port->bytes_written % UART_TX_BUFFER_SIZE;
+    if (rel_pos + len > UART_TX_BUFFER_SIZE)
+    {
+        uint32_t l = UART_TX_BUFFER_SIZE - rel_pos;
+        memcpy(&port->txbuffer[rel_pos], ptr, l);
+        memcpy(port->txbuffer, &ptr[l], len - l);
+    }
+    else
+    {
+        memcpy(&port->txbuffer[rel_pos], ptr, len);
+    }
+    port->bytes_written += len;
+}
+
+/** \brief Send the buffered output of both uarts, the counterpart of USBPeriodElapsed()
+ *
+ * \return void
+ *
+ */
+void UARTPeriodElapsed()
+{
+    if (ports[0].huart != NULL)
+    {
+        startTransfer(&ports[0]);
+    }
+    if (ports[1].huart != NULL)
+    {
+        startTransfer(&ports[1]);
+    }
+}
+
+/** \brief Free space in the transmit buffer, see CDC_GetTxFree()
+ *
+ * \param endpoint Endpoints EndPoint_UART3 or EndPoint_UART2
+ * \return uint32_t number of bytes UART_TransmitString() can take right now
+ *
+ */
+uint32_t UART_GetTxFree(Endpoints endpoint)
+{
+    uartport_t * port = getPort(endpoint);
+    if (port == NULL)
+    {
+        return 0;
+    }
+    return UART_TX_BUFFER_SIZE - (port->bytes_written - port->bytes_sent);
+}
+
+const uartstats_t * getUARTStats(Endpoints endpoint)
+{
+    uartport_t * port = getPort(endpoint);
+    return (port == NULL) ? NULL : &port->stats;
+}
+
+/** \brief Called by the uart interrupt, a pause in the received data means a command line is likely complete
+ *
+ * \param huart UART_HandleTypeDef*
+ * \return void
+ *
+ */
+void UART_IdleHandler(UART_HandleTypeDef * huart)
+{
+    if (__HAL_UART_GET_FLAG(huart, UART_FLAG_IDLE))
+    {
+        __HAL_UART_CLEAR_IDLEFLAG(huart);
+        signalTask(TASK_COMMAND);
+    }
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef * huart)
+{
+    uartport_t * port = findPort(huart);
+    if (port != NULL)
+    {
+        port->bytes_sent += port->bytes_in_transfer;
+        port->stats.bytes_sent += port->bytes_in_transfer;
+        port->bytes_in_transfer = 0;
+        startTransfer(port);
+    }
+}
+
+/*
+ * The receive buffer is half or completely filled, process it before the DMA wraps around
+ */
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef * huart)
+{
+    signalTask(TASK_COMMAND);
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef * huart)
+{
+    signalTask(TASK_COMMAND);
+}
+
+/** \brief An overrun or another receive error stopped the DMA reception, restart it
+ *
+ * \param huart UART_HandleTypeDef*
+ * \return void
+ *
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef * huart)
+{
+    uartport_t * port = findPort(huart);
+    if (port != NULL)
+    {
+        port->stats.errors++;
+        if (huart->RxState == HAL_UART_STATE_READY)
+        {
+            startReception(port);
+        }
+        if (huart->gState == HAL_UART_STATE_READY && port->bytes_in_transfer != 0)
+        {
+            /* the transmission got aborted as well, send the data again */
+            port->bytes_in_transfer = 0;
+            startTransfer(port);
+        }
+    }
+}
@@ -49,6 +49,8 @@
 /* Includes ------------------------------------------------------------------*/
 #include "usbd_cdc_if.h"
 /* USER CODE BEGIN INCLUDE */
+#include "scheduler.h"
+#include "setpoint.h"
 /* USER CODE END INCLUDE */
 
 /** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
@@ -100,6 +102,7 @@
 
 char commandlinebuffer[RXBUFFERSIZE];
 uint16_t commandlinebuffer_pos = 0;
+static setpointdecoder_t setpointdecoder; // binary setpoint frames received via USB
 
 /* Create buffer for reception and transmission           */
 /* It's up to user to redefine and/or remove those define */
@@ -124,6 +127,7 @@ uint32_t BuffLength;
 
 uint32_t bytes_sent = 0;
 uint32_t bytes_written = 0;
+uint32_t bytes_in_transfer = 0; /* size of the last transfer, the buffer area is in use until the transfer is complete */
 /* USER CODE END PRIVATE_VARIABLES */
 
 /**
@@ -357,6 +361,7 @@ static int8_t CDC_Receive_FS (uint8_t* Buf, uint32_t *Len)
             memcpy(&rxbuffer[current_pos], Buf, len1);
         }
         bytes_received += len1;
+        signalTask(TASK_COMMAND);
     }
 
     /* Prepare for the next reception of data */
@@ -394,6 +399,10 @@ uint16_t USB_ReceiveString()
     {
         uint8_t c = rxbuffer[bytes_scanned % RXBUFFERSIZE];
         bytes_scanned++;
+        if (decodeSetpointByte(&setpointdecoder, c, commandlinebuffer_pos == 0))
+        {
+            continue; // part of a binary setpoint frame, not echoed
+        }
         CDC_TransmitBuffer((uint8_t *) &c, 1); // echo input text
         if (c == '\n' || c == '\r')
         {
@@ -514,12 +523,33 @@ void USBPeriodElapsed()
 
             if(USBD_CDC_TransmitPacket(&hUsbDeviceFS) == USBD_OK)
             {
+                /* Only if the transfer got started, else the previous one is still running and this data has to be sent next time */
+                bytes_sent += buffsize;
+                bytes_in_transfer = buffsize;
             }
-            bytes_sent += buffsize;
         }
     }
 }
 
+/** \brief Free space in the transmit buffer
+ *
+ * Data written beyond that would overwrite bytes not sent yet. Long outputs use this to
+ * write only as much as fits and continue once the buffer got sent.
+ *
+ * \return uint32_t number of bytes CDC_TransmitBuffer() can take right now
+ *
+ */
+uint32_t CDC_GetTxFree()
+{
+    USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceFS.pClassData;
+    uint32_t used = bytes_written - bytes_sent;
+    if (hcdc != NULL && hcdc->TxState != 0)
+    {
+        used += bytes_in_transfer;
+    }
+    return APP_TX_DATA_SIZE - used;
+}
+
 /* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
 /**
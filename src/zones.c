@@ -0,0 +1,199 @@
+#include "zones.h"
+#include "protocol.h"
+
+/** \brief Add a breakpoint to the activesettings, keeping them sorted by position
+ *
+ * A breakpoint at the same position is replaced.
+ *
+ * \param pos int32_t Hall sensor position
+ * \param max_speed int16_t
+ * \param max_accel int16_t
+ * \return int8_t 0 if ok, -1 if all SPEEDZONE_MAX breakpoints are used already
+ *
+ */
+int8_t addSpeedZone(int32_t pos, int16_t max_speed, int16_t max_accel)
+{
+    uint8_t i = 0;
+    while (i < activesettings.zone_count && activesettings.zones[i].pos < pos)
+    {
+        i++;
+    }
+    if (i == activesettings.zone_count || activesettings.zones[i].pos != pos)
+    {
+        uint8_t j;
+        if (activesettings.zone_count >= SPEEDZONE_MAX)
+        {
+            return -1;
+        }
+        for (j = activesettings.zone_count; j > i; j--)
+        {
+            activesettings.zones[j] = activesettings.zones[j - 1];
+        }
+        activesettings.zone_count++;
+    }
+    activesettings.zones[i].pos = pos;
+    activesettings.zones[i].max_speed = max_speed;
+    activesettings.zones[i].max_accel = max_accel;
+    return 0;
+}
+
+void clearSpeedZones()
+{
+    activesettings.zone_count = 0;
+}
+
+/** \brief The limits at a position, interpolated between the two breakpoints around it
+ *
+ * \param zones const speedzone_t* breakpoints sorted by position
+ * \param count uint8_t number of breakpoints, at least 1
+ * \param pos double
+ * \param zone_speed int16_t*
+ * \param zone_accel int16_t*
+ * \return void
+ *
+ */
+static void getZoneLimits(const speedzone_t * zones, uint8_t count, double pos, int16_t * zone_speed, int16_t * zone_accel)
+{
+    uint8_t i = 0;
+
+    while (i < count && zones[i].pos <= pos)
+    {
+        i++;
+    }
+    if (i == 0)
+    {
+        *zone_speed = zones[0].max_speed;
+        *zone_accel = zones[0].max_accel;
+    }
+    else if (i == count)
+    {
+        *zone_speed = zones[count - 1].max_speed;
+        *zone_accel = zones[count - 1].max_accel;
+    }
+    else
+    {
+        const speedzone_t * a = &zones[i - 1];
+        const speedzone_t * b = &zones[i];
+        float f = (float) ((pos - a->pos) / (b->pos - a->pos));
+        *zone_speed = a->max_speed + (int16_t) (f * (b->max_speed - a->max_speed));
+        *zone_accel = a->max_accel + (int16_t) (f * (b->max_accel - a->max_accel));
+    }
+}
+
+/** \brief The acceleration the cablecam can brake with all the way from one position to another
+ *
+ * As the limits are interpolated linearly, the lowest one along the way is at either position or a breakpoint in between.
+ *
+ * \param zones const speedzone_t* breakpoints sorted by position
+ * \param count uint8_t number of breakpoints, 0 for no zones
+ * \param from double current position
+ * \param to double position to stop at, e.g. an end point
+ * \param maxaccel int16_t the acceleration limit without zones
+ * \return int16_t the lowest acceleration limit along the way, at least 1
+ *
+ */
+int16_t getZoneBrakeAccel(const speedzone_t * zones, uint8_t count, double from, double to, int16_t maxaccel)
+{
+    int16_t zone_speed;
+    int16_t zone_accel;
+    double low = (from < to) ? from : to;
+    double high = (from < to) ? to : from;
+    uint8_t i;
+
+    if (count > 0)
+    {
+        getZoneLimits(zones, count, from, &zone_speed, &zone_accel);
+        if (zone_accel < maxaccel)
+        {
+            maxaccel = zone_accel;
+        }
+        getZoneLimits(zones, count, to, &zone_speed, &zone_accel);
+        if (zone_accel < maxaccel)
+        {
+            maxaccel = zone_accel;
+        }
+        for (i = 0; i < count; i++)
+        {
+            if (zones[i].pos > low && zones[i].pos < high && zones[i].max_accel < maxaccel)
+            {
+                maxaccel = zones[i].max_accel;
+            }
+        }
+    }
+    return (maxaccel < 1) ? 1 : maxaccel;
+}
+
+/** \brief Lower the speed and acceleration limits to the ones of the zone the cablecam is in or approaching
+ *
+ * The limits at the position are interpolated between the two breakpoints around it, before the first and
+ * after the last breakpoint the limits of that one apply. If a breakpoint ahead has a lower speed limit
+ * than the current stick value and the cablecam would pass it before the ramp got down to that limit, the
+ * ramp starts now, the same way the endpoint limiter brakes for the end points.
+ *
+ * \param zones const speedzone_t* breakpoints sorted by position, speeds multiplied by 10 like the stick values
+ * \param count uint8_t number of breakpoints, 0 for no zones
+ * \param pos double current position
+ * \param speed int32_t Hall sensor steps per cycle
+ * \param stick int16_t the stick value of the previous cycle
+ * \param maxspeed int16_t* the speed limit, lowered if the zone requires
+ * \param maxaccel int16_t* the acceleration limit, lowered if the zone requires
+ * \return void
+ *
+ */
+void limitSpeedZones(const speedzone_t * zones, uint8_t count, double pos, int32_t speed, int16_t stick, int16_t * maxspeed, int16_t * maxaccel)
+{
+    int16_t zone_speed;
+    int16_t zone_accel;
+    uint8_t i;
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    getZoneLimits(zones, count, pos, &zone_speed, &zone_accel);
+    if (zone_speed < *maxspeed)
+    {
+        *maxspeed = zone_speed;
+    }
+    if (zone_accel < *maxaccel)
+    {
+        *maxaccel = (zone_accel < 1) ? 1 : zone_accel;
+    }
+
+    /*
+     * Look ahead in the direction of motion. Ramping down from stick to the zone limit takes (stick - limit)/maxaccel
+     * cycles, with the speed decreasing linearly from the current one to the part limit/stick of it.
+     */
+    if (stick < 0)
+    {
+        stick = -stick;
+    }
+    float speed_abs = (float) ((speed < 0) ? -speed : speed);
+    if (stick == 0 || speed == 0)
+    {
+        return;
+    }
+    for (i = 0; i < count; i++)
+    {
+        double distance = (speed > 0) ? zones[i].pos - pos : pos - zones[i].pos;
+        int16_t limit = zones[i].max_speed;
+        if (distance > 0.0 && limit < stick)
+        {
+            float cycles = ((float) (stick - limit)) / *maxaccel;
+            float brakedistance = speed_abs * cycles * ((float) (stick + limit)) / (2.0f * stick);
+            if (brakedistance >= distance)
+            {
+                int16_t ramp = stick - *maxaccel;
+                if (ramp < limit)
+                {
+                    ramp = limit;
+                }
+                if (ramp < *maxspeed)
+                {
+                    *maxspeed = ramp;
+                }
+            }
+        }
+    }
+}